@@ -0,0 +1,133 @@
+#include <benchmarks.h>
+
+/**
+ * @brief Milliseconds since tic.
+ *
+ */
+double elapsed(std::chrono::high_resolution_clock::time_point tic)
+{
+    auto toc = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(toc-tic).count();
+}
+
+/**
+ * @brief Time a full bond search and an incremental update.
+ *
+ */
+void benchmarkBonds(AtomStore & atoms, double & rebuild, double & update)
+{
+    VerletBondList bondList(bondCutOff);
+    auto tic = std::chrono::high_resolution_clock::now();
+    bondList.update(atoms);
+    rebuild = elapsed(tic);
+    tic = std::chrono::high_resolution_clock::now();
+    bondList.update(atoms);
+    update = elapsed(tic);
+}
+
+/**
+ * @brief Time drawing atoms and bonds.
+ *
+ * @remark With sprites impostors are always drawn as point sprites.
+ */
+double benchmarkDraw(jGL::DesktopDisplay & display, AtomStore & atoms, bool imposters, bool compact = false, bool sprites = false)
+{
+    Camera camera(atoms, resX, resY);
+    AtomRenderer atomRenderer(atoms, 0, camera.position(), BASE_MESH::ANY, compact);
+    if (sprites) { atomRenderer.setPointSprites(std::numeric_limits<float>::max()); }
+    atomRenderer.waitForMeshes();
+    std::vector<Bond> bonds = VerletBondList(bondCutOff).update(atoms);
+    BondRenderer bondRenderer(bonds, atoms, bonds.size(), compact);
+    bondRenderer.setBondScale(0.1f);
+
+    double total = 0.0;
+    for (unsigned f = 0; f < drawFrames && display.isOpen(); f++)
+    {
+        camera.rotate(0.01f);
+        atomRenderer.updateCamera(camera);
+        bondRenderer.updateCamera(camera);
+
+        jGLInstance->beginFrame();
+        jGLInstance->setClear(glm::vec4(1.0f));
+        jGLInstance->clear();
+
+        glFinish();
+        auto tic = std::chrono::high_resolution_clock::now();
+        atomRenderer.draw(imposters);
+        bondRenderer.draw();
+        glFinish();
+        total += elapsed(tic);
+
+        jGLInstance->endFrame();
+        display.loop();
+    }
+    return total/drawFrames;
+}
+
+int main(int argv, char ** argc)
+{
+    uint64_t count = 1000000;
+    if (argv > 1) { count = std::stoull(argc[1]); }
+
+    jGL::DesktopDisplay::Config conf;
+    conf.VULKAN = false;
+    #ifdef MACOS
+    conf.COCOA_RETINA = true;
+    #endif
+    jGL::DesktopDisplay display(glm::ivec2(resX, resY), "SimpleFastAtomicVisualiser - Benchmarks", conf);
+    display.setFrameLimit(0);
+    std::vector<std::byte> vicon(icon.begin(), icon.end());
+    display.setIcon({vicon});
+
+    glewInit();
+
+    jGLInstance = std::move(std::make_unique<jGL::GL::OpenGLInstance>(glm::ivec2(resX,resY)));
+
+    std::string device = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+    // Uniformly random atoms, a stand in for file order.
+    std::mt19937 rng(31415);
+    float length = std::cbrt(count/density);
+    std::uniform_real_distribution<float> u(0.0f, length);
+    AtomStore fileOrder;
+    fileOrder.resize(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        fileOrder.setPosition(i, glm::vec3(u(rng), u(rng), u(rng)));
+    }
+    Palette palette;
+    palette.setRadius(Element::Unknown, 0.5f);
+    fileOrder.setPalette(palette);
+    center(fileOrder);
+
+    auto tic = std::chrono::high_resolution_clock::now();
+    std::vector<uint64_t> order = mortonOrder(fileOrder);
+    AtomStore mortonOrdered = fileOrder;
+    mortonOrdered.permute(order);
+    double reorder = elapsed(tic);
+
+    std::cout << "Atoms: " << count << ", " << device << "\n"
+              << "Morton reorder: " << reorder << " ms\n\n"
+              << "| Order | Bond search (ms) | Bond update (ms) | Impostor draw (ms) | Mesh draw (ms) | Compact impostor draw (ms) | Point sprite draw (ms) |\n"
+              << "| :---- | :---- | :---- | :---- | :---- | :---- | :---- |\n";
+
+    for (auto ordered : {std::pair("File", &fileOrder), std::pair("Morton", &mortonOrdered)})
+    {
+        double rebuild, update;
+        benchmarkBonds(*ordered.second, rebuild, update);
+        double impostors = benchmarkDraw(display, *ordered.second, true);
+        double meshes = benchmarkDraw(display, *ordered.second, false);
+        double compact = benchmarkDraw(display, *ordered.second, true, true);
+        double sprites = benchmarkDraw(display, *ordered.second, true, false, true);
+        std::cout << "| " << ordered.first
+                  << " | " << rebuild
+                  << " | " << update
+                  << " | " << impostors
+                  << " | " << meshes
+                  << " | " << compact
+                  << " | " << sprites << " |\n";
+    }
+
+    jGLInstance->finish();
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <sstream>
+#include <chrono>
+#include <random>
+
+#include <jGL/jGL.h>
+#include <jGL/OpenGL/openGLInstance.h>
+#include <jGL/Display/desktopDisplay.h>
+#include <jGL/orthoCam.h>
+
+#include <icon.h>
+
+#include <atom.h>
+#include <atomRenderer.h>
+#include <bondRenderer.h>
+#include <bond.h>
+#include <morton.h>
+#include <camera.h>
+#include <util.h>
+
+const unsigned int resX = 1024;
+const unsigned int resY = resX;
+
+const float bondCutOff = 1.5f;
+const float density = 0.1f;
+const unsigned int drawFrames = 120;
+
+std::unique_ptr<jGL::jGLInstance> jGLInstance;
+
+#endif /* BENCHMARKS_H */
@@ -6,11 +6,17 @@
 #include <set>
 #include <vector>
 #include <map>
+#include <string>
+#include <limits>
+#include <initializer_list>
+#include <cmath>
 
 #include <glm/glm.hpp>
 
 #include <element.h>
 #include <colour.h>
+#include <palette.h>
+#include <parallel.h>
 
 /**
  * @brief An atom structure.
@@ -98,74 +104,382 @@ std::ostream & operator <<(std::ostream & o, Atom & atom)
 }
 
 /**
- * @brief Calculate the centre of mass.
+ * @brief Atom data stored as columns (structure of arrays).
  *
- * @param atoms the Atom list to centre.
- * @return glm::vec3 the Atoms centers of mass.
+ * @remark Positions, elements, and alphas are always stored.
+ * Velocities, forces, and named per-atom properties are only allocated
+ * when added, e.g. by a parser whose file provides them.
+ * @remark Colours and scales are not stored per atom, they are looked up
+ * by Element in the AtomStore's Palette.
+ * @remark Indexing returns an Atom by value, use the setters or the
+ * column accessors to modify.
  */
-glm::vec3 getCenter(const std::vector<Atom> & atoms)
+class AtomStore
 {
-    glm::vec3 com = glm::vec3(0);
-    for (const auto & atom : atoms)
+public:
+
+    AtomStore() = default;
+
+    /**
+     * @brief Construct a new AtomStore from a list of Atoms.
+     *
+     * @param atoms the Atoms to store.
+     */
+    AtomStore(const std::vector<Atom> & atoms)
+    {
+        reserve(atoms.size());
+        for (const Atom & atom : atoms) { push_back(atom); }
+    }
+
+    /**
+     * @brief Construct a new AtomStore from a list of Atoms.
+     *
+     * @param atoms the Atoms to store.
+     */
+    AtomStore(std::initializer_list<Atom> atoms)
+    : AtomStore(std::vector<Atom>(atoms))
+    {}
+
+    /**
+     * @brief The number of Atoms stored.
+     *
+     * @return uint64_t the Atom count.
+     */
+    uint64_t size() const { return x.size(); }
+
+    bool empty() const { return x.empty(); }
+
+    /**
+     * @brief Resize all allocated columns.
+     *
+     * @param n the new Atom count.
+     */
+    void resize(uint64_t n)
+    {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        elements.resize(n, Element::Unknown);
+        alphas.resize(n, 255);
+        if (hasVelocities()) { velocities.resize(n, glm::vec3(0)); }
+        if (hasForces()) { forces.resize(n, glm::vec3(0)); }
+        for (auto & property : properties) { property.second.resize(n, 0.0f); }
+    }
+
+    void reserve(uint64_t n)
+    {
+        x.reserve(n);
+        y.reserve(n);
+        z.reserve(n);
+        elements.reserve(n);
+        alphas.reserve(n);
+    }
+
+    /**
+     * @brief Append an Atom.
+     *
+     * @param atom the Atom to append.
+     */
+    void push_back(const Atom & atom)
+    {
+        resize(size()+1);
+        set(size()-1, atom);
+    }
+
+    /**
+     * @brief Get the i'th Atom.
+     *
+     * @param i the Atom index.
+     * @return Atom a copy of the Atom's data, velocity and force
+     * are zero if not stored.
+     */
+    Atom operator[](uint64_t i) const
+    {
+        return Atom
+        (
+            elements[i],
+            position(i),
+            scale(i),
+            colour(i),
+            velocity(i),
+            force(i)
+        );
+    }
+
+    /**
+     * @brief Set the i'th Atom.
+     *
+     * @remark Velocity and force are only kept if their columns exist.
+     * @remark The Atom's scale and colour RGB are not kept, they are given
+     * by the Palette. The colour's alpha is kept.
+     * @param i the Atom index.
+     * @param atom the Atom's data.
+     */
+    void set(uint64_t i, const Atom & atom)
+    {
+        elements[i] = atom.symbol;
+        setPosition(i, atom.position);
+        setAlpha(i, atom.colour.a);
+        if (hasVelocities()) { velocities[i] = atom.velocity; }
+        if (hasForces()) { forces[i] = atom.force; }
+    }
+
+    glm::vec3 position(uint64_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+
+    void setPosition(uint64_t i, glm::vec3 r) { x[i] = r.x; y[i] = r.y; z[i] = r.z; }
+
+    float scale(uint64_t i) const { return palette.radius(elements[i]); }
+
+    /**
+     * @brief The i'th Atom's colour.
+     *
+     * @param i the Atom index.
+     * @return glm::vec4 the Palette colour with alpha multiplied by the Atom's.
+     */
+    glm::vec4 colour(uint64_t i) const
+    {
+        glm::vec4 c = palette.colour(elements[i]);
+        c.a *= alpha(i);
+        return c;
+    }
+
+    Element element(uint64_t i) const { return elements[i]; }
+
+    void setElement(uint64_t i, Element e) { elements[i] = e; }
+
+    float alpha(uint64_t i) const { return alphas[i]/255.0f; }
+
+    /**
+     * @brief Set the i'th Atom's alpha.
+     *
+     * @param i the Atom index.
+     * @param a the alpha in [0, 1], stored with 8 bits.
+     */
+    void setAlpha(uint64_t i, float a) { alphas[i] = uint8_t(std::round(glm::clamp(a, 0.0f, 1.0f)*255.0f)); }
+
+    glm::vec3 velocity(uint64_t i) const { return hasVelocities() ? velocities[i] : glm::vec3(0); }
+
+    glm::vec3 force(uint64_t i) const { return hasForces() ? forces[i] : glm::vec3(0); }
+
+    /**
+     * @brief Allocate the velocity column.
+     *
+     */
+    void addVelocities() { velocities.resize(size(), glm::vec3(0)); hasVelocity = true; }
+
+    /**
+     * @brief Allocate the force column.
+     *
+     */
+    void addForces() { forces.resize(size(), glm::vec3(0)); hasForce = true; }
+
+    bool hasVelocities() const { return hasVelocity; }
+
+    bool hasForces() const { return hasForce; }
+
+    /**
+     * @brief Allocate a named per-atom property column.
+     *
+     * @param name the property's name.
+     * @return std::vector<float>& the property column.
+     */
+    std::vector<float> & addProperty(std::string name)
     {
-        com += atom.position;
+        auto & column = properties[name];
+        column.resize(size(), 0.0f);
+        return column;
     }
-    return com / float(atoms.size());
+
+    bool hasProperty(std::string name) const { return properties.find(name) != properties.cend(); }
+
+    const std::vector<float> & getProperty(std::string name) const { return properties.at(name); }
+    std::vector<float> & getProperty(std::string name) { return properties.at(name); }
+
+    const std::vector<float> & getX() const { return x; }
+    const std::vector<float> & getY() const { return y; }
+    const std::vector<float> & getZ() const { return z; }
+    std::vector<float> & getX() { return x; }
+    std::vector<float> & getY() { return y; }
+    std::vector<float> & getZ() { return z; }
+
+    const std::vector<Element> & getElements() const { return elements; }
+
+    const std::vector<uint8_t> & getAlphas() const { return alphas; }
+
+    /**
+     * @brief Get the Palette giving colours and scales by Element.
+     *
+     * @return const Palette& the Palette.
+     */
+    const Palette & getPalette() const { return palette; }
+
+    void setPalette(const Palette & p) { palette = p; }
+
+    /**
+     * @brief Apply an order to the Atoms.
+     *
+     * @param order order[i] is the current index of the new i'th Atom.
+     */
+    void permute(const std::vector<uint64_t> & order)
+    {
+        permuteColumn(x, order);
+        permuteColumn(y, order);
+        permuteColumn(z, order);
+        permuteColumn(elements, order);
+        permuteColumn(alphas, order);
+        if (hasVelocities()) { permuteColumn(velocities, order); }
+        if (hasForces()) { permuteColumn(forces, order); }
+        for (auto & property : properties) { permuteColumn(property.second, order); }
+    }
+
+    /**
+     * @brief Iterate the Atoms by value.
+     *
+     */
+    class const_iterator
+    {
+    public:
+        const_iterator(const AtomStore & store, uint64_t i)
+        : store(store), i(i)
+        {}
+
+        Atom operator*() const { return store[i]; }
+        const_iterator & operator++() { i++; return *this; }
+        bool operator!=(const const_iterator & o) const { return i != o.i; }
+        bool operator==(const const_iterator & o) const { return i == o.i; }
+
+    private:
+        const AtomStore & store;
+        uint64_t i;
+    };
+
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator end() const { return const_iterator(*this, size()); }
+
+private:
+
+    std::vector<float> x, y, z;
+    std::vector<Element> elements;
+    std::vector<uint8_t> alphas;
+
+    Palette palette;
+
+    bool hasVelocity = false;
+    bool hasForce = false;
+    std::vector<glm::vec3> velocities;
+    std::vector<glm::vec3> forces;
+
+    std::map<std::string, std::vector<float>> properties;
+
+    template <class T>
+    void permuteColumn(std::vector<T> & column, const std::vector<uint64_t> & order)
+    {
+        std::vector<T> permuted(column.size());
+        for (uint64_t i = 0; i < order.size(); i++) { permuted[i] = column[order[i]]; }
+        column = std::move(permuted);
+    }
+};
+
+/**
+ * @brief Calculate the centre of mass.
+ *
+ * @remark A parallel reduction, summed in double precision.
+ * @param atoms the Atoms to centre.
+ * @return glm::vec3 the Atoms centers of mass.
+ */
+glm::vec3 getCenter(const AtomStore & atoms)
+{
+    const uint64_t n = atoms.size();
+    if (n == 0) { return glm::vec3(0); }
+    const std::vector<float> & x = atoms.getX();
+    const std::vector<float> & y = atoms.getY();
+    const std::vector<float> & z = atoms.getZ();
+    const unsigned threads = parallelThreads(n);
+    std::vector<glm::dvec3> sums(threads, glm::dvec3(0));
+    parallelFor
+    (
+        n,
+        threads,
+        [&](uint64_t begin, uint64_t end, unsigned t)
+        {
+            glm::dvec3 sum(0);
+            for (uint64_t i = begin; i < end; i++) { sum += glm::dvec3(x[i], y[i], z[i]); }
+            sums[t] = sum;
+        }
+    );
+    glm::dvec3 com(0);
+    for (const glm::dvec3 & sum : sums) { com += sum; }
+    return glm::vec3(com/double(n));
 }
 
 /**
- * @brief Subtract the centre of mass of some Atoms
+ * @brief Translate some Atoms.
  *
- * @param atoms the Atom list to centre.
+ * @param atoms the Atoms to translate.
+ * @param r the translation.
  */
-void center(std::vector<Atom> & atoms)
+void translate(AtomStore & atoms, glm::vec3 r)
 {
-    glm::vec3 com = getCenter(atoms);
-    for (auto & atom : atoms)
+    std::vector<float> * columns[3] = {&atoms.getX(), &atoms.getY(), &atoms.getZ()};
+    for (uint8_t i = 0; i < 3; i++)
     {
-        atom.position -= com;
+        for (float & ri : *columns[i]) { ri += r[i]; }
     }
 }
 
-void translate(std::vector<Atom> & atoms, glm::vec3 r)
+/**
+ * @brief Subtract the centre of mass of some Atoms
+ *
+ * @param atoms the Atoms to centre.
+ */
+void center(AtomStore & atoms)
 {
-    for (auto & atom : atoms) { atom.position += r; }
+    translate(atoms, -getCenter(atoms));
 }
 
 /**
- * @brief Calculate the extent of some Atoms
+ * @brief Calculate the bounding box of some Atoms.
  *
- * @param atoms the Atom list.
+ * @param atoms the Atoms.
+ * @param min the lower corner of the box.
+ * @param max the upper corner of the box.
  */
-glm::vec3 extent(const std::vector<Atom> & atoms)
+void bounds(const AtomStore & atoms, glm::vec3 & min, glm::vec3 & max)
 {
-    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
-    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
-    for (const auto & atom : atoms)
+    const std::vector<float> * r[3] = {&atoms.getX(), &atoms.getY(), &atoms.getZ()};
+    min = glm::vec3(std::numeric_limits<float>::max());
+    max = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint8_t i = 0; i < 3; i++)
     {
-        for (uint8_t i = 0; i < 3; i++)
+        for (float ri : *r[i])
         {
-            min[i] = std::min(min[i], atom.position[i]);
-            max[i] = std::max(max[i], atom.position[i]);
+            min[i] = std::min(min[i], ri);
+            max[i] = std::max(max[i], ri);
         }
     }
+}
+
+/**
+ * @brief Calculate the extent of some Atoms
+ *
+ * @param atoms the Atoms.
+ */
+glm::vec3 extent(const AtomStore & atoms)
+{
+    glm::vec3 min, max;
+    bounds(atoms, min, max);
     return max-min;
 }
 
 /**
- * @brief Determine the unique elements in a list of Atom.
+ * @brief Determine the unique elements in some Atoms.
  *
  * @param atoms the atoms to check.
  * @return std::set<Element> the set of elements.
  */
-std::set<Element> uniqueElements(const std::vector<Atom> & atoms)
+std::set<Element> uniqueElements(const AtomStore & atoms)
 {
-    std::set<Element> e;
-    for (const auto & atom : atoms)
-    {
-        e.insert(atom.symbol);
-    }
-    return e;
+    return std::set<Element>(atoms.getElements().cbegin(), atoms.getElements().cend());
 }
 
 /**
@@ -174,12 +488,12 @@ std::set<Element> uniqueElements(const std::vector<Atom> & atoms)
  * @param atoms the atoms to index.
  * @return std::multimap<Element, uint64_t> the indices of each element type.
  */
-std::multimap<Element, uint64_t> elementIndices(const std::vector<Atom> & atoms)
+std::multimap<Element, uint64_t> elementIndices(const AtomStore & atoms)
 {
     std::multimap<Element, uint64_t> m;
     for (uint64_t i = 0; i < atoms.size(); i++)
     {
-        m.insert(std::pair(atoms[i].symbol, i));
+        m.insert(std::pair(atoms.element(i), i));
     }
     return m;
 }
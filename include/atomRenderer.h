@@ -6,22 +6,49 @@
 #include <map>
 #include <utility>
 #include <algorithm>
+#include <cstring>
+#include <chrono>
 
 #include <jGL/OpenGL/gl.h>
 #include <jGL/OpenGL/Shader/glShader.h>
 
-#include <hierarchicalTriangularMesh.h>
+#include <sphereMesh.h>
 
 #include <glUtils.h>
+#include <streamBuffer.h>
+#include <quantise.h>
+#include <levelOfDetail.h>
+#include <depthSort.h>
+#include <parallel.h>
 #include <atom.h>
+#include <palette.h>
+#include <emphasis.h>
+#include <visibility.h>
+#include <transparency.h>
+#include <overdrawCounter.h>
+#include <frustum.h>
+#include <frustumCull.h>
+#include <octree.h>
 #include <camera.h>
 
 /**
  * @brief Render atoms as sphere meshes.
  *
  * @remark @see HierarchicalTriangularMesh.
- * @remark The level of detail can be automatically de-scaled with distance.
+ * @remark The level of detail can be chosen per atom by its projected
+ * size, drawing each level as its own instanced draw and distant atoms as
+ * impostors, @see setAdaptiveLevelOfDetail.
  * @remark The level of detail can be overriden.
+ * @remark Each atom uploads its position, Element id and alpha. Colours
+ * and radii are looked up by Element from a palette texture.
+ * @remark Element emphasis is a shader bitmask, @see Emphasis.
+ * @remark Hidden Atoms are compacted out of the upload, @see Visibility.
+ * @remark Compact buffers quantise positions to 16 bits in the bounding
+ * box of the Atoms, 8 bytes per atom rather than 14, @see Quantisation.
+ * @remark Atoms outside the Camera's Frustum can be culled before drawing,
+ * @see setFrustumCulling.
+ * @remark Distant regions of Atoms can be drawn as single aggregate
+ * spheres, cut from an Octree, @see setHierarchicalLevelOfDetail.
  */
 class AtomRenderer
 {
@@ -36,13 +63,17 @@ public:
      * @param levelOfDetail the level of detail.
      * @param cameraPosition the cartesian position of the camera.
      * @param mesh the base mesh type. @see BASE_MESH.
+     * @param compact quantise positions to 16 bits.
+     * @param capacity the most Atoms updateAtoms will draw, at least atoms.size().
      */
     AtomRenderer
     (
-        const std::vector<Atom> & atoms,
+        const AtomStore & atoms,
         uint8_t levelOfDetail = 0,
         glm::vec3 cameraPosition = glm::vec3(0),
-        BASE_MESH mesh = BASE_MESH::ANY
+        BASE_MESH mesh = BASE_MESH::ANY,
+        bool compact = false,
+        uint64_t capacity = 0
     )
     {
         meshShader = std::make_unique<jGL::GL::glShader>(meshVertexShader, meshFragmentShader);
@@ -56,64 +87,77 @@ public:
         meshShader->setUniform<glm::vec4>("lightColour", glm::vec4(1.0f,1.0f,1.0f,1.0f));
         meshShader->setUniform<float>("ambientLight", 0.1f);
 
-        if (mesh == BASE_MESH::ANY)
-        {
-            std::vector<HierarchicalTriangularMesh<float>> htms;
-
-            // Non-regular triangular faces not yet supported.
-            for (BASE_MESH m : {BASE_MESH::CUBE, BASE_MESH::DODECAHEDRON})
-            {
-                HierarchicalTriangularMesh<float> htm(m);
-                htm.build(0);
-                htms.push_back(htm);
-            }
-
-            for (BASE_MESH m : {BASE_MESH::TETRAHEDRON, BASE_MESH::OCTAHEDRON, BASE_MESH::ICOSAHEDRON})
-            {
-                for (uint8_t i = 0; i < 7; i++)
-                {
-                    HierarchicalTriangularMesh<float> htm(m);
-                    htm.build(i);
-                    htms.push_back(htm);
-                }
-            }
-
-            std::sort(htms.begin(), htms.end());
-
-            for (uint8_t i = 0; i < htms.size(); i++)
-            {
-                meshes.insert({i, {htms[i].vertices(), htms[i].vertexNormals()}});
-                triangleCounts.push_back(htms[i].triangles());
-            }
-        }
-        else
-        {
-            for (uint8_t i = 0; i < 7; i++)
-            {
-                HierarchicalTriangularMesh<float> htm(mesh);
-                htm.build(i);
-                meshes.insert({i, {htm.vertices(), htm.vertexNormals()}});
-                triangleCounts.push_back(htm.triangles());
-            }
-        }
+        // Meshes are built in the background when first drawn, @see requestSphereMesh.
+        levels = sphereMeshLevels(mesh);
+        for (const SphereMeshLevel & level : levels) { triangleCounts.push_back(level.triangles); }
 
         buffer = std::make_unique<AtomBuffer>
         (
-            meshes,
-            atoms.size(),
-            levelOfDetail
+            levels,
+            std::max(uint64_t(atoms.size()), capacity),
+            levelOfDetail,
+            compact
         );
 
+        lod = LevelOfDetail(triangleCounts);
         setLevelOfDetail(levelOfDetail);
         this->cameraPosition = cameraPosition;
-        cameraDistances.resize(atoms.size());
+
+        glGenTextures(1, &paletteTexture);
+        setPalette(atoms.getPalette());
 
         updateAtoms(atoms);
         setAtomScale(1.0f);
+        setModel(glm::mat4(1.0f));
+        setEmphasis(Emphasis());
+        setTransparencyPass(TransparencyPass::BLENDED);
+        imposterShader->use();
+        imposterShader->setUniform<int>("depthOnly", 0);
+        imposterShader->setUniform<int>("aggregates", 0);
+        imposterShader->setUniform<int>("points", 0);
+        imposterShader->setUniform<float>("pointScale", 1.0f);
 
         jGL::GL::glError("AtomRenderer::AtomRenderer");
     }
 
+    ~AtomRenderer()
+    {
+        glDeleteTextures(1, &paletteTexture);
+    }
+
+    /**
+     * @brief Upload Element colours and radii.
+     *
+     * @remark Row 0 of the palette texture is the colour of each Element,
+     * row 1 has the radius in red.
+     * @param palette the new Palette.
+     */
+    void setPalette(const Palette & palette)
+    {
+        std::vector<float> texels(ELEMENT_COUNT*4*2, 0.0f);
+        for (uint16_t e = 0; e < ELEMENT_COUNT; e++)
+        {
+            glm::vec4 c = palette.getColours()[e];
+            texels[4*e] = c.r;
+            texels[4*e+1] = c.g;
+            texels[4*e+2] = c.b;
+            texels[4*e+3] = c.a;
+            texels[4*(ELEMENT_COUNT+e)] = palette.getRadii()[e];
+            radii[e] = palette.getRadii()[e];
+        }
+        orderNeedsUpdate = true;
+        octreeNeedsUpdate = true;
+        cullNeedsUpdate = true;
+        spritesNeedUpdate = true;
+        glBindTexture(GL_TEXTURE_2D, paletteTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, ELEMENT_COUNT, 2, 0, GL_RGBA, GL_FLOAT, texels.data());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
     /**
      * @brief The number of triangles drawn.
      *
@@ -123,14 +167,25 @@ public:
     uint32_t triangles(bool impostor = true) const
     {
         uint64_t triangles = 0;
+        // Point sprites are not triangles.
+        const uint64_t quad = sprites ? 0 : 2;
         if (impostor)
         {
-            triangles += buffer->atomCount()*2;
+            triangles += visibleCount()*quad;
+        }
+        else if (adaptive)
+        {
+            for (uint8_t b = 0; b < lod.impostor(); b++)
+            {
+                triangles += (bucketOffsets[b+1]-bucketOffsets[b])*triangleCounts[b];
+            }
+            triangles += (bucketOffsets[lod.impostor()+1]-bucketOffsets[lod.impostor()])*quad;
         }
         else
         {
-            triangles += buffer->atomCount()*triangleCounts[levelOfDetail];
+            triangles += visibleCount()*triangleCounts[levelOfDetail];
         }
+        triangles += aggregateCount()*2;
         return triangles;
     }
 
@@ -139,7 +194,212 @@ public:
      *
      * @param lod the new level of detail.
      */
-    void setLevelOfDetail(uint8_t lod){ levelOfDetail = std::min(lod, uint8_t(meshes.size()-1)); }
+    void setLevelOfDetail(uint8_t lod)
+    {
+        levelOfDetail = std::min(lod, uint8_t(levels.size()-1));
+        buffer->setLevelOfDetail(levelOfDetail);
+    }
+
+    /**
+     * @brief Wait for the meshes that may be drawn to be built and uploaded.
+     *
+     * @remark Meshes otherwise build in the background, coarser meshes are
+     * drawn until they are ready.
+     */
+    void waitForMeshes()
+    {
+        for (uint8_t l = 0; l < levels.size(); l++)
+        {
+            if (l == levelOfDetail || adaptive) { buffer->waitFor(l); }
+        }
+    }
+
+    /**
+     * @brief Choose the level of detail per Atom when drawing meshes.
+     *
+     * @remark Atoms are bucketed by projected radius each time the Camera
+     * or Atoms change, @see LevelOfDetail. Near atoms use fine meshes,
+     * far atoms coarse meshes or impostors.
+     * @remark Replaces the global level of detail for mesh draws.
+     * @param enabled whether to bucket Atoms.
+     */
+    void setAdaptiveLevelOfDetail(bool enabled)
+    {
+        adaptive = enabled;
+        orderNeedsUpdate = true;
+        if (reordered()) { reorder(); }
+        else { upload(); }
+    }
+
+    /**
+     * @brief Draw Atoms sorted by distance from the camera.
+     *
+     * @remark Atoms are sorted in parallel each time the Camera or Atoms
+     * move, reusing the last order, @see DepthSort. When adaptive Atoms are
+     * sorted within each level of detail bucket.
+     * @param order FRONT_TO_BACK for opaque Atoms, BACK_TO_FRONT to blend
+     * translucent Atoms exactly, or NONE.
+     */
+    void setDepthOrder(DepthOrder order)
+    {
+        depthOrder = order;
+        orderNeedsUpdate = true;
+        if (reordered()) { reorder(); }
+        else { upload(); }
+    }
+
+    DepthOrder getDepthOrder() const { return depthOrder; }
+
+    /**
+     * @brief Only draw Atoms whose bounding spheres meet the Camera's Frustum.
+     *
+     * @remark With compute shaders the uploaded Atoms are culled on the GPU
+     * and drawn indirectly, @see FrustumCull. Otherwise, or when adaptive,
+     * Atoms are culled on the CPU as they are ordered, each time the Camera
+     * or Atoms move.
+     * @remark Either way only Atoms in view reach the vertex shader.
+     * @param enabled whether to cull.
+     */
+    void setFrustumCulling(bool enabled)
+    {
+        culling = enabled;
+        computeCulling = enabled && computeShadersAvailable();
+        orderNeedsUpdate = true;
+        cullNeedsUpdate = true;
+        spritesNeedUpdate = true;
+        if (reordered()) { reorder(); }
+        else { upload(); }
+    }
+
+    /**
+     * @brief Draw distant regions of Atoms as single aggregate spheres.
+     *
+     * @remark An Octree over the shown Atoms is cut each time the Camera
+     * or Atoms move, @see Octree::select. Regions projecting to at most
+     * pixels in radius are drawn as one impostor of their mean position,
+     * dominant Element and fused radius, nearer regions as their Atoms.
+     * Regions outside the Camera's Frustum are not drawn.
+     * @remark Only the cut is uploaded, so detail is streamed to the GPU
+     * as the Camera approaches. Translucent aggregates are not depth sorted.
+     * @param pixels the largest projected radius of an aggregate, 0 draws
+     * every Atom.
+     */
+    void setHierarchicalLevelOfDetail(float pixels)
+    {
+        aggregatePixels = std::max(pixels, 0.0f);
+        orderNeedsUpdate = true;
+        cullNeedsUpdate = true;
+        spritesNeedUpdate = true;
+        if (aggregatePixels == 0.0f)
+        {
+            octree = Octree();
+            aggregateNodes.clear();
+            buffer->updateAggregates({});
+        }
+        else { octreeNeedsUpdate = true; }
+        if (reordered()) { reorder(); }
+        else { upload(); }
+    }
+
+    /**
+     * @brief The number of aggregates drawn.
+     *
+     * @return uint64_t the aggregate spheres, 0 unless hierarchical.
+     */
+    uint64_t aggregateCount() const { return buffer->aggregateCount(); }
+
+    /**
+     * @brief Draw impostors as point sprites when Atoms are small on screen.
+     *
+     * @remark A point sprite is one vertex, sized to the Atom's projected
+     * quad, and shaded by the same ray-sphere intersection as a quad. For
+     * many tiny Atoms this saves three vertices per Atom and the overdraw
+     * of the inflated quads' corners.
+     * @remark Points are drawn when the mean projected radius of a sample
+     * of Atoms is under pixels, checked when the Camera or Atoms change.
+     * Points are clipped by their centre, and to the largest point size,
+     * so near or edge Atoms drawn as points may be cut, which is why large
+     * Atoms use quads.
+     * @remark Meshes and aggregates are unaffected.
+     * @param pixels the mean projected radius under which to draw points,
+     * 0 always draws quads.
+     */
+    void setPointSprites(float pixels)
+    {
+        spritePixels = std::max(pixels, 0.0f);
+        spritesNeedUpdate = true;
+        if (spritePixels == 0.0f) { drawPoints(false); }
+    }
+
+    /**
+     * @brief Whether impostors are drawn as point sprites.
+     *
+     * @return true if the last draw used point sprites.
+     */
+    bool pointSprites() const { return sprites; }
+
+    /**
+     * @brief The mean projected radius of a sample of the Atoms.
+     *
+     * @remark At most SPRITE_SAMPLES Atoms, evenly spaced by index, are
+     * sampled.
+     * @return float the mean radius in pixels.
+     */
+    float meanProjectedRadius() const
+    {
+        const uint64_t n = buffer->atomCount();
+        if (n == 0) { return 0.0f; }
+        const uint64_t stride = (n+SPRITE_SAMPLES-1)/SPRITE_SAMPLES;
+        const glm::vec3 eye = glm::vec3(glm::inverse(model)*glm::vec4(cameraPosition, 1.0f));
+        double sum = 0.0;
+        uint64_t samples = 0;
+        for (uint64_t i = 0; i < n; i += stride)
+        {
+            const float radius = radii[buffer->element(i)]*scaling;
+            const float distance = std::max(glm::length(buffer->position(i)-eye), radius);
+            if (distance > 0.0f) { sum += radius*pixelScale/distance; }
+            samples++;
+        }
+        return float(sum/samples);
+    }
+
+    /**
+     * @brief Set which Atoms are drawn.
+     *
+     * @remark The shown Atoms are compacted in parallel and uploaded, hidden
+     * Atoms are not drawn at all.
+     * @param v the Visibility.
+     */
+    void setVisibility(const Visibility & v)
+    {
+        visibility = v;
+        filtered = visibility.hidesAny();
+        compactVisible();
+        orderNeedsUpdate = true;
+        octreeNeedsUpdate = true;
+        if (reordered()) { reorder(); }
+        else { upload(); }
+    }
+
+    /**
+     * @brief The number of Atoms drawn.
+     *
+     * @remark When culled on the GPU the count is a frame behind.
+     * @return uint64_t the shown Atoms.
+     */
+    uint64_t visibleCount() const { return gpuCulling() ? buffer->culledCount() : buffer->drawCount(); }
+
+    /**
+     * @brief The number of Atoms in a level of detail bucket.
+     *
+     * @param level the level, maxLevelOfDetail()+1 for impostors.
+     * @return uint64_t the Atoms in the bucket when adaptive, else 0.
+     */
+    uint64_t bucketCount(uint8_t level) const
+    {
+        if (!adaptive || level > lod.impostor()) { return 0; }
+        return bucketOffsets[level+1]-bucketOffsets[level];
+    }
 
     /**
      * @brief Get the current level of detail.
@@ -153,7 +413,7 @@ public:
      *
      * @return uint8_t the maximum level of detail.
      */
-    uint8_t maxLevelOfDetail() const { return meshes.size()-1; }
+    uint8_t maxLevelOfDetail() const { return levels.size()-1; }
 
     /**
      * @brief Update buffers with new Atom data.
@@ -161,32 +421,109 @@ public:
      * @remark will upload data to the GPU.
      * @param atoms the new Atom data to upload.
      */
-    void updateAtoms(const std::vector<Atom> & atoms)
+    void updateAtoms(const AtomStore & atoms)
     {
         buffer->flip();
         buffer->insert(atoms);
-        buffer->updateVertexArray();
+        setQuantisation(buffer->getQuantisation());
+        compactVisible();
+        octreeNeedsUpdate = true;
+        if (reordered())
+        {
+            orderNeedsUpdate = true;
+            reorder();
+        }
+        else
+        {
+            upload();
+        }
     }
 
     /**
      * @brief Draw the current Atoms
      *
+     * @remark With a depth pre-pass impostor depths are drawn first, then
+     * only fragments at the nearest depth are shaded, @see setDepthPrepass.
      *  @param imposters draw with impostor spheres inplace of meshes.
      */
     void draw(bool imposters = true)
     {
-        if (imposters)
+        if (spritePixels > 0.0f && spritesNeedUpdate)
+        {
+            drawPoints(meanProjectedRadius() < spritePixels);
+            spritesNeedUpdate = false;
+        }
+        if (gpuCulling() && cullNeedsUpdate)
+        {
+            buffer->cull(Frustum(orderedPV*model), paletteTexture, scaling);
+            cullNeedsUpdate = false;
+        }
+        else if (gpuCulling()) { buffer->readCulledCount(); }
+        transparencyState(pass);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, paletteTexture);
+        // Translucent fragments neither write nor need depth.
+        const bool opaquePass = pass != TransparencyPass::WEIGHTED;
+        const bool prepass = depthPrepass && opaquePass && (imposters || adaptive);
+        const bool bucketed = !imposters && adaptive;
+        const uint64_t impostorFirst = bucketed ? bucketOffsets[lod.impostor()] : 0;
+        const uint64_t impostorCount = bucketed ? bucketOffsets[lod.impostor()+1]-impostorFirst : buffer->drawCount();
+        if (prepass)
         {
             imposterShader->use();
+            imposterShader->setUniform<int>("depthOnly", 1);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            if (gpuCulling()) { buffer->drawCulled(true); }
+            else { buffer->drawImpostors(impostorFirst, impostorCount); }
+            drawAggregates();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            imposterShader->setUniform<int>("depthOnly", 0);
+            glDepthFunc(GL_LEQUAL);
+        }
+        if (overdraw != nullptr && opaquePass) { overdraw->begin(); }
+        if (prepass && pass == TransparencyPass::BLENDED)
+        {
+            // Opaque Atoms first, translucent Atoms drawn before them
+            // would otherwise hide them.
+            for (TransparencyPass p : {TransparencyPass::SOLID, TransparencyPass::TRANSLUCENT})
+            {
+                transparencyPassUniform(p);
+                transparencyState(p);
+                drawLit(imposters, impostorFirst, impostorCount);
+            }
+            transparencyPassUniform(pass);
         }
         else
         {
-            meshShader->use();
+            drawLit(imposters, impostorFirst, impostorCount);
         }
-        buffer->draw(imposters);
+        if (overdraw != nullptr && opaquePass) { overdraw->end(); }
+        glDepthFunc(GL_LESS);
+        glDisable(GL_PROGRAM_POINT_SIZE);
         jGL::GL::glError("AtomRenderer::draw");
     }
 
+    /**
+     * @brief Draw impostor depths before shading them.
+     *
+     * @remark Impostors write their depth, so fragments behind drawn Atoms
+     * are still shaded. A depth only pass first finds the nearest opaque
+     * depth of each pixel, the lighting pass then shades about one fragment
+     * per pixel. Impostor depth is declared never less than the quad's
+     * (ARB_conservative_depth), so hidden fragments can be rejected before
+     * shading.
+     * @param enabled whether to draw a depth pre-pass.
+     */
+    void setDepthPrepass(bool enabled) { depthPrepass = enabled; }
+
+    /**
+     * @brief Count the samples written when drawing opaque Atoms.
+     *
+     * @remark The depth pre-pass is not counted.
+     * @param counter the OverdrawCounter, or nullptr to stop counting.
+     */
+    void countOverdraw(OverdrawCounter * counter) { overdraw = counter; }
+
     /**
      * @brief Set the view matrix.
      *
@@ -240,6 +577,72 @@ public:
         imposterShader->setUniform<glm::vec4>("lightPos", glm::vec4(cameraPosition, 1.0f));
         setView(camera.getView());
         setProjection(camera.getProjection());
+        float scale = camera.getProjection()[1][1]*camera.getResY()*0.5f;
+        imposterShader->setUniform<float>("pointScale", scale);
+        if (pixelScale != scale || orderedPV != camera.getPV())
+        {
+            if (reordered()) { orderNeedsUpdate = true; }
+            cullNeedsUpdate = true;
+            spritesNeedUpdate = true;
+        }
+        pixelScale = scale;
+        orderedPV = camera.getPV();
+        if (reordered()) { reorder(); }
+    }
+
+    /**
+     * @brief Set the model matrix, placing the Atoms in the scene.
+     *
+     * @remark Moving or centring the Atoms this way uploads no Atom data.
+     * @param m the model matrix.
+     */
+    void setModel(glm::mat4 m)
+    {
+        meshShader->use();
+        meshShader->setUniform<glm::mat4>("model", m);
+        imposterShader->use();
+        imposterShader->setUniform<glm::mat4>("model", m);
+        if (model != m)
+        {
+            model = m;
+            orderNeedsUpdate = true;
+            cullNeedsUpdate = true;
+            spritesNeedUpdate = true;
+            if (reordered()) { reorder(); }
+        }
+    }
+
+    /**
+     * @brief Set which Elements are emphasised.
+     *
+     * @remark Sets uniforms only, no Atom data is uploaded.
+     * @param emphasis the Element emphasis.
+     */
+    void setEmphasis(const Emphasis & emphasis)
+    {
+        for (jGL::GL::glShader * shader : {meshShader.get(), imposterShader.get()})
+        {
+            shader->use();
+            for (uint8_t w = 0; w < EMPHASIS_WORDS; w++)
+            {
+                shader->setUniform<int>("deemphasised"+std::to_string(w), int(emphasis.getMask()[w]));
+            }
+            shader->setUniform<float>("deemphasisAlpha", emphasis.getDeemphasisAlpha());
+        }
+    }
+
+    /**
+     * @brief Set which fragments are drawn, and how.
+     *
+     * @remark With SOLID and WEIGHTED passes opaque Atoms are drawn without
+     * blending and translucent Atoms accumulated order independently,
+     * @see WeightedBlendedOIT.
+     * @param p the TransparencyPass.
+     */
+    void setTransparencyPass(TransparencyPass p)
+    {
+        transparencyPassUniform(p);
+        pass = p;
     }
 
     /**
@@ -253,43 +656,89 @@ public:
         meshShader->setUniform<float>("scaling", s);
         imposterShader->use();
         imposterShader->setUniform<float>("scaling", s);
+        if (scaling != s) { orderNeedsUpdate = true; cullNeedsUpdate = true; spritesNeedUpdate = true; }
+        scaling = s;
     }
 
 private:
 
     std::unique_ptr<jGL::GL::glShader> meshShader, imposterShader;
+    GLuint paletteTexture;
     glm::vec3 cameraPosition;
     uint8_t levelOfDetail;
 
-    struct SphereMesh { std::vector<float> vertices; std::vector<float> normals; };
-
-    std::map<uint8_t, SphereMesh> meshes;
+    std::vector<SphereMeshLevel> levels;
 
     uint64_t atomCount = 0;
     std::vector<uint32_t> triangleCounts;
 
     std::vector<float> cameraDistances;
 
+    bool adaptive = false;
+    bool orderNeedsUpdate = true;
+    bool culling = false;
+    bool computeCulling = false;
+    bool cullNeedsUpdate = true;
+    std::vector<uint64_t> inView;
+
+    Octree octree;
+    bool octreeNeedsUpdate = true;
+    float aggregatePixels = 0.0f;
+    std::vector<uint64_t> aggregateNodes;
+
+    static const uint64_t SPRITE_SAMPLES = 1024;
+    float spritePixels = 0.0f;
+    bool sprites = false;
+    bool spritesNeedUpdate = true;
+
+    Visibility visibility;
+    bool filtered = false;
+    std::vector<uint64_t> visible;
+    LevelOfDetail lod = LevelOfDetail({});
+    std::array<float, ELEMENT_COUNT> radii;
+    float scaling = 1.0f;
+    float pixelScale = 1.0f;
+    glm::mat4 orderedPV = glm::mat4(0.0f);
+    std::vector<uint8_t> buckets, depthBuckets;
+    DepthOrder depthOrder = DepthOrder::NONE;
+    DepthSort depthSort;
+    std::vector<uint64_t> drawOrder;
+    std::vector<uint64_t> bucketOffsets;
+
     glm::mat4 view, projection;
+    glm::mat4 model = glm::mat4(1.0f);
+    TransparencyPass pass = TransparencyPass::BLENDED;
+    bool depthPrepass = false;
+    OverdrawCounter * overdraw = nullptr;
 
     const char * meshVertexShader =
         "#version " GLSL_VERSION "\n"
         "precision lowp float; precision lowp int;\n"
         "layout(location=0) in vec3 a_vertices;\n"
         "layout(location=1) in vec3 a_normals;\n"
-        "layout(location=2) in vec4 a_positionsAndScales;\n"
-        "layout(location=3) in vec4 a_colours;\n"
+        "layout(location=2) in vec3 a_positions;\n"
+        "layout(location=3) in vec2 a_ids;\n"
         "uniform mat4 proj;\n"
+        "uniform mat4 model;\n"
         "uniform float scaling;\n"
+        "uniform sampler2D palette;\n"
+        "uniform vec4 positionOrigin;\n"
+        "uniform vec4 positionExtent;\n"
         "out vec4 o_colour;\n"
         "out vec3 o_normal;\n"
         "out vec3 fragPos;\n"
-        ""
+        EMPHASIS_GLSL
+        TRANSPARENCY_VERTEX_GLSL
         "void main()\n"
         "{\n"
-        "    fragPos = vec3(a_vertices*a_positionsAndScales.w*scaling+a_positionsAndScales.xyz);\n"
+        "    int element = int(a_ids.x);\n"
+        "    vec3 position = (model*vec4(positionOrigin.xyz+positionExtent.xyz*a_positions, 1.0)).xyz;\n"
+        "    float radius = texelFetch(palette, ivec2(element, 1), 0).r;\n"
+        "    fragPos = vec3(a_vertices*radius*scaling+position);\n"
         "    gl_Position = proj*vec4(fragPos.xyz, 1.0);\n"
-        "    o_colour = a_colours;\n"
+        "    o_colour = texelFetch(palette, ivec2(element, 0), 0);\n"
+        "    o_colour.a *= emphasis(element)*a_ids.y/255.0;\n"
+        "    if (passCulls(o_colour.a)) { gl_Position = vec4(0.0, 0.0, 2.0, 1.0); }\n"
         "    o_normal = a_normals;\n"
         "}";
 
@@ -302,51 +751,76 @@ private:
         "in vec4 o_colour;\n"
         "in vec3 o_normal;\n"
         "in vec3 fragPos;\n"
-        "out vec4 colour;\n"
+        TRANSPARENCY_FRAGMENT_GLSL
         "void main()\n"
         "{\n"
         "    vec3 lightDir = normalize(lightPos.xyz - fragPos);\n"
         "    float diff = max(dot(normalize(o_normal), lightDir), 0.0);\n"
-        "    colour = vec4((ambientLight + diff)*lightColour.rgb * o_colour.rgb, o_colour.a);\n"
+        "    writeColour(vec4((ambientLight + diff)*lightColour.rgb * o_colour.rgb, o_colour.a));\n"
         "}";
 
     const char * imposterVertexShader =
         "#version " GLSL_VERSION "\n"
         "precision lowp float; precision lowp int;\n"
         "layout(location=0) in vec2 a_vertices;\n"
-        "layout(location=1) in vec4 a_positionsAndScales;\n"
-        "layout(location=2) in vec4 a_colours;\n"
+        "layout(location=1) in vec3 a_positions;\n"
+        "layout(location=2) in vec2 a_ids;\n"
+        "layout(location=3) in float a_radius;\n"
         "out vec2 billboard;\n"
         "uniform mat4 view;\n"
         "uniform mat4 proj;\n"
+        "uniform mat4 model;\n"
         "uniform float clipCorrection;\n"
         "uniform float scaling;\n"
+        "uniform sampler2D palette;\n"
+        "uniform vec4 positionOrigin;\n"
+        "uniform vec4 positionExtent;\n"
+        "uniform int aggregates;\n"
+        "uniform int points;\n"
+        "uniform float pointScale;\n"
         "out vec4 atomPosScale;\n"
         "out vec3 atomViewPos;\n"
         "out vec4 o_colour;\n"
+        EMPHASIS_GLSL
+        TRANSPARENCY_VERTEX_GLSL
         "void main()\n"
         "{\n"
-        "    billboard = a_vertices * clipCorrection;\n"
-        "    atomViewPos = (view * vec4(a_positionsAndScales.xyz, 1.0)).xyz;"
-        "    gl_Position = proj * (vec4(atomViewPos, 1.0)+vec4(scaling*a_positionsAndScales.w * a_vertices * clipCorrection, 0.0, 1.0));"
-        "    atomPosScale = a_positionsAndScales;\n"
-        "    atomPosScale.w *= scaling;\n"
-        "    o_colour = a_colours;\n"
+        "    int element = int(a_ids.x);\n"
+        "    vec3 position = (model*vec4(positionOrigin.xyz+positionExtent.xyz*a_positions, 1.0)).xyz;\n"
+        "    float radius = aggregates == 1 ? a_radius : texelFetch(palette, ivec2(element, 1), 0).r;\n"
+        "    vec2 corner = points == 1 ? vec2(0.0) : a_vertices;\n"
+        "    billboard = corner * clipCorrection;\n"
+        "    atomViewPos = (view * vec4(position, 1.0)).xyz;\n"
+        "    gl_Position = proj * vec4(atomViewPos+vec3(scaling*radius * corner * clipCorrection, 0.0), 1.0);\n"
+        "    gl_PointSize = 2.0*clipCorrection*scaling*radius*pointScale/max(-atomViewPos.z, 1e-4);\n"
+        "    vec4 front = proj * vec4(0.0, 0.0, min(atomViewPos.z+scaling*radius, -1e-4), 1.0);\n"
+        "    gl_Position.z = max(front.z/front.w, -1.0)*gl_Position.w;\n"
+        "    atomPosScale = vec4(position, radius*scaling);\n"
+        "    o_colour = texelFetch(palette, ivec2(element, 0), 0);\n"
+        "    o_colour.a *= emphasis(element)*a_ids.y/255.0;\n"
+        "    if (passCulls(o_colour.a)) { gl_Position = vec4(0.0, 0.0, 2.0, 1.0); }\n"
         "}";
 
     const char * imposterFragmentShader =
         "#version " GLSL_VERSION "\n"
+        "#extension GL_ARB_conservative_depth : enable\n"
+        "#ifdef GL_ARB_conservative_depth\n"
+        "layout(depth_greater) out float gl_FragDepth;\n"
+        "#endif\n"
         "precision lowp float; precision lowp int;\n"
         "in vec2 billboard;\n"
         "in vec3 atomViewPos;\n"
         "in vec4 atomPosScale;\n"
         "in vec4 o_colour;\n"
-        "out vec4 colour;\n"
+        TRANSPARENCY_FRAGMENT_GLSL
         "uniform mat4 view;\n"
         "uniform mat4 proj;\n"
         "uniform vec4 lightPos;\n"
         "uniform vec4 lightColour;\n"
         "uniform float ambientLight;\n"
+        "uniform int depthOnly;\n"
+        "uniform int points;\n"
+        "uniform float clipCorrection;\n"
         "bool sphereHit(vec3 rayDirection, vec3 centre, float radius, out vec3 pos, out vec3 normal)\n"
         "{\n"
         "    float b = 2.0 * dot(rayDirection, -centre);\n"
@@ -361,15 +835,21 @@ private:
         "void main()\n"
         "{\n"
         "    vec3 lightViewPos = (view*lightPos).xyz;\n"
-        "    vec3 rayDirection = normalize(vec3(billboard * atomPosScale.w, 0.0) + atomViewPos);"
+        "    vec2 corner = points == 1 ? vec2(2.0*gl_PointCoord.x-1.0, 1.0-2.0*gl_PointCoord.y)*clipCorrection : billboard;\n"
+        "    vec3 rayDirection = normalize(vec3(corner * atomPosScale.w, 0.0) + atomViewPos);"
         "    vec3 viewNormal; vec3 viewPos;\n"
         "    bool hit = sphereHit(rayDirection, atomViewPos, atomPosScale.w, viewPos, viewNormal);\n"
         "    if (!hit) { discard; }\n"
         "    vec4 clipPos = proj * vec4(viewPos, 1.0);\n"
         "    float ndcDepth = clipPos.z / clipPos.w;\n"
         "    gl_FragDepth = ((gl_DepthRange.diff * ndcDepth) + gl_DepthRange.near + gl_DepthRange.far) / 2.0;\n"
+        "    if (depthOnly == 1)\n"
+        "    {\n"
+        "        if (!opaque(o_colour.a)) { discard; }\n"
+        "        return;\n"
+        "    }\n"
         "    float diff = max(dot(normalize(viewNormal), normalize(lightViewPos-atomViewPos)), 0.0);\n"
-        "    colour = vec4((ambientLight + diff)*lightColour.rgb * o_colour.rgb, o_colour.a);\n"
+        "    writeColour(vec4((ambientLight + diff)*lightColour.rgb * o_colour.rgb, o_colour.a));\n"
         "}";
 
     void setProjectionView()
@@ -380,163 +860,467 @@ private:
     }
 
     /**
-     * @brief Manages OpenGL arrays for Atoms
-     * @remark is constructed with a set maximum number of atoms.
-     * @remark Atoms are instance rendered with a single mesh.
+     * @brief Draw the Atoms with lighting.
+     *
+     * @param imposters draw with impostor spheres inplace of meshes.
+     * @param impostorFirst the first impostor when adaptive.
+     * @param impostorCount the impostors when adaptive.
      */
-    struct AtomBuffer
+    void drawLit(bool imposters, uint64_t impostorFirst, uint64_t impostorCount)
     {
-        /**
-         * @brief Construct a new AtomBuffer.
-         *
-         * @param mesh the mesh to instance draw with.
-         * @param atoms the maximum number of atoms in this buffer.
-         */
-        AtomBuffer
-        (
-            std::map<uint8_t, SphereMesh> meshes,
-            uint32_t atoms,
-            uint8_t levelOfDetail
-        )
-        : meshes(meshes), size(atoms), levelOfDetail(std::min(meshes.size()-1, size_t(levelOfDetail)))
+        if (gpuCulling())
         {
-            glGenVertexArrays(1, &vao_mesh);
-            glGenVertexArrays(1, &vao_imposter);
-            glGenBuffers(1, &a_quad);
-            glGenBuffers(1, &a_colours);
-            glGenBuffers(1, &a_positionsAndScales);
-
-            a_meshVertices = std::vector<GLuint>(meshes.size(), 0);
-            a_meshNormals = std::vector<GLuint>(meshes.size(), 0);
-            glGenBuffers(a_meshVertices.size(), a_meshVertices.data());
-            glGenBuffers(a_meshNormals.size(), a_meshNormals.data());
-
-            positionsAndScales.resize(size*4);
-            colours.resize(size*4);
-
-            glBindVertexArray(vao_mesh);
-
-                createBuffer
-                (
-                    a_meshVertices[this->levelOfDetail],
-                    meshes[this->levelOfDetail].vertices.data(),
-                    meshes[this->levelOfDetail].vertices.size(),
-                    GL_STATIC_DRAW,
-                    0,
-                    3,
-                    0
-                );
+            if (imposters) { imposterShader->use(); }
+            else { meshShader->use(); }
+            buffer->drawCulled(imposters);
+        }
+        else if (imposters)
+        {
+            imposterShader->use();
+            buffer->draw(imposters);
+        }
+        else if (adaptive)
+        {
+            meshShader->use();
+            std::vector<AtomBuffer::Range> ranges(lod.impostor());
+            for (uint8_t b = 0; b < lod.impostor(); b++)
+            {
+                ranges[b] = {bucketOffsets[b], bucketOffsets[b+1]-bucketOffsets[b]};
+            }
+            buffer->drawMeshes(ranges);
+            imposterShader->use();
+            buffer->drawImpostors(impostorFirst, impostorCount);
+        }
+        else
+        {
+            meshShader->use();
+            buffer->draw(imposters);
+        }
+        drawAggregates();
+    }
 
-                createBuffer
-                (
-                    a_meshNormals[this->levelOfDetail],
-                    meshes[this->levelOfDetail].normals.data(),
-                    meshes[this->levelOfDetail].normals.size(),
-                    GL_STATIC_DRAW,
-                    1,
-                    3,
-                    0
-                );
+    /**
+     * @brief Draw the aggregates of the Octree cut as impostors.
+     *
+     */
+    void drawAggregates()
+    {
+        if (buffer->aggregateCount() == 0) { return; }
+        imposterShader->use();
+        imposterShader->setUniform<int>("aggregates", 1);
+        imposterShader->setUniform<int>("points", 0);
+        buffer->drawAggregates();
+        imposterShader->setUniform<int>("aggregates", 0);
+        imposterShader->setUniform<int>("points", sprites ? 1 : 0);
+    }
 
-                createBuffer
-                (
-                    a_positionsAndScales,
-                    positionsAndScales.data(),
-                    positionsAndScales.size(),
-                    GL_DYNAMIC_DRAW,
-                    2,
-                    4,
-                    1
-                );
+    /**
+     * @brief Switch impostors between quads and point sprites.
+     *
+     */
+    void drawPoints(bool points)
+    {
+        if (points == sprites) { return; }
+        sprites = points;
+        buffer->setPoints(points);
+        imposterShader->use();
+        imposterShader->setUniform<int>("points", points ? 1 : 0);
+    }
 
-                createBuffer
-                (
-                    a_colours,
-                    colours.data(),
-                    colours.size(),
-                    GL_DYNAMIC_DRAW,
-                    3,
-                    4,
-                    1
-                );
+    void transparencyPassUniform(TransparencyPass p)
+    {
+        for (jGL::GL::glShader * shader : {meshShader.get(), imposterShader.get()})
+        {
+            shader->use();
+            shader->setUniform<int>("transparencyPass", int(p));
+        }
+    }
 
-            glBindVertexArray(0);
+    /**
+     * @brief Whether Atoms are uploaded in an order other than insertion.
+     *
+     * @return true if bucketed by level of detail, sorted by depth, culled
+     * on the CPU or cut from the Octree.
+     * @return false if in insertion order.
+     */
+    bool reordered() const
+    {
+        return adaptive || depthOrder != DepthOrder::NONE || (culling && !gpuCulling()) || hierarchical();
+    }
 
-            glBindVertexArray(vao_imposter);
+    /**
+     * @brief Whether the uploaded Atoms are culled on the GPU.
+     *
+     * @remark Level of detail buckets are contiguous ranges of the upload,
+     * so adaptive Atoms are culled on the CPU. The Octree cut is already
+     * in view.
+     */
+    bool gpuCulling() const { return computeCulling && !adaptive && !hierarchical(); }
 
-                createBuffer
-                (
-                    a_quad,
-                    quad.data(),
-                    quad.size(),
-                    GL_STATIC_DRAW,
-                    0,
-                    2,
-                    0
-                );
+    bool hierarchical() const { return aggregatePixels > 0.0f; }
 
-                enableBuffer
-                (
-                    a_positionsAndScales,
-                    1,
-                    4,
-                    1
+    /**
+     * @brief Order Atoms by level of detail and camera distance and upload
+     * them in that order.
+     *
+     * @remark Camera distances, buckets and the orderings are computed in
+     * parallel. The bucket sort is stable, so depth sorted Atoms stay sorted
+     * within each bucket.
+     * @remark When culling on the CPU only Atoms in view are ordered, when
+     * hierarchical only the Atoms of the Octree cut.
+     */
+    void reorder()
+    {
+        if (!orderNeedsUpdate) { return; }
+        orderNeedsUpdate = false;
+        // Only shown Atoms are ordered, by their place in shown.
+        const std::vector<uint64_t> * shown = filtered ? &visible : nullptr;
+        if (hierarchical())
+        {
+            cutOctree();
+            shown = &inView;
+        }
+        else if (culling && !gpuCulling())
+        {
+            const Frustum frustum(orderedPV*model);
+            parallelCompact
+            (
+                filtered ? visible.size() : buffer->atomCount(),
+                [&](uint64_t j)
+                {
+                    const uint64_t i = filtered ? visible[j] : j;
+                    return frustum.intersects(buffer->position(i), radii[buffer->element(i)]*scaling);
+                },
+                inView
+            );
+            if (filtered) { for (uint64_t & j : inView) { j = visible[j]; } }
+            shown = &inView;
+        }
+        if (!adaptive && depthOrder == DepthOrder::NONE)
+        {
+            if (shown == nullptr) { upload(); }
+            else { buffer->updateVertexArray(*shown); }
+            return;
+        }
+        const uint64_t n = shown == nullptr ? buffer->atomCount() : shown->size();
+        cameraDistances.resize(n);
+        buckets.resize(n);
+        parallelFor
+        (
+            n,
+            parallelThreads(n),
+            [&](uint64_t begin, uint64_t end, unsigned)
+            {
+                for (uint64_t j = begin; j < end; j++)
+                {
+                    const uint64_t i = shown == nullptr ? j : (*shown)[j];
+                    cameraDistances[j] = glm::length(glm::vec3(model*glm::vec4(buffer->position(i), 1.0f))-cameraPosition);
+                    if (!adaptive) { continue; }
+                    float pixels = radii[buffer->element(i)]*scaling*pixelScale/cameraDistances[j];
+                    buckets[j] = lod.level(pixels, maxLevelOfDetail());
+                }
+            }
+        );
+        if (depthOrder == DepthOrder::NONE)
+        {
+            lod.sort(buckets, drawOrder, bucketOffsets);
+        }
+        else
+        {
+            const std::vector<uint64_t> & byDepth = depthSort.sort(cameraDistances, depthOrder);
+            if (adaptive)
+            {
+                depthBuckets.resize(n);
+                parallelFor
+                (
+                    n,
+                    parallelThreads(n),
+                    [&](uint64_t begin, uint64_t end, unsigned)
+                    {
+                        for (uint64_t k = begin; k < end; k++) { depthBuckets[k] = buckets[byDepth[k]]; }
+                    }
                 );
+                lod.sort(depthBuckets, drawOrder, bucketOffsets);
+                for (uint64_t & k : drawOrder) { k = byDepth[k]; }
+            }
+            else
+            {
+                drawOrder = byDepth;
+            }
+        }
+        if (shown != nullptr)
+        {
+            for (uint64_t & j : drawOrder) { j = (*shown)[j]; }
+        }
+        buffer->updateVertexArray(drawOrder);
+        cullNeedsUpdate = true;
+        spritesNeedUpdate = true;
+    }
+
+    /**
+     * @brief Find the shown Atoms of the buffer.
+     *
+     */
+    void compactVisible()
+    {
+        if (!filtered) { visible.clear(); return; }
+        parallelCompact
+        (
+            buffer->atomCount(),
+            [&](uint64_t i) { return !visibility.isHidden(i, Element(buffer->element(i))); },
+            visible
+        );
+    }
+
+    /**
+     * @brief Cut the Octree of shown Atoms, and upload its aggregates.
+     *
+     * @remark The Atoms of the cut are left in inView.
+     */
+    void cutOctree()
+    {
+        auto index = [this](uint64_t j) { return filtered ? visible[j] : j; };
+        if (octreeNeedsUpdate)
+        {
+            octree.build
+            (
+                filtered ? visible.size() : buffer->atomCount(),
+                [&](uint64_t j) { return buffer->position(index(j)); },
+                [&](uint64_t j) { return buffer->element(index(j)); },
+                [&](uint64_t j) { return buffer->alpha(index(j)); },
+                radii
+            );
+            octreeNeedsUpdate = false;
+        }
+        const glm::vec3 eye = glm::vec3(glm::inverse(model)*glm::vec4(cameraPosition, 1.0f));
+        octree.select(Frustum(orderedPV*model), eye, pixelScale, aggregatePixels, scaling, inView, aggregateNodes);
+        if (filtered) { for (uint64_t & j : inView) { j = visible[j]; } }
+
+        std::vector<AtomBuffer::Aggregate> aggregates(aggregateNodes.size());
+        for (uint64_t k = 0; k < aggregateNodes.size(); k++)
+        {
+            const OctreeNode & node = octree.getNodes()[aggregateNodes[k]];
+            aggregates[k] = {node.centre, node.element, node.alpha, node.fusedRadius()};
+        }
+        buffer->updateAggregates(aggregates);
+    }
+
+    /**
+     * @brief Upload the shown Atoms in insertion order.
+     *
+     * @remark Without hidden Atoms only changed data is uploaded.
+     */
+    void upload()
+    {
+        if (filtered) { buffer->updateVertexArray(visible); }
+        else { buffer->updateVertexArray(); }
+        cullNeedsUpdate = true;
+        spritesNeedUpdate = true;
+    }
+
+    void setQuantisation(const Quantisation & q)
+    {
+        for (auto shader : {meshShader.get(), imposterShader.get()})
+        {
+            shader->use();
+            shader->setUniform<glm::vec4>("positionOrigin", glm::vec4(q.origin, 0.0f));
+            shader->setUniform<glm::vec4>("positionExtent", glm::vec4(q.extent, 0.0f));
+        }
+    }
+
+    /**
+     * @brief Manages OpenGL arrays for Atoms
+     * @remark is constructed with a set maximum number of atoms.
+     * @remark Atoms are instance rendered with indexed meshes, packed for
+     * every level of detail into one vertex (position and normal) and one
+     * index buffer.
+     * @remark A mesh is uploaded when its build finishes, until then the
+     * finest coarser mesh is drawn.
+     * @remark Per Atom data is in two blocks, all positions then all
+     * Element id and alpha bytes, so either can be uploaded alone. Positions
+     * are 3 floats, or 3 normalised unsigned shorts when compact.
+     */
+    struct AtomBuffer
+    {
+        /**
+         * @brief Construct a new AtomBuffer.
+         *
+         * @param levels the levels of detail to instance draw with.
+         * @param atoms the maximum number of atoms in this buffer.
+         * @param levelOfDetail the initial level of detail.
+         * @param compact quantise positions to 16 bits.
+         */
+        AtomBuffer
+        (
+            std::vector<SphereMeshLevel> levels,
+            uint32_t atoms,
+            uint8_t levelOfDetail,
+            bool compact = false
+        )
+        : levels(levels),
+          size(atoms),
+          levelOfDetail(std::min(levels.size()-1, size_t(levelOfDetail))),
+          compact(compact),
+          positionBytes(compact ? COMPACT_POSITION_BYTES : POSITION_BYTES),
+          idsOffset(((uint64_t(atoms)*positionBytes+3)/4)*4)
+        {
+            glGenVertexArrays(1, &vao_mesh);
+            glGenVertexArrays(1, &vao_imposter);
+            glGenBuffers(1, &a_quad);
+            glGenBuffers(1, &a_meshAtlas);
+            glGenBuffers(1, &a_meshIndices);
+            glGenBuffers(1, &a_commands);
+
+            multiDraw = multiDrawIndirectAvailable();
+
+            instances.resize(idsOffset+uint64_t(size)*ID_BYTES);
+            stream = std::make_unique<StreamBuffer>(instances.size());
+
+            // Welded closed meshes have triangles/2+2 vertices, so every
+            // level's place in the atlas is known before any are built.
+            pending.resize(levels.size());
+            indexCounts = std::vector<uint32_t>(levels.size(), 0);
+            GLint vertices = 0;
+            GLuint indices = 0;
+            for (const SphereMeshLevel & level : levels)
+            {
+                baseVertices.push_back(vertices);
+                firstIndices.push_back(indices);
+                vertices += level.triangles/2+2;
+                indices += 3*level.triangles;
+            }
+            baseVertices.push_back(vertices);
+
+            glBindVertexArray(vao_mesh);
+
+                glBindBuffer(GL_ARRAY_BUFFER, a_meshAtlas);
+                    glBufferData(GL_ARRAY_BUFFER, ATLAS_STRIDE*vertices, nullptr, GL_STATIC_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                interleavedAttribute(a_meshAtlas, 0, 3, GL_FLOAT, false, ATLAS_STRIDE, 0, 0);
+                interleavedAttribute(a_meshAtlas, 1, 3, GL_FLOAT, false, ATLAS_STRIDE, 3*sizeof(float), 0);
+
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_meshIndices);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t)*indices, nullptr, GL_STATIC_DRAW);
+
+                enableInstances(2);
+
+            glBindVertexArray(0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+            glBindVertexArray(vao_imposter);
 
-                enableBuffer
+                createBuffer
                 (
-                    a_colours,
+                    a_quad,
+                    quad.data(),
+                    quad.size(),
+                    GL_STATIC_DRAW,
+                    0,
                     2,
-                    4,
-                    1
+                    0
                 );
 
+                enableInstances(1);
+
             glBindVertexArray(0);
         }
 
         ~AtomBuffer()
         {
-            glDeleteBuffers(a_meshVertices.size(), a_meshVertices.data());
-            glDeleteBuffers(a_meshNormals.size(), a_meshNormals.data());
-            glDeleteBuffers(1, &a_colours);
-            glDeleteBuffers(1, &a_positionsAndScales);
+            glDeleteBuffers(1, &a_meshAtlas);
+            glDeleteBuffers(1, &a_meshIndices);
+            glDeleteBuffers(1, &a_commands);
             glDeleteBuffers(1, &a_quad);
             glDeleteVertexArrays(1, &vao_mesh);
             glDeleteVertexArrays(1, &vao_imposter);
+            if (culler != nullptr)
+            {
+                glDeleteVertexArrays(1, &vao_meshCulled);
+                glDeleteVertexArrays(1, &vao_imposterCulled);
+            }
+            if (aggregatesCreated)
+            {
+                glDeleteBuffers(1, &a_aggregates);
+                glDeleteVertexArrays(1, &vao_aggregates);
+            }
         }
 
         /**
          * @brief Set the buffer position to the start.
          *
          */
-        void flip() { index = 0; atoms = 0; }
+        void flip() { atoms = 0; }
+
+        /**
+         * @brief The maximum number of Atoms to draw.
+         *
+         * @return uint32_t number of atoms.
+         */
+        uint32_t atomCount() const { return atoms; }
+
+        /**
+         * @brief The number of Atoms in the last upload.
+         *
+         * @return uint32_t number of atoms drawn.
+         */
+        uint32_t drawCount() const { return uploaded; }
 
         /**
-         * @brief Insert (update) an Atoms data.
+         * @brief The bytes uploaded per Atom.
          *
-         * @param atom the Atom data to insert.
+         * @return uint8_t the position and id bytes.
          */
-        void insert(const Atom & atom)
+        uint8_t bytesPerAtom() const { return positionBytes+ID_BYTES; }
+
+        /**
+         * @brief The Quantisation of the last inserted Atoms.
+         *
+         * @remark The identity unless compact.
+         * @return const Quantisation& the position Quantisation.
+         */
+        const Quantisation & getQuantisation() const { return quantisation; }
+
+        /**
+         * @brief The position of an inserted Atom.
+         *
+         * @param i the index of the Atom, in insertion order.
+         * @return glm::vec3 the (dequantised) position.
+         */
+        glm::vec3 position(uint64_t i) const
         {
-            positionsAndScales[index] = atom.position.x;
-            positionsAndScales[index+1] = atom.position.y;
-            positionsAndScales[index+2] = atom.position.z;
-            positionsAndScales[index+3] = atom.scale;
+            const uint8_t * instance = &instances[i*positionBytes];
+            if (compact)
+            {
+                glm::u16vec3 q;
+                std::memcpy(&q, instance, sizeof(q));
+                return quantisation.dequantise(q);
+            }
+            glm::vec3 r;
+            std::memcpy(&r, instance, sizeof(r));
+            return r;
+        }
 
-            colours[index] = atom.colour.r;
-            colours[index+1] = atom.colour.g;
-            colours[index+2] = atom.colour.b;
-            colours[index+3] = atom.colour.a;
-            index += 4;
-            atoms++;
+        /**
+         * @brief The Element of an inserted Atom.
+         *
+         * @param i the index of the Atom, in insertion order.
+         * @return uint8_t the Element id.
+         */
+        uint8_t element(uint64_t i) const
+        {
+            return instances[idsOffset+i*ID_BYTES];
         }
 
         /**
-         * @brief The maximum number of Atoms to draw.
+         * @brief The alpha of an inserted Atom.
          *
-         * @return uint32_t number of atoms.
+         * @param i the index of the Atom, in insertion order.
+         * @return uint8_t the alpha byte.
          */
-        uint32_t atomCount() const { return atoms; }
+        uint8_t alpha(uint64_t i) const
+        {
+            return instances[idsOffset+i*ID_BYTES+1];
+        }
 
         /**
          * @brief Draw the atoms.
@@ -546,112 +1330,635 @@ private:
          */
         void draw(uint32_t count, bool imposters)
         {
-            count = std::min(count, atoms);
+            count = std::min(count, uploaded);
+            if (imposters)
+            {
+                drawImpostors(0, count);
+            }
+            else
+            {
+                std::vector<Range> ranges(levels.size(), {0, 0});
+                ranges[levelOfDetail] = {0, count};
+                drawMeshes(ranges);
+            }
+        }
+
+        /**
+         * @brief A contiguous range of the uploaded Atoms.
+         *
+         */
+        struct Range { uint64_t first; uint64_t count; };
+
+        /**
+         * @brief Draw a range of the uploaded Atoms as impostors.
+         *
+         * @param first the first Atom in upload order.
+         * @param count the number of Atoms.
+         */
+        void drawImpostors(uint64_t first, uint64_t count)
+        {
             if (count == 0) { return; }
+            drawState();
+            glFrontFace(GL_CW);
+            glBindVertexArray(vao_imposter);
 
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glEnable(GL_DEPTH_TEST);
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
+                // Without base instances (OpenGL 4.2) the attributes are offset.
+                if (first > 0) { enableInstances(1, first); }
+                glDrawArraysInstanced(impostorMode(), 0, impostorVertices(), count);
+                if (first > 0) { enableInstances(1); }
 
-            if (imposters) {
-                glFrontFace(GL_CW);
-                glBindVertexArray(vao_imposter);
+            glBindVertexArray(0);
+            glFrontFace(GL_CCW);
+        }
 
-                    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        /**
+         * @brief Draw ranges of the uploaded Atoms with meshes.
+         *
+         * @remark All levels are drawn by one glMultiDrawElementsIndirect
+         * from the mesh atlas, with the ranges as base instances. Without
+         * OpenGL 4.3 each level is drawn in turn.
+         * @param ranges the range of Atoms to draw with each level of detail.
+         */
+        void drawMeshes(const std::vector<Range> & ranges)
+        {
+            std::vector<DrawElementsIndirectCommand> draws;
+            for (uint8_t l = 0; l < ranges.size(); l++)
+            {
+                if (ranges[l].count == 0) { continue; }
+                uint8_t level = meshLevel(l);
+                draws.push_back
+                (
+                    {
+                        indexCounts[level],
+                        GLuint(ranges[l].count),
+                        firstIndices[level],
+                        baseVertices[level],
+                        GLuint(ranges[l].first)
+                    }
+                );
+            }
+            if (draws.empty()) { return; }
+
+            drawState();
+            glBindVertexArray(vao_mesh);
+
+                if (multiDraw)
+                {
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, a_commands);
+                    if (draws != commands)
+                    {
+                        commands = draws;
+                        glBufferData
+                        (
+                            GL_DRAW_INDIRECT_BUFFER,
+                            sizeof(DrawElementsIndirectCommand)*commands.size(),
+                            commands.data(),
+                            GL_DYNAMIC_DRAW
+                        );
+                    }
+                    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, commands.size(), 0);
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                }
+                else
+                {
+                    for (const DrawElementsIndirectCommand & d : draws)
+                    {
+                        if (d.baseInstance > 0) { enableInstances(2, d.baseInstance); }
+                        glDrawElementsInstancedBaseVertex
+                        (
+                            GL_TRIANGLES,
+                            d.count,
+                            GL_UNSIGNED_INT,
+                            (void*)(uintptr_t(sizeof(uint32_t)*d.firstIndex)),
+                            d.instanceCount,
+                            d.baseVertex
+                        );
+                        if (d.baseInstance > 0) { enableInstances(2); }
+                    }
+                }
 
+            glBindVertexArray(0);
+        }
+
+        /**
+         * @brief Set the level of detail, selecting the mesh to draw.
+         *
+         * @param levelOfDetail the new level of detail.
+         */
+        void setLevelOfDetail(uint8_t levelOfDetail)
+        {
+            this->levelOfDetail = std::min(size_t(levelOfDetail), levels.size()-1);
+            request(this->levelOfDetail);
+        }
+
+        /**
+         * @brief Build and upload a level's mesh now.
+         *
+         * @param level the level of detail.
+         */
+        void waitFor(uint8_t level)
+        {
+            request(level);
+            if (indexCounts[level] == 0) { upload(level); }
+        }
+
+        /**
+         * @brief Draw all the Atoms.
+         *
+         * @param imposters draw with impostor spheres inplace of meshes.
+         */
+        void draw(bool imposters = true) { draw(uploaded, imposters); }
+
+        /**
+         * @brief Keep the uploaded Atoms inside a Frustum, on the GPU.
+         *
+         * @remark The kept Atoms are copied in order to a buffer of their
+         * own, as 3 floats and the ids, and drawn indirectly, @see FrustumCull.
+         * @param frustum the Frustum, in the space of the Atoms.
+         * @param palette the palette texture, for radii.
+         * @param scaling the atom scaling factor.
+         */
+        void cull(const Frustum & frustum, GLuint palette, float scaling)
+        {
+            if (culler == nullptr)
+            {
+                culler = std::make_unique<FrustumCull>(cullRecord, 1);
+                GLuint culled = culler->targetBuffer();
+                glGenVertexArrays(1, &vao_meshCulled);
+                glGenVertexArrays(1, &vao_imposterCulled);
+
+                glBindVertexArray(vao_meshCulled);
+                    interleavedAttribute(a_meshAtlas, 0, 3, GL_FLOAT, false, ATLAS_STRIDE, 0, 0);
+                    interleavedAttribute(a_meshAtlas, 1, 3, GL_FLOAT, false, ATLAS_STRIDE, 3*sizeof(float), 0);
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_meshIndices);
+                    interleavedAttribute(culled, 2, 3, GL_FLOAT, false, CULLED_BYTES, 0, 1);
+                    interleavedAttribute(culled, 3, 2, GL_UNSIGNED_BYTE, false, CULLED_BYTES, 3*sizeof(float), 1);
+                glBindVertexArray(vao_imposterCulled);
+                    interleavedAttribute(a_quad, 0, 2, GL_FLOAT, false, 2*sizeof(float), 0, 0);
+                    interleavedAttribute(culled, 1, 3, GL_FLOAT, false, CULLED_BYTES, 0, 1);
+                    interleavedAttribute(culled, 2, 2, GL_UNSIGNED_BYTE, false, CULLED_BYTES, 3*sizeof(float), 1);
+                glBindVertexArray(0);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            }
+            culler->use();
+            glUniform1i(culler->uniform("compact"), compact ? 1 : 0);
+            glUniform1ui(culler->uniform("idsOffset"), GLuint(idsOffset));
+            glUniform3f(culler->uniform("positionOrigin"), quantisation.origin.x, quantisation.origin.y, quantisation.origin.z);
+            glUniform3f(culler->uniform("positionExtent"), quantisation.extent.x, quantisation.extent.y, quantisation.extent.z);
+            glUniform1f(culler->uniform("scaling"), scaling);
+            glUniform1i(culler->uniform("palette"), 0);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, palette);
+            culler->cull(frustum, stream->id(), stream->offset(), uploaded);
+        }
+
+        /**
+         * @brief Draw the Atoms kept by the last cull.
+         *
+         * @param imposters draw with impostor spheres inplace of meshes.
+         */
+        void drawCulled(bool imposters)
+        {
+            if (culler == nullptr) { return; }
+            if (imposters) { culler->setCommand(impostorVertices()); }
+            else
+            {
+                uint8_t level = meshLevel(levelOfDetail);
+                culler->setCommand(indexCounts[level], firstIndices[level], baseVertices[level]);
+            }
+            drawState();
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler->commandBuffer());
+            if (imposters)
+            {
+                glFrontFace(GL_CW);
+                glBindVertexArray(vao_imposterCulled);
+                    glDrawArraysIndirect(impostorMode(), 0);
                 glBindVertexArray(0);
                 glFrontFace(GL_CCW);
             }
             else
             {
-                glBindVertexArray(vao_mesh);
-
-                    glDrawArraysInstanced(GL_TRIANGLES, 0, meshes[levelOfDetail].vertices.size(), count);
-
+                glBindVertexArray(vao_meshCulled);
+                    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0);
                 glBindVertexArray(0);
             }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
         }
 
         /**
-         * @brief Set the level of detail, selecting the mesh to draw.
+         * @brief A sphere standing in for many Atoms.
          *
-         * @param levelOfDetail the new level of detail.
          */
-        void setLevelOfDetail(uint8_t levelOfDetail)
+        struct Aggregate
         {
+            glm::vec3 position;
+            uint8_t element;
+            uint8_t alpha;
+            float radius;
+        };
 
-            this->levelOfDetail = std::min(size_t(levelOfDetail), meshes.size()-1);
-            glBindVertexArray(vao_mesh);
-                createBuffer
-                (
-                    a_meshVertices[this->levelOfDetail],
-                    meshes[this->levelOfDetail].vertices.data(),
-                    meshes[this->levelOfDetail].vertices.size(),
-                    GL_STATIC_DRAW,
-                    0,
-                    3,
-                    0
-                );
+        /**
+         * @brief Upload the aggregates to draw with the Atoms.
+         *
+         * @remark Positions are stored as the position attribute reads
+         * them, in the unit box of the Quantisation when compact.
+         * @param aggregates the aggregate spheres.
+         */
+        void updateAggregates(const std::vector<Aggregate> & aggregates)
+        {
+            aggregated = aggregates.size();
+            if (aggregates.empty()) { return; }
+            if (!aggregatesCreated)
+            {
+                glGenBuffers(1, &a_aggregates);
+                glGenVertexArrays(1, &vao_aggregates);
+                glBindVertexArray(vao_aggregates);
+                    interleavedAttribute(a_quad, 0, 2, GL_FLOAT, false, 2*sizeof(float), 0, 0);
+                    interleavedAttribute(a_aggregates, 1, 3, GL_FLOAT, false, AGGREGATE_BYTES, 0, 1);
+                    interleavedAttribute(a_aggregates, 2, 2, GL_UNSIGNED_BYTE, false, AGGREGATE_BYTES, 3*sizeof(float), 1);
+                    interleavedAttribute(a_aggregates, 3, 1, GL_FLOAT, false, AGGREGATE_BYTES, 4*sizeof(float), 1);
+                glBindVertexArray(0);
+                aggregatesCreated = true;
+            }
+            std::vector<uint8_t> records(aggregates.size()*AGGREGATE_BYTES, 0);
+            for (uint64_t k = 0; k < aggregates.size(); k++)
+            {
+                const Aggregate & a = aggregates[k];
+                uint8_t * record = &records[k*AGGREGATE_BYTES];
+                const glm::vec3 u = (a.position-quantisation.origin)/quantisation.extent;
+                std::memcpy(record, &u, 3*sizeof(float));
+                record[3*sizeof(float)] = a.element;
+                record[3*sizeof(float)+1] = a.alpha;
+                std::memcpy(record+4*sizeof(float), &a.radius, sizeof(float));
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, a_aggregates);
+                glBufferData(GL_ARRAY_BUFFER, records.size(), records.data(), GL_STREAM_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
 
-                createBuffer
-                (
-                    a_meshNormals[this->levelOfDetail],
-                    meshes[this->levelOfDetail].normals.data(),
-                    meshes[this->levelOfDetail].normals.size(),
-                    GL_STATIC_DRAW,
-                    1,
-                    3,
-                    0
-                );
+        /**
+         * @brief Draw the aggregates as impostors.
+         *
+         */
+        void drawAggregates()
+        {
+            if (aggregated == 0) { return; }
+            drawState();
+            glFrontFace(GL_CW);
+            glBindVertexArray(vao_aggregates);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, aggregated);
             glBindVertexArray(0);
+            glFrontFace(GL_CCW);
         }
 
         /**
-         * @brief Draw all the Atoms.
+         * @brief The number of aggregates uploaded.
          *
-         * @param imposters draw with impostor spheres inplace of meshes.
+         * @return uint64_t the aggregates.
          */
-        void draw(bool imposters = true) { draw(atoms, imposters); }
+        uint64_t aggregateCount() const { return aggregated; }
+
+        /**
+         * @brief Draw impostors as one vertex points, or four vertex quads.
+         *
+         * @param p whether to draw points.
+         */
+        void setPoints(bool p) { points = p; }
+
+        /**
+         * @brief Read back the Atoms kept by the last cull, once it has
+         * finished.
+         *
+         */
+        void readCulledCount() { if (culler != nullptr) { culler->readCount(); } }
+
+        /**
+         * @brief The Atoms kept by the last cull read back.
+         *
+         * @return uint64_t the Atoms drawn, a few frames behind.
+         */
+        uint64_t culledCount() const { return culler == nullptr ? uploaded : culler->lastCount(); }
 
         /**
          * @brief Insert a batch of Atoms.
          *
+         * @remark When compact the Quantisation is refit to the Atoms'
+         * bounding box.
+         * @remark Changed positions and ids are tracked separately, so
+         * moving Atoms does not upload ids, nor changing alphas positions.
          * @param atoms the batch of Atoms to insert.
          */
-        void insert(const std::vector<Atom> & atoms)
+        void insert(const AtomStore & atoms)
         {
             flip();
-            for (const Atom & atom : atoms) { insert(atom); }
+            const std::vector<float> & x = atoms.getX();
+            const std::vector<float> & y = atoms.getY();
+            const std::vector<float> & z = atoms.getZ();
+            const std::vector<Element> & elements = atoms.getElements();
+            const std::vector<uint8_t> & alphas = atoms.getAlphas();
+            const uint64_t n = std::min(uint64_t(atoms.size()), uint64_t(size));
+            if (compact) { quantisation = Quantisation(atoms); }
+            // Atoms past the last insert may be stale on the GPU.
+            if (n > inserted)
+            {
+                positionsChanged.mark(inserted, n);
+                idsChanged.mark(inserted, n);
+            }
+            inserted = n;
+            uint8_t * positions = instances.data();
+            uint8_t * ids = instances.data()+idsOffset;
+            for (uint64_t i = 0; i < n; i++)
+            {
+                uint8_t position[POSITION_BYTES];
+                if (compact)
+                {
+                    glm::u16vec3 q = quantisation.quantise(glm::vec3(x[i], y[i], z[i]));
+                    std::memcpy(position, &q, sizeof(q));
+                }
+                else
+                {
+                    float r[3] = {x[i], y[i], z[i]};
+                    std::memcpy(position, r, sizeof(r));
+                }
+                uint8_t * p = positions+i*positionBytes;
+                if (std::memcmp(p, position, positionBytes) != 0)
+                {
+                    std::memcpy(p, position, positionBytes);
+                    positionsChanged.mark(i);
+                }
+                uint8_t * id = ids+i*ID_BYTES;
+                if (id[0] != uint8_t(elements[i]) || id[1] != alphas[i])
+                {
+                    id[0] = uint8_t(elements[i]);
+                    id[1] = alphas[i];
+                    idsChanged.mark(i);
+                }
+            }
+            this->atoms += n;
         }
 
         /**
-         * @brief Upload Atom data to the GPU.
+         * @brief Upload changed Atom data to the GPU.
          *
+         * @remark Only the changed ranges of positions and ids are written
+         * to the next segment of the stream, @see StreamBuffer.
          */
         void updateVertexArray()
         {
-            glBindVertexArray(vao_mesh);
-
-                subFullBuffer(a_positionsAndScales, positionsAndScales.data(), positionsAndScales.size());
-                subFullBuffer(a_colours, colours.data(), colours.size());
+            std::vector<ByteRange> changed =
+            {
+                positionsChanged.bytes(0, positionBytes),
+                idsChanged.bytes(idsOffset, ID_BYTES)
+            };
+            positionsChanged.clear();
+            idsChanged.clear();
+            uploaded = atoms;
+            if (stream->update(instances.data(), instances.size(), changed))
+            {
+                pointInstances();
+            }
+        }
 
-            glBindVertexArray(0);
+        /**
+         * @brief Upload Atom data to the GPU in a given order.
+         *
+         * @remark The Atoms are gathered in parallel.
+         * @remark Reordering moves every Atom, so all data is uploaded.
+         * @param order order[k] is the insertion index of the k'th Atom to upload.
+         */
+        void updateVertexArray(const std::vector<uint64_t> & order)
+        {
+            const uint64_t n = std::min(uint64_t(order.size()), uint64_t(atoms));
+            uint8_t * ordered = stream->map(instances.size());
+            parallelFor
+            (
+                n,
+                parallelThreads(n),
+                [&](uint64_t begin, uint64_t end, unsigned)
+                {
+                    for (uint64_t k = begin; k < end; k++)
+                    {
+                        std::memcpy(&ordered[k*positionBytes], &instances[order[k]*positionBytes], positionBytes);
+                        std::memcpy(&ordered[idsOffset+k*ID_BYTES], &instances[idsOffset+order[k]*ID_BYTES], ID_BYTES);
+                    }
+                }
+            );
+            stream->unmap();
+            positionsChanged.clear();
+            idsChanged.clear();
+            uploaded = n;
+            pointInstances();
         }
 
     private:
 
-        std::map<uint8_t, SphereMesh> meshes;
+        std::vector<SphereMeshLevel> levels;
+        std::vector<std::shared_future<std::shared_ptr<const SphereMesh>>> pending;
+        std::vector<uint32_t> indexCounts;
         uint32_t size;
         uint8_t levelOfDetail;
-        GLuint vao_mesh, vao_imposter, a_quad, a_positionsAndScales, a_colours;
-        std::vector<GLuint> a_meshVertices, a_meshNormals;
-        std::vector<float> positionsAndScales;
-        std::vector<float> colours;
+        bool compact;
+        uint8_t positionBytes;
+        uint64_t idsOffset;
+        DirtyRange positionsChanged, idsChanged;
+        uint64_t inserted = 0;
+        Quantisation quantisation;
+        GLuint vao_mesh, vao_imposter, a_quad, a_meshAtlas, a_meshIndices, a_commands;
+        std::unique_ptr<StreamBuffer> stream;
+        std::vector<uint8_t> instances;
+        std::unique_ptr<FrustumCull> culler;
+        GLuint vao_meshCulled, vao_imposterCulled;
+        bool aggregatesCreated = false;
+        GLuint vao_aggregates, a_aggregates;
+        uint64_t aggregated = 0;
+        bool points = false;
+
+        /**
+         * @brief The layout glMultiDrawElementsIndirect reads.
+         *
+         */
+        struct DrawElementsIndirectCommand
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+
+            bool operator==(const DrawElementsIndirectCommand & o) const
+            {
+                return count == o.count && instanceCount == o.instanceCount &&
+                    firstIndex == o.firstIndex && baseVertex == o.baseVertex &&
+                    baseInstance == o.baseInstance;
+            }
+            bool operator!=(const DrawElementsIndirectCommand & o) const { return !(*this == o); }
+        };
+
+        bool multiDraw;
+        std::vector<DrawElementsIndirectCommand> commands;
+        std::vector<GLint> baseVertices;
+        std::vector<GLuint> firstIndices;
 
-        uint32_t index = 0;
         uint32_t atoms = 0;
+        uint32_t uploaded = 0;
+
+        /**
+         * @brief Start building a level's mesh, if not already.
+         *
+         * @param level the level of detail.
+         */
+        void request(uint8_t level)
+        {
+            if (indexCounts[level] == 0 && !pending[level].valid())
+            {
+                pending[level] = requestSphereMesh(levels[level]);
+            }
+        }
+
+        /**
+         * @brief The level to draw in place of a level of detail.
+         *
+         * @remark Uploads the level's mesh if its build has finished,
+         * otherwise the finest uploaded coarser level is used. The coarsest
+         * level is cheap, and is waited for if nothing is uploaded.
+         * @param level the level of detail wanted.
+         * @return uint8_t the level with an uploaded mesh.
+         */
+        uint8_t meshLevel(uint8_t level)
+        {
+            level = std::min(size_t(level), levels.size()-1);
+            request(level);
+            if
+            (
+                indexCounts[level] == 0 &&
+                pending[level].wait_for(std::chrono::seconds(0)) == std::future_status::ready
+            )
+            {
+                upload(level);
+            }
+            while (level > 0 && indexCounts[level] == 0) { level--; }
+            if (indexCounts[level] == 0)
+            {
+                request(level);
+                upload(level);
+            }
+            return level;
+        }
+
+        /**
+         * @brief Upload a level's mesh, waiting for its build.
+         *
+         * @param level the level of detail.
+         */
+        void upload(uint8_t level)
+        {
+            std::shared_ptr<const SphereMesh> mesh = pending[level].get();
+            pending[level] = {};
+
+            const uint64_t vertices = mesh->vertices.size()/3;
+            if (vertices > uint64_t(baseVertices[level+1]-baseVertices[level]))
+            {
+                throw std::runtime_error("Sphere mesh has more vertices than its atlas space");
+            }
+            std::vector<float> interleaved(6*vertices);
+            for (uint64_t v = 0; v < vertices; v++)
+            {
+                std::memcpy(&interleaved[6*v], &mesh->vertices[3*v], 3*sizeof(float));
+                std::memcpy(&interleaved[6*v+3], &mesh->normals[3*v], 3*sizeof(float));
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, a_meshAtlas);
+                glBufferSubData
+                (
+                    GL_ARRAY_BUFFER,
+                    ATLAS_STRIDE*baseVertices[level],
+                    sizeof(float)*interleaved.size(),
+                    interleaved.data()
+                );
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            glBindVertexArray(vao_mesh);
+                glBufferSubData
+                (
+                    GL_ELEMENT_ARRAY_BUFFER,
+                    sizeof(uint32_t)*firstIndices[level],
+                    sizeof(uint32_t)*mesh->indices.size(),
+                    mesh->indices.data()
+                );
+            glBindVertexArray(0);
+
+            indexCounts[level] = mesh->indices.size();
+        }
+
+        /**
+         * @brief Depth and culling for Atoms.
+         *
+         * @remark Blending is set by the TransparencyPass.
+         */
+        void drawState()
+        {
+            glEnable(GL_DEPTH_TEST);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_BACK);
+            if (points) { glEnable(GL_PROGRAM_POINT_SIZE); }
+        }
+
+        GLenum impostorMode() const { return points ? GL_POINTS : GL_TRIANGLE_STRIP; }
+
+        GLuint impostorVertices() const { return points ? 1 : GLuint(quad.size()/2); }
+
+        static const uint8_t ATLAS_STRIDE = 6*sizeof(float);
+        static const uint8_t POSITION_BYTES = 3*sizeof(float);
+        static const uint8_t COMPACT_POSITION_BYTES = 3*sizeof(uint16_t);
+        static const uint8_t ID_BYTES = 2;
+        static const uint8_t CULLED_BYTES = 4*sizeof(float);
+        static const uint8_t AGGREGATE_BYTES = 5*sizeof(float);
+
+        /**
+         * @brief Point both vertex arrays at the current stream segment.
+         *
+         */
+        void pointInstances()
+        {
+            glBindVertexArray(vao_mesh);
+                enableInstances(2);
+            glBindVertexArray(vao_imposter);
+                enableInstances(1);
+            glBindVertexArray(0);
+        }
+
+        /**
+         * @brief Point the bound vertex array at the instance data.
+         *
+         * @param position the position attribute, followed by the ids.
+         * @param first the first Atom to point at.
+         */
+        void enableInstances(GLuint position, uint64_t first = 0)
+        {
+            GLuint instances = stream->id();
+            interleavedAttribute
+            (
+                instances,
+                position,
+                3,
+                compact ? GL_UNSIGNED_SHORT : GL_FLOAT,
+                compact,
+                positionBytes,
+                stream->offset()+first*positionBytes,
+                1
+            );
+            interleavedAttribute
+            (
+                instances,
+                position+1,
+                2,
+                GL_UNSIGNED_BYTE,
+                false,
+                ID_BYTES,
+                stream->offset()+idsOffset+first*ID_BYTES,
+                1
+            );
+        }
 
         const std::array<float, 8> quad =
         {
@@ -660,6 +1967,32 @@ private:
             1.0,-1.0,
             1.0,1.0
         };
+
+        /**
+         * @brief An Atom for FrustumCull, read from the instance layout.
+         *
+         * @remark Copied as the position attribute reads it, 3 floats
+         * (normalised when compact), then the Element id and alpha bytes.
+         */
+        const char * cullRecord =
+            "uniform int compact;\n"
+            "uniform uint idsOffset;\n"
+            "uniform vec3 positionOrigin;\n"
+            "uniform vec3 positionExtent;\n"
+            "uniform float scaling;\n"
+            "uniform sampler2D palette;\n"
+            "vec3 stored(uint i)\n"
+            "{\n"
+            "    if (compact == 1) { return vec3(halfWord(3u*i), halfWord(3u*i+1u), halfWord(3u*i+2u))/65535.0; }\n"
+            "    return uintBitsToFloat(uvec3(word(3u*i), word(3u*i+1u), word(3u*i+2u)));\n"
+            "}\n"
+            "uint ids(uint i) { return halfWord(idsOffset/2u+i); }\n"
+            "vec4 bound(uint i)\n"
+            "{\n"
+            "    float radius = texelFetch(palette, ivec2(int(ids(i) & 0xffu), 1), 0).r;\n"
+            "    return vec4(positionOrigin+positionExtent*stored(i), radius*scaling);\n"
+            "}\n"
+            "void copy(uint i, uint slot) { target[slot] = uvec4(floatBitsToUint(stored(i)), ids(i)); }\n";
     };
 
     std::unique_ptr<AtomBuffer> buffer;
@@ -60,17 +60,35 @@ private:
 
     Camera camera;
 
-    std::vector<Atom> axesPoints =
-    {
-        {Element::Unknown, {0,0,0}, 1.0f, {1.0f,1.0,1.0,1.0}},
-        {Element::Unknown, {1,0,0}, 1.0f, {1.0f,0.0,0.0,1.0}},
-        {Element::Unknown, {0,1,0}, 1.0f, {0.0f,1.0,0.0,1.0}},
-        {Element::Unknown, {0,0,1}, 1.0f, {0.0f,0.0,1.0,1.0}}
-    };
+    AtomStore axesPoints = axesAtoms();
 
     const std::vector<Bond> axes {{0, 1}, {0, 2}, {0, 3}};
 
     std::unique_ptr<BondRenderer> renderer;
+
+    /**
+     * @brief The origin and unit points, coloured white, red, green, and blue.
+     *
+     * @remark Each point is a distinct Element with its own Palette colour.
+     */
+    static AtomStore axesAtoms()
+    {
+        AtomStore points =
+        {
+            {Element::Unknown, {0,0,0}},
+            {Element::H, {1,0,0}},
+            {Element::He, {0,1,0}},
+            {Element::Li, {0,0,1}}
+        };
+        Palette palette;
+        palette.setColour(Element::Unknown, {1.0f,1.0,1.0,1.0});
+        palette.setColour(Element::H, {1.0f,0.0,0.0,1.0});
+        palette.setColour(Element::He, {0.0f,1.0,0.0,1.0});
+        palette.setColour(Element::Li, {0.0f,0.0,1.0,1.0});
+        for (Element e : {Element::Unknown, Element::H, Element::He, Element::Li}) { palette.setRadius(e, 1.0f); }
+        points.setPalette(palette);
+        return points;
+    }
 };
 
 #endif /* AXES_H */
@@ -2,6 +2,15 @@
 #define BOND_H
 
 #include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include <atom.h>
+#include <distanceKernel.h>
 
 /**
  * @brief A Bond structure.
@@ -35,24 +44,306 @@ struct Bond
  * @param atoms the Atoms to bond.
  * @param cutOff the distance cutoff below which Atoms are bonded.
  * @return std::vector<Bond> the resulting Bonds.
- * @remark Currently a naive direct distance evaluation.
+ * @remark A direct distance evaluation, vectorised by squaredDistanceWithin.
  */
-std::vector<Bond> determineBonds(std::vector<Atom> & atoms, float cutOff)
+std::vector<Bond> determineBonds(const AtomStore & atoms, float cutOff)
 {
     if (cutOff <= 0.0f) { return {}; }
     std::vector<Bond> bonds;
     bonds.reserve(atoms.size());
+    const std::vector<float> & x = atoms.getX();
+    const std::vector<float> & y = atoms.getY();
+    const std::vector<float> & z = atoms.getZ();
+    std::vector<uint32_t> hits(atoms.size()+DISTANCE_KERNEL_PADDING);
+    const float cutOff2 = cutOff*cutOff;
     for (uint64_t i = 0; i < atoms.size(); i++)
     {
-        for (uint64_t j = i+1; j < atoms.size(); j++)
+        uint64_t j = i+1;
+        uint64_t n = squaredDistanceWithin
+        (
+            x.data()+j, y.data()+j, z.data()+j,
+            atoms.size()-j,
+            atoms.position(i),
+            cutOff2,
+            hits.data()
+        );
+        for (uint64_t k = 0; k < n; k++)
         {
-            if (glm::length(atoms[j].position-atoms[i].position) <= cutOff)
-            {
-                bonds.push_back({i, j});
-            }
+            bonds.push_back({i, j+hits[k]});
         }
     }
     return bonds;
 }
 
+/**
+ * @brief A uniform grid of cubic cells bounding some Atoms.
+ *
+ * @remark Cells are no smaller than a given width, and are enlarged until
+ * there are at most 8 cells per Atom so sparse frames stay bounded.
+ */
+struct CellGrid
+{
+    /**
+     * @brief Construct a CellGrid around some Atoms.
+     *
+     * @param atoms the Atoms to bound.
+     * @param range the minimum cell width.
+     */
+    CellGrid(const AtomStore & atoms, float range)
+    : min(std::numeric_limits<float>::max()), width(range), dims(1)
+    {
+        if (atoms.empty()) { min = glm::vec3(0); return; }
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            min = glm::min(min, atoms.position(i));
+            max = glm::max(max, atoms.position(i));
+        }
+        while (true)
+        {
+            dims = glm::u64vec3(glm::floor((max-min)/width))+glm::u64vec3(1);
+            if (cells() <= 8*atoms.size()) { break; }
+            width *= 2.0f;
+        }
+    }
+
+    glm::vec3 min;
+    float width;
+    glm::u64vec3 dims;
+
+    uint64_t cells() const { return dims.x*dims.y*dims.z; }
+
+    /**
+     * @brief The cell containing a position, clamped to the grid.
+     *
+     */
+    glm::u64vec3 cellOf(const glm::vec3 & r) const
+    {
+        return glm::min(glm::u64vec3(glm::max((r-min)/width, glm::vec3(0.0f))), dims-glm::u64vec3(1));
+    }
+};
+
+/**
+ * @brief Incrementally maintained Bonds using a Verlet skin.
+ *
+ * @remark Candidate pairs within cutOff+skin are found with a cell list
+ * and squaredDistanceWithin on a rebuild. Subsequent frames only re-test
+ * the candidates, so the cost of a frame is proportional to the candidate
+ * count.
+ * @remark A rebuild happens when any Atom has moved more than half the skin
+ * since the last rebuild, or the number of Atoms changes.
+ * @remark Atom indices are assumed to refer to the same atoms between frames.
+ */
+class VerletBondList
+{
+public:
+
+    /**
+     * @brief Construct a new VerletBondList.
+     *
+     * @param cutOff the distance cutoff below which Atoms are bonded.
+     * @param skin the extra distance beyond cutOff to keep candidates for.
+     */
+    VerletBondList(float cutOff, float skin = 0.5f)
+    : cutOff(cutOff), skin(std::max(skin, 0.0f))
+    {}
+
+    /**
+     * @brief Update the Bonds for a new frame of Atoms.
+     *
+     * @param atoms the Atoms to bond.
+     * @return const std::vector<Bond>& the resulting Bonds.
+     */
+    const std::vector<Bond> & update(const AtomStore & atoms)
+    {
+        bonds.clear();
+        if (cutOff <= 0.0f) { return bonds; }
+        if (needsRebuild(atoms)) { rebuild(atoms); }
+
+        const float cutOff2 = cutOff*cutOff;
+        for (const Bond & candidate : candidates)
+        {
+            glm::vec3 r = atoms.position(candidate.atomIndexB)-atoms.position(candidate.atomIndexA);
+            if (glm::dot(r, r) <= cutOff2)
+            {
+                bonds.push_back(candidate);
+            }
+        }
+        return bonds;
+    }
+
+    /**
+     * @brief Check if the candidate pairs must be recalculated.
+     *
+     * @param atoms the Atoms of the new frame.
+     * @return true if any Atom has moved more than half the skin or the
+     * Atom count has changed.
+     * @return false if the candidate pairs are still valid.
+     */
+    bool needsRebuild(const AtomStore & atoms) const
+    {
+        if (atoms.size() != referencePositions.size()) { return true; }
+        const float halfSkin2 = 0.25f*skin*skin;
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            glm::vec3 r = atoms.position(i)-referencePositions[i];
+            if (glm::dot(r, r) > halfSkin2) { return true; }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Force a rebuild on the next update.
+     *
+     */
+    void invalidate() { referencePositions.clear(); }
+
+    /**
+     * @brief Set the bond cutoff.
+     *
+     * @remark Forces a rebuild on the next update.
+     * @param c the distance cutoff below which Atoms are bonded.
+     */
+    void setCutOff(float c) { cutOff = c; invalidate(); }
+
+    /**
+     * @brief Get the bond cutoff.
+     *
+     * @return float the distance cutoff.
+     */
+    float getCutOff() const { return cutOff; }
+
+    /**
+     * @brief Get the skin distance.
+     *
+     * @return float the skin distance.
+     */
+    float getSkin() const { return skin; }
+
+    /**
+     * @brief The current Bonds.
+     *
+     * @return const std::vector<Bond>& the Bonds from the last update.
+     */
+    const std::vector<Bond> & getBonds() const { return bonds; }
+
+    /**
+     * @brief The number of candidate pairs within cutOff+skin.
+     *
+     * @return uint64_t the candidate count.
+     */
+    uint64_t candidateCount() const { return candidates.size(); }
+
+    /**
+     * @brief The number of full rebuilds performed.
+     *
+     * @return uint64_t the rebuild count.
+     */
+    uint64_t rebuildCount() const { return rebuilds; }
+
+private:
+
+    float cutOff;
+    float skin;
+
+    uint64_t rebuilds = 0;
+
+    std::vector<Bond> bonds;
+    std::vector<Bond> candidates;
+    std::vector<glm::vec3> referencePositions;
+
+    std::vector<uint64_t> cellStart;
+    std::vector<uint64_t> cellAtoms;
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<uint32_t> hits;
+
+    void rebuild(const AtomStore & atoms)
+    {
+        rebuilds++;
+        candidates.clear();
+        referencePositions.resize(atoms.size());
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            referencePositions[i] = atoms.position(i);
+        }
+        if (atoms.size() < 2) { return; }
+
+        const float range = cutOff+skin;
+        const float range2 = range*range;
+
+        CellGrid grid(atoms, range);
+        const glm::u64vec3 dims = grid.dims;
+        auto cellOf = [&grid](const glm::vec3 & r) { return grid.cellOf(r); };
+
+        // Counting sort of atoms into cells.
+        cellStart.assign(grid.cells()+1, 0);
+        cellAtoms.resize(atoms.size());
+        std::vector<uint64_t> atomCell(atoms.size());
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            glm::u64vec3 c = cellOf(referencePositions[i]);
+            atomCell[i] = c.x+dims.x*(c.y+dims.y*c.z);
+            cellStart[atomCell[i]+1]++;
+        }
+        for (uint64_t c = 1; c < cellStart.size(); c++) { cellStart[c] += cellStart[c-1]; }
+        std::vector<uint64_t> fill(cellStart.begin(), cellStart.end()-1);
+        for (uint64_t i = 0; i < atoms.size(); i++) { cellAtoms[fill[atomCell[i]]++] = i; }
+
+        // Cell sorted SoA positions, a row of cells along x is then contiguous.
+        x.resize(atoms.size());
+        y.resize(atoms.size());
+        z.resize(atoms.size());
+        for (uint64_t k = 0; k < atoms.size(); k++)
+        {
+            x[k] = referencePositions[cellAtoms[k]].x;
+            y[k] = referencePositions[cellAtoms[k]].y;
+            z[k] = referencePositions[cellAtoms[k]].z;
+        }
+        hits.resize(atoms.size()+DISTANCE_KERNEL_PADDING);
+
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            glm::u64vec3 c = cellOf(referencePositions[i]);
+            glm::u64vec3 lo = glm::u64vec3(c.x > 0 ? c.x-1 : 0, c.y > 0 ? c.y-1 : 0, c.z > 0 ? c.z-1 : 0);
+            glm::u64vec3 hi = glm::min(c+glm::u64vec3(1), dims-glm::u64vec3(1));
+            for (uint64_t cz = lo.z; cz <= hi.z; cz++)
+            {
+                for (uint64_t cy = lo.y; cy <= hi.y; cy++)
+                {
+                    uint64_t row = dims.x*(cy+dims.y*cz);
+                    uint64_t begin = cellStart[lo.x+row];
+                    uint64_t end = cellStart[hi.x+row+1];
+                    uint64_t n = squaredDistanceWithin
+                    (
+                        x.data()+begin, y.data()+begin, z.data()+begin,
+                        end-begin,
+                        referencePositions[i],
+                        range2,
+                        hits.data()
+                    );
+                    for (uint64_t k = 0; k < n; k++)
+                    {
+                        uint64_t j = cellAtoms[begin+hits[k]];
+                        if (j > i) { candidates.push_back({i, j}); }
+                    }
+                }
+            }
+        }
+
+        std::sort
+        (
+            candidates.begin(),
+            candidates.end(),
+            [](const Bond & a, const Bond & b)
+            {
+                return a.atomIndexA < b.atomIndexA ||
+                    (a.atomIndexA == b.atomIndexA && a.atomIndexB < b.atomIndexB);
+            }
+        );
+    }
+};
+
 #endif /* BOND_H */
@@ -0,0 +1,379 @@
+#ifndef BONDCOMPUTE_H
+#define BONDCOMPUTE_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <jGL/OpenGL/gl.h>
+
+#include <glUtils.h>
+#include <atom.h>
+#include <bond.h>
+
+/**
+ * @brief Bond detection with OpenGL compute shaders.
+ *
+ * @remark The passes are,
+ *  1. bin: count Atoms per grid cell.
+ *  2. scan: prefix sum the counts to cell offsets.
+ *  3. scatter: sort Atom indices by cell.
+ *  4. pairs: count each Atom's bonds in the neighbouring cells.
+ *  5. scan: prefix sum the bond counts to output offsets.
+ *  6. emit: compact the bonds into the BondRenderer's instance buffers.
+ * The final pass also writes a glDrawArraysIndirect command, so bonds are
+ * never read back to the CPU.
+ * @remark The uncapped bond count is read back, for sizing, only once a
+ * fence placed after the detection has signalled, @see readTotal.
+ * @remark The grid is found on the CPU, @see CellGrid.
+ * @remark Requires computeShadersAvailable().
+ */
+class BondCompute
+{
+public:
+
+    BondCompute()
+    {
+        bin = compileComputeProgram(header+binShader);
+        scan = compileComputeProgram(PREFIX_SUM_COMPUTE_GLSL);
+        scatter = compileComputeProgram(header+scatterShader);
+        pairs = compileComputeProgram(header+pairShader);
+
+        glGenBuffers(1, &atomData);
+        glGenBuffers(1, &cellCounts);
+        glGenBuffers(1, &cellStarts);
+        glGenBuffers(1, &atomCells);
+        glGenBuffers(1, &cellAtoms);
+        glGenBuffers(1, &bondCounts);
+        glGenBuffers(1, &bondOffsets);
+        glGenBuffers(1, &command);
+
+        // count, instanceCount, first, baseInstance, and the uncapped total.
+        uint32_t initial[5] = {4, 0, 0, 0, 0};
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(initial), initial, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    ~BondCompute()
+    {
+        glDeleteProgram(bin);
+        glDeleteProgram(scan);
+        glDeleteProgram(scatter);
+        glDeleteProgram(pairs);
+        glDeleteBuffers(1, &atomData);
+        glDeleteBuffers(1, &cellCounts);
+        glDeleteBuffers(1, &cellStarts);
+        glDeleteBuffers(1, &atomCells);
+        glDeleteBuffers(1, &cellAtoms);
+        glDeleteBuffers(1, &bondCounts);
+        glDeleteBuffers(1, &bondOffsets);
+        glDeleteBuffers(1, &command);
+        if (fence != nullptr) { glDeleteSync(fence); }
+    }
+
+    /**
+     * @brief Detect bonds, writing BondRenderer instance data.
+     *
+     * @param atoms the Atoms to bond.
+     * @param cutOff the distance cutoff below which Atoms are bonded.
+     * @param instances the instance buffer, per Bond the position and Element
+     * of Atom A, then B, followed by a block of the colour of A, then B.
+     * @param offset the byte offset to write instances from.
+     * @param capacity the number of bonds the instance buffer holds.
+     * @param subset if not null, the indices of the only Atoms to bond.
+     * @remark Bonds beyond capacity are dropped, @see readTotal.
+     */
+    void detect
+    (
+        const AtomStore & atoms,
+        float cutOff,
+        GLuint instances,
+        uint64_t offset,
+        uint64_t capacity,
+        const std::vector<uint64_t> * subset = nullptr
+    )
+    {
+        count = subset == nullptr ? atoms.size() : subset->size();
+        // A detection still in flight is superseded by this one.
+        if (fence != nullptr) { glDeleteSync(fence); fence = nullptr; }
+        if (count == 0 || cutOff <= 0.0f)
+        {
+            total = 0;
+            uint32_t none = 0;
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, sizeof(uint32_t), sizeof(uint32_t), &none);
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 4*sizeof(uint32_t), sizeof(uint32_t), &none);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            return;
+        }
+
+        CellGrid grid(atoms, cutOff);
+        upload(atoms, subset, grid.cells());
+
+        const uint32_t groups = uint32_t((count+WORKGROUP-1)/WORKGROUP);
+
+        // At most 8 storage buffers, the minimum guaranteed.
+        bindBase(0, atomData);
+        bindBase(1, cellCounts);
+        bindBase(2, atomCells);
+        bindBase(3, cellStarts);
+        bindBase(4, cellAtoms);
+        bindBase(5, bondCounts);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 6, instances, offset, capacity*4*sizeof(glm::vec4));
+        bindBase(7, command);
+
+        glUseProgram(bin);
+        setGrid(bin, grid);
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        prefixSum(cellCounts, cellStarts, grid.cells());
+
+        // The counts are reused as per cell fill positions.
+        clear(cellCounts, grid.cells());
+        glUseProgram(scatter);
+        setGrid(scatter, grid);
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(pairs);
+        setGrid(pairs, grid);
+        glUniform1f(glGetUniformLocation(pairs, "cutOff2"), cutOff*cutOff);
+        glUniform1ui(glGetUniformLocation(pairs, "capacity"), GLuint(capacity));
+        glUniform1i(glGetUniformLocation(pairs, "emit"), 0);
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        prefixSum(bondCounts, bondOffsets, count);
+
+        bindBase(1, cellCounts);
+        bindBase(3, cellStarts);
+        bindBase(5, bondOffsets);
+        glUseProgram(pairs);
+        glUniform1i(glGetUniformLocation(pairs, "emit"), 1);
+        glDispatchCompute(groups, 1, 1);
+
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        glUseProgram(0);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    /**
+     * @brief Read back the uncapped bond count of the last detection, if
+     * it has finished.
+     *
+     * @remark Until the detection's fence has signalled the previous count
+     * is kept, so reading never stalls.
+     * @return true if a new count was read.
+     * @return false if the detection is unfinished or already read.
+     */
+    bool readTotal()
+    {
+        if (fence == nullptr) { return false; }
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) { return false; }
+        glDeleteSync(fence);
+        fence = nullptr;
+        uint32_t read = 0;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+        glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 4*sizeof(uint32_t), sizeof(uint32_t), &read);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        total = read;
+        return true;
+    }
+
+    /**
+     * @brief The uncapped bond count last read back.
+     *
+     * @return uint64_t the bond count, @see readTotal.
+     */
+    uint64_t lastTotal() const { return total; }
+
+    /**
+     * @brief The glDrawArraysIndirect command buffer.
+     *
+     * @return GLuint the buffer id.
+     */
+    GLuint commandBuffer() const { return command; }
+
+private:
+
+    static const uint32_t WORKGROUP = 128;
+
+    uint64_t count = 0;
+    uint64_t total = 0;
+    GLsync fence = nullptr;
+
+    GLuint bin, scan, scatter, pairs;
+    GLuint atomData, cellCounts, cellStarts, atomCells, cellAtoms, bondCounts, bondOffsets, command;
+
+    std::vector<float> atomFloats;
+
+    void bindBase(GLuint binding, GLuint buffer)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    }
+
+    void allocate(GLuint buffer, uint64_t bytes, const void * data = NULL)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void clear(GLuint buffer, uint64_t values)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, values*sizeof(uint32_t), GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void upload(const AtomStore & atoms, const std::vector<uint64_t> * subset, uint64_t cells)
+    {
+        // Interleaved position and Element, then colour.
+        atomFloats.resize(8*count);
+        for (uint64_t k = 0; k < count; k++)
+        {
+            const uint64_t i = subset == nullptr ? k : (*subset)[k];
+            const glm::vec4 colour = atoms.colour(i);
+            atomFloats[8*k] = atoms.getX()[i];
+            atomFloats[8*k+1] = atoms.getY()[i];
+            atomFloats[8*k+2] = atoms.getZ()[i];
+            atomFloats[8*k+3] = float(atoms.element(i));
+            atomFloats[8*k+4] = colour.r;
+            atomFloats[8*k+5] = colour.g;
+            atomFloats[8*k+6] = colour.b;
+            atomFloats[8*k+7] = colour.a;
+        }
+        allocate(atomData, atomFloats.size()*sizeof(float), atomFloats.data());
+        allocate(cellCounts, cells*sizeof(uint32_t));
+        allocate(cellStarts, cells*sizeof(uint32_t));
+        allocate(atomCells, count*sizeof(uint32_t));
+        allocate(cellAtoms, count*sizeof(uint32_t));
+        allocate(bondCounts, count*sizeof(uint32_t));
+        allocate(bondOffsets, count*sizeof(uint32_t));
+        clear(cellCounts, cells);
+    }
+
+    void setGrid(GLuint program, const CellGrid & grid)
+    {
+        glUniform3f(glGetUniformLocation(program, "gridMin"), grid.min.x, grid.min.y, grid.min.z);
+        glUniform1f(glGetUniformLocation(program, "cellWidth"), grid.width);
+        glUniform3ui(glGetUniformLocation(program, "dims"), GLuint(grid.dims.x), GLuint(grid.dims.y), GLuint(grid.dims.z));
+        glUniform1ui(glGetUniformLocation(program, "atomCount"), GLuint(count));
+    }
+
+    /**
+     * @brief Exclusive prefix sum of input into output.
+     *
+     * @remark Single work group, looping over blocks with a carry.
+     */
+    void prefixSum(GLuint input, GLuint output, uint64_t values)
+    {
+        bindBase(1, input);
+        bindBase(3, output);
+        glUseProgram(scan);
+        glUniform1ui(glGetUniformLocation(scan, "count"), GLuint(values));
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    const std::string header =
+        "#version 430\n"
+        "layout(local_size_x = 128) in;\n"
+        "layout(std430, binding = 0) readonly buffer Atoms { vec4 atoms[]; };\n"
+        "uniform vec3 gridMin;\n"
+        "uniform float cellWidth;\n"
+        "uniform uvec3 dims;\n"
+        "uniform uint atomCount;\n"
+        "uvec3 cellOf(vec3 r) { return min(uvec3(max((r-gridMin)/cellWidth, vec3(0.0))), dims-uvec3(1)); }\n"
+        "uint cellIndex(uvec3 c) { return c.x+dims.x*(c.y+dims.y*c.z); }\n"
+        "vec4 positionAndElement(uint i) { return atoms[2u*i]; }\n"
+        "vec4 colour(uint i) { return atoms[2u*i+1u]; }\n";
+
+    const char * binShader =
+        "layout(std430, binding = 1) buffer CellCounts { uint cellCounts[]; };\n"
+        "layout(std430, binding = 2) writeonly buffer AtomCells { uint atomCells[]; };\n"
+        "void main()\n"
+        "{\n"
+        "    uint i = gl_GlobalInvocationID.x;\n"
+        "    if (i >= atomCount) { return; }\n"
+        "    uint c = cellIndex(cellOf(positionAndElement(i).xyz));\n"
+        "    atomCells[i] = c;\n"
+        "    atomicAdd(cellCounts[c], 1u);\n"
+        "}";
+
+    const char * scatterShader =
+        "layout(std430, binding = 1) buffer CellFill { uint cellFill[]; };\n"
+        "layout(std430, binding = 2) readonly buffer AtomCells { uint atomCells[]; };\n"
+        "layout(std430, binding = 3) readonly buffer CellStarts { uint cellStarts[]; };\n"
+        "layout(std430, binding = 4) writeonly buffer CellAtoms { uint cellAtoms[]; };\n"
+        "void main()\n"
+        "{\n"
+        "    uint i = gl_GlobalInvocationID.x;\n"
+        "    if (i >= atomCount) { return; }\n"
+        "    uint c = atomCells[i];\n"
+        "    cellAtoms[cellStarts[c]+atomicAdd(cellFill[c], 1u)] = i;\n"
+        "}";
+
+    const char * pairShader =
+        "layout(std430, binding = 1) readonly buffer CellCounts { uint cellCounts[]; };\n"
+        "layout(std430, binding = 3) readonly buffer CellStarts { uint cellStarts[]; };\n"
+        "layout(std430, binding = 4) readonly buffer CellAtoms { uint cellAtoms[]; };\n"
+        // Bond counts when counting, offsets when emitting.
+        "layout(std430, binding = 5) buffer Bonds { uint bondCounts[]; };\n"
+        "layout(std430, binding = 6) writeonly buffer Instances { vec4 instances[]; };\n"
+        "layout(std430, binding = 7) buffer Command { uint vertices; uint instanceCount; uint first; uint baseInstance; uint total; };\n"
+        "uniform float cutOff2;\n"
+        "uniform uint capacity;\n"
+        "uniform int emit;\n"
+        "void main()\n"
+        "{\n"
+        "    uint i = gl_GlobalInvocationID.x;\n"
+        "    if (i >= atomCount) { return; }\n"
+        "    vec4 ri = positionAndElement(i);\n"
+        "    vec3 r = ri.xyz;\n"
+        "    ivec3 c = ivec3(cellOf(r));\n"
+        "    ivec3 lo = max(c-ivec3(1), ivec3(0));\n"
+        "    ivec3 hi = min(c+ivec3(1), ivec3(dims)-ivec3(1));\n"
+        "    uint offset = emit == 1 ? bondCounts[i] : 0u;\n"
+        "    uint n = 0u;\n"
+        "    for (int z = lo.z; z <= hi.z; z++)\n"
+        "    {\n"
+        "        for (int y = lo.y; y <= hi.y; y++)\n"
+        "        {\n"
+        "            for (int x = lo.x; x <= hi.x; x++)\n"
+        "            {\n"
+        "                uint cell = cellIndex(uvec3(x, y, z));\n"
+        "                uint start = cellStarts[cell];\n"
+        "                for (uint k = start; k < start+cellCounts[cell]; k++)\n"
+        "                {\n"
+        "                    uint j = cellAtoms[k];\n"
+        "                    if (j <= i) { continue; }\n"
+        "                    vec4 rj = positionAndElement(j);\n"
+        "                    vec3 d = rj.xyz-r;\n"
+        "                    if (dot(d, d) > cutOff2) { continue; }\n"
+        "                    uint slot = offset+n;\n"
+        "                    if (emit == 1 && slot < capacity)\n"
+        "                    {\n"
+        "                        instances[2u*slot] = ri;\n"
+        "                        instances[2u*slot+1u] = rj;\n"
+        "                        instances[2u*capacity+2u*slot] = colour(i);\n"
+        "                        instances[2u*capacity+2u*slot+1u] = colour(j);\n"
+        "                    }\n"
+        "                    n++;\n"
+        "                }\n"
+        "            }\n"
+        "        }\n"
+        "    }\n"
+        "    if (emit == 0) { bondCounts[i] = n; }\n"
+        "    else if (i == atomCount-1u)\n"
+        "    {\n"
+        "        total = offset+n;\n"
+        "        instanceCount = min(offset+n, capacity);\n"
+        "    }\n"
+        "}";
+};
+
+#endif /* BONDCOMPUTE_H */
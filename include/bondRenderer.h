@@ -3,13 +3,33 @@
 
 #include <jGL/OpenGL/gl.h>
 
+#include <cstring>
+
 #include <glUtils.h>
+#include <streamBuffer.h>
+#include <quantise.h>
 #include <atom.h>
 #include <bond.h>
+#include <bondCompute.h>
+#include <emphasis.h>
+#include <visibility.h>
+#include <transparency.h>
+#include <frustum.h>
+#include <frustumCull.h>
+#include <parallel.h>
 
 /**
  * @brief Render Bonds as ray-traced cylinders.
  *
+ * @remark Compact buffers quantise positions to 16 bits in the bounding
+ * box of the Atoms and colours to RGBA8, 24 bytes per bond rather than 64,
+ * @see Quantisation.
+ * @remark Each end carries its Atom's Element, for the Emphasis mask.
+ * @remark Bonds to hidden Atoms are not uploaded, @see Visibility.
+ * @remark Bond positions and colours are held in separate blocks and only
+ * their changed ranges are uploaded, @see StreamBuffer.
+ * @remark Bonds outside the Camera's Frustum can be culled before drawing,
+ * @see setFrustumCulling.
  */
 class BondRenderer
 {
@@ -21,14 +41,16 @@ public:
      * @param bonds the current Bonds between atoms.
      * @param atoms the Atoms with bonds Bonds.
      * @param maxBonds a hint to the maximum number of Bonds.
+     * @param compact quantise positions to 16 bits and colours to 8.
      */
     BondRenderer
     (
         const std::vector<Bond> & bonds,
-        const std::vector<Atom> & atoms,
-        uint64_t maxBonds
+        const AtomStore & atoms,
+        uint64_t maxBonds,
+        bool compact = false
     )
-    : bonds(0), maxBonds(maxBonds)
+    : bonds(0), maxBonds(std::max({maxBonds, uint64_t(bonds.size()), uint64_t(1)})), compact(compact)
     {
         shader = std::make_unique<jGL::GL::glShader>(vertexShader, fragmentShader);
         shader->use();
@@ -36,24 +58,19 @@ public:
         shader->setUniform<glm::vec4>("lightColour", glm::vec4(1.0f,1.0f,1.0f,1.0f));
         shader->setUniform<float>("ambientLight", 0.1f);
         setBondScale(1.0f);
+        setModel(glm::mat4(1.0f));
+        setEmphasis(Emphasis());
+        setTransparencyPass(TransparencyPass::BLENDED);
         init();
 
-        for (const Bond & bond : bonds)
-        {
-            insert(bond, atoms);
-        }
-
-        updateVertexArray();
+        update(bonds, atoms);
     }
 
     ~BondRenderer()
     {
         glDeleteVertexArrays(1, &vao);
-        glDeleteBuffers(1, &a_vertices);
-        glDeleteBuffers(1, &b_vertices);
-        glDeleteBuffers(1, &a_colours);
-        glDeleteBuffers(1, &b_colours);
         glDeleteBuffers(1, &a_quad);
+        if (culler != nullptr) { glDeleteVertexArrays(1, &vao_culled); }
     }
 
     /**
@@ -119,6 +136,82 @@ public:
         shader->setUniform<glm::vec4>("lightPos", glm::vec4(cameraPosition, 1.0f));
         setView(camera.getView());
         setProjection(camera.getProjection());
+        if (pv != camera.getPV()) { cullNeedsUpdate = true; }
+        pv = camera.getPV();
+    }
+
+    /**
+     * @brief Set the model matrix, placing the Bonds in the scene.
+     *
+     * @param model the model matrix.
+     */
+    void setModel(glm::mat4 model)
+    {
+        shader->use();
+        shader->setUniform<glm::mat4>("model", model);
+        if (this->model != model) { cullNeedsUpdate = true; }
+        this->model = model;
+    }
+
+    /**
+     * @brief Set which Elements are emphasised.
+     *
+     * @remark Each end of a Bond takes its Atom's emphasis. Sets uniforms
+     * only, no Bond data is uploaded.
+     * @param emphasis the Element emphasis.
+     */
+    void setEmphasis(const Emphasis & emphasis)
+    {
+        shader->use();
+        for (uint8_t w = 0; w < EMPHASIS_WORDS; w++)
+        {
+            shader->setUniform<int>("deemphasised"+std::to_string(w), int(emphasis.getMask()[w]));
+        }
+        shader->setUniform<float>("deemphasisAlpha", emphasis.getDeemphasisAlpha());
+    }
+
+    /**
+     * @brief Set which fragments are drawn, and how.
+     *
+     * @remark Each end of a Bond is opaque or translucent with its Atom.
+     * @param p the TransparencyPass.
+     */
+    void setTransparencyPass(TransparencyPass p)
+    {
+        shader->use();
+        shader->setUniform<int>("transparencyPass", int(p));
+        pass = p;
+    }
+
+    /**
+     * @brief Set which Atoms' Bonds are drawn.
+     *
+     * @remark Bonds with a hidden end are skipped from the next update.
+     * @param v the Visibility.
+     */
+    void setVisibility(const Visibility & v)
+    {
+        visibility = v;
+        filtered = visibility.hidesAny();
+    }
+
+    /**
+     * @brief Only draw Bonds whose bounding spheres meet the Camera's Frustum.
+     *
+     * @remark With compute shaders Bonds are culled on the GPU, also those
+     * found there, and drawn indirectly, @see FrustumCull. Otherwise Bonds
+     * in view are gathered on the CPU each time the Camera or Bonds move.
+     * @param enabled whether to cull.
+     */
+    void setFrustumCulling(bool enabled)
+    {
+        culling = enabled;
+        cullNeedsUpdate = true;
+        // The stream may hold only Bonds in view, resend them all.
+        if (!enabled && !indirect && stream->update(instances.data(), instances.size(), {}))
+        {
+            pointInstances();
+        }
     }
 
     /**
@@ -130,6 +223,8 @@ public:
     {
         shader->use();
         shader->setUniform<float>("bondScale", scale);
+        if (bondScale != scale) { cullNeedsUpdate = true; }
+        bondScale = scale;
     }
 
     /**
@@ -139,51 +234,174 @@ public:
      */
     uint32_t triangles() const
     {
-        return bonds*2;
+        if (!culling) { return bonds*2; }
+        return (culler != nullptr ? culler->lastCount() : inView.size())*2;
     }
 
     /**
      * @brief Update the bonds rendered on the GPU.
      *
+     * @remark Only changed positions and colours are uploaded.
+     * @remark Bonds with a hidden end are compacted out.
      * @param bonds the new bonds.
      * @param atoms the new atoms.
      */
     void update
     (
         const std::vector<Bond> & bonds,
-        const std::vector<Atom> & atoms
+        const AtomStore & atoms
     )
     {
+        if (bonds.size() > maxBonds) { reserve(bonds.size()); }
+        indirect = false;
         flip();
+        if (compact) { quantisation = Quantisation(atoms); }
+        setQuantisation(quantisation);
         for (const Bond & bond : bonds)
         {
+            if
+            (
+                filtered &&
+                (
+                    visibility.isHidden(bond.atomIndexA, atoms.element(bond.atomIndexA)) ||
+                    visibility.isHidden(bond.atomIndexB, atoms.element(bond.atomIndexB))
+                )
+            )
+            {
+                continue;
+            }
             insert(bond, atoms);
         }
-        updateVertexArray();
+        // Bonds past the last insert may be stale on the GPU.
+        if (this->bonds > inserted)
+        {
+            positionsChanged.mark(inserted, this->bonds);
+            coloursChanged.mark(inserted, this->bonds);
+        }
+        inserted = this->bonds;
+        std::vector<ByteRange> changed =
+        {
+            positionsChanged.bytes(0, positionBytes()),
+            coloursChanged.bytes(colourOffset(), colourBytes())
+        };
+        positionsChanged.clear();
+        coloursChanged.clear();
+        if (stream->update(instances.data(), instances.size(), changed))
+        {
+            pointInstances();
+        }
+        cullNeedsUpdate = true;
+    }
+
+    /**
+     * @brief Detect and update the bonds on the GPU.
+     *
+     * @remark Bonds are written straight to the next segment of the instance
+     * stream and drawn indirectly, @see BondCompute.
+     * @remark The instance buffer grows when a finished detection
+     * overflowed it, @see gpuBondsDropped. The bond count (for triangles)
+     * lags until the detection has finished.
+     * @remark Compute shaders write floats, so a compact BondRenderer
+     * reverts to the full layout.
+     * @remark Only shown Atoms are given to the detection.
+     * @param atoms the Atoms to bond.
+     * @param cutOff the distance cutoff below which Atoms are bonded.
+     * @return true if the bonds were updated.
+     * @return false if compute shaders are unavailable, use update.
+     */
+    bool updateOnGPU(const AtomStore & atoms, float cutOff)
+    {
+        if (!computeShadersAvailable()) { return false; }
+        if (compact)
+        {
+            compact = false;
+            quantisation = Quantisation();
+            setQuantisation(quantisation);
+            reserve(maxBonds);
+        }
+        if (compute == nullptr)
+        {
+            compute = std::make_unique<BondCompute>();
+            if (maxBonds < atoms.size()) { reserve(atoms.size()); }
+        }
+        else
+        {
+            compute->readTotal();
+            uint64_t total = compute->lastTotal();
+            if (total > maxBonds) { reserve(total); }
+            bonds = uint32_t(total);
+        }
+        uint64_t offset = stream->claim();
+        if (filtered) { visibility.visibleAtoms(atoms, visible); }
+        compute->detect(atoms, cutOff, stream->id(), offset, maxBonds, filtered ? &visible : nullptr);
+        pointInstances();
+        indirect = true;
+        cullNeedsUpdate = true;
+        return true;
+    }
+
+    /**
+     * @brief Whether the last detection on the GPU dropped bonds for want
+     * of space.
+     *
+     * @remark Never waits on the GPU, so is false until the detection has
+     * finished. If true, detect again with updateOnGPU, which first grows
+     * the instance buffer to fit.
+     * @return true if bonds were dropped.
+     * @return false if all bonds were drawn, or are not yet known.
+     */
+    bool gpuBondsDropped()
+    {
+        if (compute == nullptr || !indirect) { return false; }
+        compute->readTotal();
+        bonds = uint32_t(std::min(compute->lastTotal(), maxBonds));
+        return compute->lastTotal() > maxBonds;
     }
 
     /**
      * @brief Draw the bonds.
      *
      * @param count override number of bonds.
+     * @remark count is ignored for bonds found on the GPU.
      */
     void draw(uint32_t count)
     {
+        if (culling && cullNeedsUpdate)
+        {
+            cull();
+            cullNeedsUpdate = false;
+        }
+        else if (culling && culler != nullptr) { culler->readCount(); }
         count = std::min(count, bonds);
-        if (count == 0) { return; }
+        if (culling && culler == nullptr) { count = std::min(count, uint32_t(inView.size())); }
+        if (count == 0 && !indirect) { return; }
 
         shader->use();
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_DEPTH_TEST);
+        transparencyState(pass);
         glEnable(GL_CULL_FACE);
         glCullFace(GL_BACK);
 
         glFrontFace(GL_CW);
         glBindVertexArray(vao);
 
-            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+            if (culling && culler != nullptr)
+            {
+                glBindVertexArray(vao_culled);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler->commandBuffer());
+                glDrawArraysIndirect(GL_TRIANGLE_STRIP, 0);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            }
+            else if (indirect)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, compute->commandBuffer());
+                glDrawArraysIndirect(GL_TRIANGLE_STRIP, 0);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            }
+            else
+            {
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+            }
 
         glBindVertexArray(0);
         glFrontFace(GL_CCW);
@@ -199,19 +417,56 @@ public:
 private:
 
     uint32_t bonds;
-    uint32_t maxBonds;
+    uint64_t maxBonds;
+    std::unique_ptr<BondCompute> compute;
+    bool indirect = false;
+    bool compact;
+    Quantisation quantisation;
     std::unique_ptr<jGL::GL::glShader> shader;
     glm::vec3 cameraPosition;
+    Visibility visibility;
+    bool filtered = false;
+    std::vector<uint64_t> visible;
+    TransparencyPass pass = TransparencyPass::BLENDED;
+    glm::mat4 pv = glm::mat4(0.0f);
+    glm::mat4 model = glm::mat4(1.0f);
+    float bondScale = 1.0f;
+    bool culling = false;
+    bool cullNeedsUpdate = true;
+    std::unique_ptr<FrustumCull> culler;
+    std::vector<uint64_t> inView;
+
+    GLuint vao, a_quad, vao_culled;
 
-    GLuint vao, a_vertices, b_vertices, a_colours, b_colours, a_quad;
-    std::vector<float> positionsAAndScale;
-    std::vector<float> positionsBAndScale;
-    std::vector<float> coloursA;
-    std::vector<float> coloursB;
+    /**
+     * @brief Per Bond instance data, a block of positions then of colours.
+     *
+     * @remark Position and Element of Atom A, then B. Colour of A, then B.
+     * @remark When compact, quantised positions and Elements of A then B.
+     * RGBA8 colours of A then B.
+     */
+    std::vector<uint8_t> instances;
+    std::unique_ptr<StreamBuffer> stream;
+    DirtyRange positionsChanged, coloursChanged;
+    uint64_t inserted = 0;
 
     glm::mat4 view, projection;
 
-    uint32_t index = 0;
+    static const uint8_t POSITION_BYTES = 2*4*sizeof(float);
+    static const uint8_t COMPACT_POSITION_BYTES = 2*4*sizeof(uint16_t);
+    static const uint8_t COLOUR_BYTES = 2*4*sizeof(float);
+    static const uint8_t COMPACT_COLOUR_BYTES = 2*4;
+    static const uint8_t CULLED_BYTES = 4*4*sizeof(float);
+
+    uint8_t positionBytes() const { return compact ? COMPACT_POSITION_BYTES : POSITION_BYTES; }
+    uint8_t colourBytes() const { return compact ? COMPACT_COLOUR_BYTES : COLOUR_BYTES; }
+
+    /**
+     * @brief The byte offset of the colour block.
+     *
+     * @remark For the full layout this is 2 vec4 per Bond, as BondCompute writes.
+     */
+    uint64_t colourOffset() const { return maxBonds*positionBytes(); }
 
     const std::array<float, 8> quad =
     {
@@ -221,19 +476,64 @@ private:
         1.0,1.0
     };
 
+    /**
+     * @brief A Bond for FrustumCull, read from the instance layout.
+     *
+     * @remark Copied as the attributes read it, ends then colours as vec4
+     * (normalised when compact).
+     */
+    const char * cullRecord =
+        "uniform int compact;\n"
+        "uniform uint capacity;\n"
+        "uniform vec3 positionOrigin;\n"
+        "uniform vec3 positionExtent;\n"
+        "uniform float bondScale;\n"
+        "vec4 end(uint i, uint e)\n"
+        "{\n"
+        "    uint h = 8u*i+4u*e;\n"
+        "    if (compact == 1) { return vec4(halfWord(h), halfWord(h+1u), halfWord(h+2u), halfWord(h+3u))/65535.0; }\n"
+        "    return uintBitsToFloat(uvec4(word(h), word(h+1u), word(h+2u), word(h+3u)));\n"
+        "}\n"
+        "vec4 colour(uint i, uint e)\n"
+        "{\n"
+        "    if (compact == 1)\n"
+        "    {\n"
+        "        uint b = 16u*capacity+8u*i+4u*e;\n"
+        "        return vec4(byteOf(b), byteOf(b+1u), byteOf(b+2u), byteOf(b+3u))/255.0;\n"
+        "    }\n"
+        "    uint w = 8u*capacity+8u*i+4u*e;\n"
+        "    return uintBitsToFloat(uvec4(word(w), word(w+1u), word(w+2u), word(w+3u)));\n"
+        "}\n"
+        "vec4 bound(uint i)\n"
+        "{\n"
+        "    vec3 a = positionOrigin+positionExtent*end(i, 0u).xyz;\n"
+        "    vec3 b = positionOrigin+positionExtent*end(i, 1u).xyz;\n"
+        "    return vec4(0.5*(a+b), 0.5*length(b-a)+bondScale);\n"
+        "}\n"
+        "void copy(uint i, uint slot)\n"
+        "{\n"
+        "    target[4u*slot] = floatBitsToUint(end(i, 0u));\n"
+        "    target[4u*slot+1u] = floatBitsToUint(end(i, 1u));\n"
+        "    target[4u*slot+2u] = floatBitsToUint(colour(i, 0u));\n"
+        "    target[4u*slot+3u] = floatBitsToUint(colour(i, 1u));\n"
+        "}\n";
+
     const char * vertexShader =
         "#version " GLSL_VERSION "\n"
         "precision lowp float; precision lowp int;\n"
         "layout(location=0) in vec2 a_vertices;\n"
-        "layout(location=1) in vec4 a_positionsAAndScales;\n"
-        "layout(location=2) in vec4 a_positionsBAndScales;\n"
+        "layout(location=1) in vec4 a_positionsAAndElements;\n"
+        "layout(location=2) in vec4 a_positionsBAndElements;\n"
         "layout(location=3) in vec4 a_colours;\n"
         "layout(location=4) in vec4 b_colours;\n"
         "out vec2 billboard;\n"
         "uniform mat4 view;\n"
         "uniform mat4 proj;\n"
+        "uniform mat4 model;\n"
         "uniform float clipCorrection;\n"
         "uniform float bondScale;\n"
+        "uniform vec4 positionOrigin;\n"
+        "uniform vec4 positionExtent;\n"
         "out vec4 aPosScale;\n"
         "out vec3 aViewPos;\n"
         "out vec4 bPosScale;\n"
@@ -241,17 +541,24 @@ private:
         "out vec4 a_colour;\n"
         "out vec4 b_colour;\n"
         "out vec3 comViewPos;\n"
+        EMPHASIS_GLSL
+        TRANSPARENCY_VERTEX_GLSL
         "void main()\n"
         "{\n"
         "    billboard = a_vertices * clipCorrection;\n"
-        "    aViewPos = (view * vec4(a_positionsAAndScales.xyz, 1.0)).xyz;"
-        "    bViewPos = (view * vec4(a_positionsBAndScales.xyz, 1.0)).xyz;"
+        "    vec3 a = (model*vec4(positionOrigin.xyz+positionExtent.xyz*a_positionsAAndElements.xyz, 1.0)).xyz;\n"
+        "    vec3 b = (model*vec4(positionOrigin.xyz+positionExtent.xyz*a_positionsBAndElements.xyz, 1.0)).xyz;\n"
+        "    aViewPos = (view * vec4(a, 1.0)).xyz;"
+        "    bViewPos = (view * vec4(b, 1.0)).xyz;"
         "    comViewPos = (aViewPos+bViewPos)*0.5;\n"
         "    gl_Position = proj * (vec4(comViewPos, 1.0)+vec4(bondScale * a_vertices * clipCorrection, 0.0, 1.0));"
-        "    aPosScale = a_positionsAAndScales;\n"
-        "    bPosScale = a_positionsBAndScales;\n"
+        "    aPosScale = vec4(a, bondScale);\n"
+        "    bPosScale = vec4(b, bondScale);\n"
         "    a_colour = a_colours;\n"
         "    b_colour = b_colours;\n"
+        "    a_colour.a *= emphasis(int(round(positionExtent.w*a_positionsAAndElements.w)));\n"
+        "    b_colour.a *= emphasis(int(round(positionExtent.w*a_positionsBAndElements.w)));\n"
+        "    if (passCulls(a_colour.a) && passCulls(b_colour.a)) { gl_Position = vec4(0.0, 0.0, 2.0, 1.0); }\n"
         "}";
 
     const char * fragmentShader =
@@ -265,7 +572,7 @@ private:
         "in vec4 a_colour;\n"
         "in vec4 b_colour;\n"
         "in vec3 comViewPos;\n"
-        "out vec4 colour;\n"
+        TRANSPARENCY_FRAGMENT_GLSL
         "uniform mat4 view;\n"
         "uniform mat4 proj;\n"
         "uniform vec4 lightPos;\n"
@@ -359,7 +666,7 @@ private:
         "       float diff = max(dot(viewNormal, normalize(lightViewPos-projectedHitPoint)), 0.0);\n"
         "       vec4 col = a_colour;\n"
         "       if (s > 0.5*midLength) { col = b_colour; }\n"
-        "       colour = vec4((ambientLight + diff)*lightColour.rgb * col.rgb, col.a);\n"
+        "       writeColour(vec4((ambientLight + diff)*lightColour.rgb * col.rgb, col.a));\n"
         "    }\n"
         "}";
 
@@ -369,20 +676,19 @@ private:
         shader->setUniform<glm::mat4>("proj", projection);
     }
 
+    void setQuantisation(const Quantisation & q)
+    {
+        shader->use();
+        shader->setUniform<glm::vec4>("positionOrigin", glm::vec4(q.origin, 0.0f));
+        // w dequantises the Element ids.
+        shader->setUniform<glm::vec4>("positionExtent", glm::vec4(q.extent, compact ? float(Quantisation::LEVELS) : 1.0f));
+    }
+
     void init()
     {
         glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &a_vertices);
-        glGenBuffers(1, &b_vertices);
-        glGenBuffers(1, &a_colours);
-        glGenBuffers(1, &b_colours);
         glGenBuffers(1, &a_quad);
 
-        positionsAAndScale.resize(4*maxBonds);
-        positionsBAndScale.resize(4*maxBonds);
-        coloursA.resize(4*maxBonds);
-        coloursB.resize(4*maxBonds);
-
         glBindVertexArray(vao);
 
             createBuffer
@@ -396,111 +702,223 @@ private:
                 0
             );
 
-            createBuffer
-            (
-                a_vertices,
-                positionsAAndScale.data(),
-                positionsAAndScale.size(),
-                GL_DYNAMIC_DRAW,
-                1,
-                4,
-                1
-            );
+        glBindVertexArray(0);
 
-            createBuffer
-            (
-                b_vertices,
-                positionsBAndScale.data(),
-                positionsBAndScale.size(),
-                GL_DYNAMIC_DRAW,
-                2,
-                4,
-                1
-            );
+        reserve(maxBonds);
+    }
 
-            createBuffer
-            (
-                a_colours,
-                coloursA.data(),
-                coloursA.size(),
-                GL_DYNAMIC_DRAW,
-                3,
-                4,
-                1
-            );
+    /**
+     * @brief Grow the GPU buffers to hold more Bonds.
+     *
+     * @remark Reallocates with headroom so a slowly growing bond count does
+     * not reallocate every frame.
+     * @param count the number of Bonds required.
+     */
+    void reserve(uint64_t count)
+    {
+        maxBonds = count+count/4;
+        instances.assign(maxBonds*(positionBytes()+colourBytes()), 0);
+        // The colour block moved, so every Bond is rewritten.
+        inserted = 0;
+        if (stream == nullptr) { stream = std::make_unique<StreamBuffer>(instances.size()); }
+        else { stream->reserve(instances.size()); }
+        pointInstances();
+    }
 
-            createBuffer
-            (
-                b_colours,
-                coloursB.data(),
-                coloursB.size(),
-                GL_DYNAMIC_DRAW,
-                4,
-                4,
-                1
-            );
+    /**
+     * @brief Point the vertex array at the current stream segment.
+     *
+     */
+    void pointInstances()
+    {
+        GLuint id = stream->id();
+        const uint64_t offset = stream->offset();
+        glBindVertexArray(vao);
+            for (GLuint attribute = 1; attribute < 3; attribute++)
+            {
+                interleavedAttribute
+                (
+                    id,
+                    attribute,
+                    4,
+                    compact ? GL_UNSIGNED_SHORT : GL_FLOAT,
+                    compact,
+                    positionBytes(),
+                    offset+(attribute-1)*positionBytes()/2,
+                    1
+                );
+            }
+            for (GLuint attribute = 3; attribute < 5; attribute++)
+            {
+                interleavedAttribute
+                (
+                    id,
+                    attribute,
+                    4,
+                    compact ? GL_UNSIGNED_BYTE : GL_FLOAT,
+                    compact,
+                    colourBytes(),
+                    offset+colourOffset()+(attribute-3)*colourBytes()/2,
+                    1
+                );
+            }
         glBindVertexArray(0);
     }
 
+    /**
+     * @brief Keep the Bonds whose bounding spheres meet the Frustum.
+     *
+     * @remark A Bond is bounded by the sphere through its ends' centres,
+     * grown by the bond radius.
+     * @remark On the GPU the kept Bonds are copied, in order, as 4 vec4
+     * (dequantised when compact) to a buffer of their own.
+     */
+    void cull()
+    {
+        const Frustum frustum(pv*model);
+        if (computeShadersAvailable())
+        {
+            if (culler == nullptr)
+            {
+                culler = std::make_unique<FrustumCull>(cullRecord, 4);
+                GLuint culled = culler->targetBuffer();
+                glGenVertexArrays(1, &vao_culled);
+                glBindVertexArray(vao_culled);
+                    interleavedAttribute(a_quad, 0, 2, GL_FLOAT, false, 2*sizeof(float), 0, 0);
+                    for (GLuint attribute = 1; attribute < 5; attribute++)
+                    {
+                        interleavedAttribute(culled, attribute, 4, GL_FLOAT, false, CULLED_BYTES, (attribute-1)*CULLED_BYTES/4, 1);
+                    }
+                glBindVertexArray(0);
+            }
+            culler->use();
+            glUniform1i(culler->uniform("compact"), compact ? 1 : 0);
+            glUniform1ui(culler->uniform("capacity"), GLuint(maxBonds));
+            glUniform3f(culler->uniform("positionOrigin"), quantisation.origin.x, quantisation.origin.y, quantisation.origin.z);
+            glUniform3f(culler->uniform("positionExtent"), quantisation.extent.x, quantisation.extent.y, quantisation.extent.z);
+            glUniform1f(culler->uniform("bondScale"), bondScale);
+            if (indirect) { culler->cull(frustum, stream->id(), stream->offset(), maxBonds, compute->commandBuffer()); }
+            else { culler->cull(frustum, stream->id(), stream->offset(), bonds); }
+            return;
+        }
+
+        parallelCompact
+        (
+            bonds,
+            [&](uint64_t k)
+            {
+                const glm::vec3 a = end(k, 0);
+                const glm::vec3 b = end(k, 1);
+                return frustum.intersects(0.5f*(a+b), 0.5f*glm::length(b-a)+bondScale);
+            },
+            inView
+        );
+        // Kept Bonds are gathered in the instance layout.
+        uint8_t * culled = stream->map(instances.size());
+        const uint64_t n = inView.size();
+        parallelFor
+        (
+            n,
+            parallelThreads(n),
+            [&](uint64_t begin, uint64_t end, unsigned)
+            {
+                for (uint64_t k = begin; k < end; k++)
+                {
+                    const uint64_t i = inView[k];
+                    std::memcpy(&culled[k*positionBytes()], &instances[i*positionBytes()], positionBytes());
+                    std::memcpy(&culled[colourOffset()+k*colourBytes()], &instances[colourOffset()+i*colourBytes()], colourBytes());
+                }
+            }
+        );
+        stream->unmap();
+        pointInstances();
+    }
+
+    /**
+     * @brief The position of an end of an inserted Bond.
+     *
+     * @param k the Bond.
+     * @param which 0 for Atom A, 1 for Atom B.
+     * @return glm::vec3 the (dequantised) position.
+     */
+    glm::vec3 end(uint64_t k, uint8_t which) const
+    {
+        const uint8_t * position = &instances[k*positionBytes()+which*positionBytes()/2];
+        if (compact)
+        {
+            glm::u16vec3 q;
+            std::memcpy(&q, position, sizeof(q));
+            return quantisation.dequantise(q);
+        }
+        glm::vec3 r;
+        std::memcpy(&r, position, sizeof(r));
+        return r;
+    }
+
     /**
      * @brief Set the buffer position to the start.
      *
      */
-    void flip() { index = 0; bonds = 0; }
+    void flip() { bonds = 0; }
 
     /**
      * @brief Insert (update) a Bonds data.
      *
+     * @remark Marks the Bond's position or colour changed if it differs.
      * @param bond the Bond data to insert.
      * @param atoms the Atom data the Bond data refers to.
      */
     void insert
     (
         const Bond & bond,
-        const std::vector<Atom> & atoms
+        const AtomStore & atoms
     )
     {
-        const Atom & a = atoms[bond.atomIndexA];
-        const Atom & b = atoms[bond.atomIndexB];
-
-        positionsAAndScale[index] = a.position.x;
-        positionsAAndScale[index+1] = a.position.y;
-        positionsAAndScale[index+2] = a.position.z;
-        positionsAAndScale[index+3] = a.scale;
-
-        positionsBAndScale[index] = b.position.x;
-        positionsBAndScale[index+1] = b.position.y;
-        positionsBAndScale[index+2] = b.position.z;
-        positionsBAndScale[index+3] = b.scale;
-
-        coloursA[index] = a.colour.r;
-        coloursA[index+1] = a.colour.g;
-        coloursA[index+2] = a.colour.b;
-        coloursA[index+3] = a.colour.a;
-
-        coloursB[index] = b.colour.r;
-        coloursB[index+1] = b.colour.g;
-        coloursB[index+2] = b.colour.b;
-        coloursB[index+3] = b.colour.a;
-
-        index += 4;
-        bonds++;
-    }
-
-    /**
-     * @brief Upload Bond data to the GPU.
-     *
-     */
-    void updateVertexArray()
-    {
-        glBindVertexArray(vao);
+        const uint64_t a = bond.atomIndexA;
+        const uint64_t b = bond.atomIndexB;
+        uint8_t position[POSITION_BYTES];
+        uint8_t colour[COLOUR_BYTES];
 
-            subFullBuffer(a_vertices, positionsAAndScale.data(), positionsAAndScale.size());
-            subFullBuffer(b_vertices, positionsBAndScale.data(), positionsBAndScale.size());
-            subFullBuffer(a_colours, coloursA.data(), coloursA.size());
-            subFullBuffer(b_colours, coloursB.data(), coloursB.size());
+        if (compact)
+        {
+            const glm::u16vec4 positions[2] =
+            {
+                glm::u16vec4(quantisation.quantise(atoms.position(a)), uint16_t(atoms.element(a))),
+                glm::u16vec4(quantisation.quantise(atoms.position(b)), uint16_t(atoms.element(b)))
+            };
+            const glm::u8vec4 colours[2] =
+            {
+                quantiseColour(atoms.colour(a)),
+                quantiseColour(atoms.colour(b))
+            };
+            std::memcpy(position, positions, sizeof(positions));
+            std::memcpy(colour, colours, sizeof(colours));
+        }
+        else
+        {
+            const glm::vec4 positions[2] =
+            {
+                glm::vec4(atoms.position(a), float(atoms.element(a))),
+                glm::vec4(atoms.position(b), float(atoms.element(b)))
+            };
+            const glm::vec4 colours[2] = {atoms.colour(a), atoms.colour(b)};
+            std::memcpy(position, positions, sizeof(positions));
+            std::memcpy(colour, colours, sizeof(colours));
+        }
 
-        glBindVertexArray(0);
+        uint8_t * p = &instances[bonds*positionBytes()];
+        if (std::memcmp(p, position, positionBytes()) != 0)
+        {
+            std::memcpy(p, position, positionBytes());
+            positionsChanged.mark(bonds);
+        }
+        uint8_t * c = &instances[colourOffset()+bonds*colourBytes()];
+        if (std::memcmp(c, colour, colourBytes()) != 0)
+        {
+            std::memcpy(c, colour, colourBytes());
+            coloursChanged.mark(bonds);
+        }
+        bonds++;
     }
 };
     GLuint vao, a_vertices, b_vertices, a_colours, b_colours, a_quad;
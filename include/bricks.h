@@ -0,0 +1,943 @@
+#ifndef BRICKS_H
+#define BRICKS_H
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <tuple>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#include <atom.h>
+#include <bond.h>
+#include <element.h>
+#include <frustum.h>
+#include <structure.h>
+#include <xyz.h>
+
+/**
+ * @brief An Atom as stored in a brick file.
+ *
+ * @remark index is the Atom's index in the structure file.
+ */
+struct BrickAtom
+{
+    float x, y, z;
+    uint32_t element;
+    uint64_t index;
+};
+
+/**
+ * @brief A spatial brick of Atoms in a brick file.
+ *
+ */
+struct Brick
+{
+    /**
+     * @brief The bounding box of the brick's Atom centres.
+     *
+     */
+    glm::vec3 min, max;
+
+    /**
+     * @brief The byte offset of the brick's Atoms in the file.
+     *
+     */
+    uint64_t offset;
+
+    /**
+     * @brief The number of Atoms in the brick.
+     *
+     */
+    uint64_t count;
+
+    glm::vec3 centre() const { return 0.5f*(min+max); }
+
+    float radius() const { return 0.5f*glm::length(max-min); }
+
+    uint64_t bytes() const { return count*sizeof(BrickAtom); }
+};
+
+const char BRICK_FILE_MAGIC[8] = {'S', 'F', 'O', 'A', 'V', 'B', 'R', 'K'};
+
+/**
+ * @brief Partition a frame into spatial bricks on disk.
+ *
+ * @remark The frame is streamed three times, for its bounds, for the Atom
+ * count of each cell of a uniform grid, and to write each Atom into its
+ * cell's place in the file. Only the grid and a bounded write buffer are
+ * held in memory, so frames larger than memory can be partitioned.
+ * @remark The file is a header (magic, Atom count, brick count, mean
+ * position), the Brick table, then the BrickAtoms of each Brick in turn.
+ * It is written beside the target and renamed when complete.
+ * @remark The grid has about brickAtoms Atoms per cell on average, empty
+ * cells have no Brick.
+ * @param source source(visit) calls visit(const BrickAtom &) for each
+ * Atom of the frame, in the same order each call.
+ * @param target the brick file path.
+ * @param brickAtoms the mean Atoms per Brick.
+ */
+template <class Source>
+void partitionBricks
+(
+    Source source,
+    std::filesystem::path target,
+    uint64_t brickAtoms = 1 << 14
+)
+{
+    brickAtoms = std::max(brickAtoms, uint64_t(1));
+    uint64_t atoms = 0;
+    glm::dvec3 sum(0.0);
+    glm::vec3 lower(std::numeric_limits<float>::max());
+    glm::vec3 upper(std::numeric_limits<float>::lowest());
+    source
+    (
+        [&](const BrickAtom & a)
+        {
+            glm::vec3 r(a.x, a.y, a.z);
+            lower = glm::min(lower, r);
+            upper = glm::max(upper, r);
+            sum += glm::dvec3(r);
+            atoms++;
+        }
+    );
+
+    const uint64_t g = std::max(uint64_t(std::ceil(std::cbrt(double(atoms)/double(brickAtoms)))), uint64_t(1));
+    const glm::vec3 extent = glm::max(upper-lower, glm::vec3(std::numeric_limits<float>::min()));
+    auto cellOf = [&](const BrickAtom & a)
+    {
+        glm::vec3 u = glm::clamp((glm::vec3(a.x, a.y, a.z)-lower)/extent*float(g), 0.0f, float(g-1));
+        return (uint64_t(u.z)*g+uint64_t(u.y))*g+uint64_t(u.x);
+    };
+
+    std::vector<Brick> cells(g*g*g, {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()), 0, 0});
+    source
+    (
+        [&](const BrickAtom & a)
+        {
+            Brick & cell = cells[cellOf(a)];
+            glm::vec3 r(a.x, a.y, a.z);
+            cell.min = glm::min(cell.min, r);
+            cell.max = glm::max(cell.max, r);
+            cell.count++;
+        }
+    );
+
+    uint64_t bricks = 0;
+    for (const Brick & cell : cells) { if (cell.count > 0) { bricks++; } }
+    const uint64_t tableOffset = sizeof(BRICK_FILE_MAGIC)+2*sizeof(uint64_t)+3*sizeof(double);
+    uint64_t offset = tableOffset+bricks*sizeof(Brick);
+    std::vector<Brick> table;
+    table.reserve(bricks);
+    for (Brick & cell : cells)
+    {
+        cell.offset = offset;
+        offset += cell.bytes();
+        if (cell.count > 0) { table.push_back(cell); }
+    }
+
+    std::filesystem::path partial = target;
+    partial += ".partial";
+    {
+        std::ofstream(partial, std::ios::binary | std::ios::trunc);
+    }
+    std::filesystem::resize_file(partial, offset);
+    std::fstream out(partial, std::ios::binary | std::ios::in | std::ios::out);
+    if (!out.is_open())
+    {
+        throw std::runtime_error("Could not write bricks to "+partial.string());
+    }
+
+    const glm::dvec3 mean = atoms > 0 ? sum/double(atoms) : glm::dvec3(0.0);
+    out.write(BRICK_FILE_MAGIC, sizeof(BRICK_FILE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&atoms), sizeof(atoms));
+    out.write(reinterpret_cast<const char*>(&bricks), sizeof(bricks));
+    out.write(reinterpret_cast<const char*>(&mean), sizeof(mean));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size()*sizeof(Brick));
+
+    // Buffer writes per cell, flushing them all past a bounded total.
+    const uint64_t bufferLimit = std::max(uint64_t(1 << 18), 4*brickAtoms);
+    std::vector<std::vector<BrickAtom>> buffers(cells.size());
+    std::vector<uint64_t> written(cells.size(), 0);
+    uint64_t buffered = 0;
+    auto flush = [&]()
+    {
+        for (uint64_t c = 0; c < cells.size(); c++)
+        {
+            if (buffers[c].empty()) { continue; }
+            out.seekp(cells[c].offset+written[c]*sizeof(BrickAtom));
+            out.write(reinterpret_cast<const char*>(buffers[c].data()), buffers[c].size()*sizeof(BrickAtom));
+            written[c] += buffers[c].size();
+            std::vector<BrickAtom>().swap(buffers[c]);
+        }
+        buffered = 0;
+    };
+    source
+    (
+        [&](const BrickAtom & a)
+        {
+            buffers[cellOf(a)].push_back(a);
+            buffered++;
+            if (buffered >= bufferLimit) { flush(); }
+        }
+    );
+    flush();
+    out.close();
+    if (out.fail())
+    {
+        throw std::runtime_error("Could not write bricks to "+partial.string());
+    }
+    std::filesystem::rename(partial, target);
+}
+
+/**
+ * @brief Stream the first frame of an [EXT]XYZ file as BrickAtoms.
+ *
+ * @remark Only one line is held at a time, @see partitionBricks.
+ * @param path the [EXT]XYZ file.
+ * @return auto a source, source(visit) calls visit(const BrickAtom &) per Atom.
+ */
+auto xyzBrickSource(std::filesystem::path path)
+{
+    return [path](auto visit)
+    {
+        std::ifstream in(path);
+        if (!in.is_open())
+        {
+            throw std::runtime_error("Could not open "+path.string());
+        }
+        LabelCache labels;
+        std::string line;
+        std::getline(in, line);
+        std::stringstream ss(line);
+        uint64_t natoms = 0;
+        ss >> natoms;
+        if (ss.fail())
+        {
+            throw std::runtime_error("File "+path.string()+" failed to read the atom count");
+        }
+        std::getline(in, line);
+        for (uint64_t a = 0; a < natoms; a++)
+        {
+            std::getline(in, line);
+            ss = std::stringstream(line);
+            std::string symbol;
+            BrickAtom atom;
+            ss >> symbol >> atom.x >> atom.y >> atom.z;
+            if (ss.fail())
+            {
+                throw std::runtime_error("File "+path.string()+" failed to read atom "+std::to_string(a)+": \""+line+"\"");
+            }
+            atom.element = uint32_t(labels.element(symbol));
+            atom.index = a;
+            visit(atom);
+        }
+    };
+}
+
+/**
+ * @brief Read Bricks from a brick file.
+ *
+ * @remark The Brick table is held in memory, Atoms are read on request.
+ * @see partitionBricks for the format.
+ */
+class BrickFile
+{
+public:
+
+    /**
+     * @brief Open a brick file.
+     *
+     * @param path the brick file path.
+     */
+    BrickFile(std::filesystem::path path)
+    : path(path), in(path, std::ios::binary)
+    {
+        char magic[sizeof(BRICK_FILE_MAGIC)];
+        in.read(magic, sizeof(magic));
+        if (in.fail() || std::memcmp(magic, BRICK_FILE_MAGIC, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error(path.string()+" is not a brick file");
+        }
+        uint64_t bricks = 0;
+        glm::dvec3 mean;
+        in.read(reinterpret_cast<char*>(&atoms), sizeof(atoms));
+        in.read(reinterpret_cast<char*>(&bricks), sizeof(bricks));
+        in.read(reinterpret_cast<char*>(&mean), sizeof(mean));
+        table.resize(bricks);
+        in.read(reinterpret_cast<char*>(table.data()), bricks*sizeof(Brick));
+        if (in.fail())
+        {
+            throw std::runtime_error(path.string()+" has a truncated brick table");
+        }
+        centre = glm::vec3(mean);
+    }
+
+    /**
+     * @brief Read the Atoms of a Brick.
+     *
+     * @param b the Brick index.
+     * @param into the Brick's Atoms.
+     */
+    void read(uint64_t b, std::vector<BrickAtom> & into)
+    {
+        const Brick & brick = table[b];
+        into.resize(brick.count);
+        in.seekg(brick.offset);
+        in.read(reinterpret_cast<char*>(into.data()), brick.bytes());
+        if (in.fail())
+        {
+            throw std::runtime_error(path.string()+" failed to read brick "+std::to_string(b));
+        }
+    }
+
+    const std::vector<Brick> & getBricks() const { return table; }
+
+    /**
+     * @brief The number of Atoms in the frame.
+     *
+     * @return uint64_t the Atom count.
+     */
+    uint64_t atomCount() const { return atoms; }
+
+    /**
+     * @brief The mean Atom position of the frame.
+     *
+     * @return glm::vec3 the mean position.
+     */
+    glm::vec3 getCentre() const { return centre; }
+
+private:
+
+    std::filesystem::path path;
+    std::ifstream in;
+    uint64_t atoms = 0;
+    glm::vec3 centre = glm::vec3(0.0f);
+    std::vector<Brick> table;
+};
+
+/**
+ * @brief A cache of Bricks held in memory within a byte budget.
+ *
+ * @remark Bricks in view are wanted nearest first until one does not fit
+ * the budget, then Bricks out of view nearest first while they fit. Wanted
+ * Bricks are loaded and, when the budget is full, the least recently wanted
+ * Bricks are evicted.
+ * @remark A Brick larger than the budget is never loaded.
+ */
+class BrickCache
+{
+public:
+
+    /**
+     * @brief Construct a new BrickCache.
+     *
+     * @param file the BrickFile to page from.
+     * @param budget the bytes of BrickAtoms to hold.
+     */
+    BrickCache(BrickFile & file, uint64_t budget)
+    : file(file),
+      budget(budget),
+      cached(file.getBricks().size()),
+      lastWanted(file.getBricks().size(), 0)
+    {}
+
+    /**
+     * @brief Page Bricks for a view.
+     *
+     * @param frustum the Frustum, in the space of the Atoms.
+     * @param eye the camera position, in the space of the Atoms.
+     * @param margin added to Brick bounds in view, e.g. the largest Atom radius.
+     * @param loads the most Bricks to read, so paging is spread over calls.
+     * @return true if the drawn Bricks have changed.
+     * @return false if they have not.
+     */
+    bool page
+    (
+        const Frustum & frustum,
+        glm::vec3 eye,
+        float margin = 0.0f,
+        uint64_t loads = 8
+    )
+    {
+        const std::vector<Brick> & bricks = file.getBricks();
+        tick++;
+
+        // Bricks in view, then out of view, each nearest first.
+        std::vector<std::tuple<bool, float, uint64_t>> priorities(bricks.size());
+        std::vector<bool> inView(bricks.size());
+        for (uint64_t b = 0; b < bricks.size(); b++)
+        {
+            inView[b] = frustum.intersects(bricks[b].centre(), bricks[b].radius()+margin);
+            const float distance = std::max(glm::length(bricks[b].centre()-eye)-bricks[b].radius(), 0.0f);
+            priorities[b] = {!inView[b], distance, b};
+        }
+        std::sort(priorities.begin(), priorities.end());
+
+        std::vector<uint64_t> wanted;
+        uint64_t bytes = 0;
+        for (const auto & p : priorities)
+        {
+            const uint64_t b = std::get<2>(p);
+            if (bricks[b].bytes() > budget) { continue; }
+            if (bytes+bricks[b].bytes() > budget)
+            {
+                // No Brick in view is drawn behind a gap.
+                if (inView[b]) { break; }
+                continue;
+            }
+            bytes += bricks[b].bytes();
+            wanted.push_back(b);
+            lastWanted[b] = tick;
+        }
+
+        for (uint64_t b : wanted)
+        {
+            if (resident(b)) { continue; }
+            if (loads == 0) { break; }
+            while (residentBytes+bricks[b].bytes() > budget && !residents.empty()) { evict(); }
+            file.read(b, cached[b]);
+            residentBytes += bricks[b].bytes();
+            residents.push_back(b);
+            loads--;
+        }
+
+        std::vector<uint64_t> shown;
+        for (uint64_t b : wanted)
+        {
+            if (inView[b] && resident(b)) { shown.push_back(b); }
+        }
+        if (shown == drawn) { return false; }
+        drawn = std::move(shown);
+        return true;
+    }
+
+    /**
+     * @brief The resident Bricks in view, nearest first.
+     *
+     * @return const std::vector<uint64_t>& the Brick indices.
+     */
+    const std::vector<uint64_t> & getDrawn() const { return drawn; }
+
+    /**
+     * @brief The Atoms of a resident Brick.
+     *
+     * @param b the Brick index.
+     * @return const std::vector<BrickAtom>& the Brick's Atoms.
+     */
+    const std::vector<BrickAtom> & atoms(uint64_t b) const { return cached[b]; }
+
+    bool resident(uint64_t b) const { return !cached[b].empty(); }
+
+    /**
+     * @brief The bytes of BrickAtoms held.
+     *
+     * @return uint64_t the bytes held, at most the budget.
+     */
+    uint64_t bytes() const { return residentBytes; }
+
+    uint64_t getBudget() const { return budget; }
+
+private:
+
+    BrickFile & file;
+    uint64_t budget;
+    uint64_t residentBytes = 0;
+    uint64_t tick = 0;
+
+    std::vector<std::vector<BrickAtom>> cached;
+    std::vector<uint64_t> lastWanted;
+    std::vector<uint64_t> residents;
+    std::vector<uint64_t> drawn;
+
+    /**
+     * @brief Evict the least recently wanted resident Brick.
+     *
+     */
+    void evict()
+    {
+        auto lru = std::min_element
+        (
+            residents.begin(),
+            residents.end(),
+            [this](uint64_t a, uint64_t b) { return lastWanted[a] < lastWanted[b]; }
+        );
+        residentBytes -= cached[*lru].size()*sizeof(BrickAtom);
+        std::vector<BrickAtom>().swap(cached[*lru]);
+        *lru = residents.back();
+        residents.pop_back();
+    }
+};
+
+/**
+ * @brief A Structure of the Bricks of a frame paged into memory.
+ *
+ * @remark The first frame of an [EXT]XYZ file is partitioned into a brick
+ * file beside it, named path.bricks, if that is missing or older than the
+ * file. @see partitionBricks.
+ * @remark atoms are the resident Bricks in view and change as the view is
+ * paged, @see page. Structure::fileIndex gives the index of an Atom in the
+ * file.
+ * @remark Paging reads Bricks in a detached thread, unless reads are
+ * blocking. Once frameReadComplete, applyPage replaces the Atoms of
+ * Bricks no longer drawn with those of new Bricks. Other Atoms keep their
+ * index, so only changed Atoms need uploading.
+ * @remark Bonds are found per Brick as it is paged in, with the drawn
+ * Bricks within the bond cutoff of it, @see getBonds.
+ * @remark Each drawn Atom is held three times, as a BrickAtom, in atoms
+ * and in atomToFile, with its Brick and slot, @see DRAWN_ATOM_BYTES. The
+ * Bricks are given the share of the budget that leaves room for the
+ * copies, so together they stay within it. Bonds, the BVH and the
+ * renderer's buffers are not counted. They grow with the drawn Atoms, at
+ * most capacity(), rather than with the frame.
+ */
+class BrickedStructure : public Structure
+{
+public:
+
+    /**
+     * @brief The bytes held for each drawn Atom, its BrickAtom, position,
+     * Element, alpha, file index, Brick, index in the Brick and slot in
+     * atoms.
+     *
+     */
+    static constexpr uint64_t DRAWN_ATOM_BYTES =
+        sizeof(BrickAtom)+3*sizeof(float)+sizeof(Element)+sizeof(uint8_t)+sizeof(uint64_t)
+        +2*sizeof(uint32_t)+sizeof(uint64_t);
+
+    /**
+     * @brief Construct a new BrickedStructure.
+     *
+     * @param path the [EXT]XYZ file path.
+     * @param budget the bytes of Bricks and drawn Atoms to hold.
+     * @param bondCutOff the distance cutoff below which Atoms are bonded, 0 for no bonds.
+     * @param brickAtoms the mean Atoms per Brick, when partitioning.
+     * @param blocking if paging is blocking or detached.
+     */
+    BrickedStructure
+    (
+        std::filesystem::path path,
+        uint64_t budget,
+        float bondCutOff = 0.0f,
+        uint64_t brickAtoms = 1 << 14,
+        bool blocking = false
+    )
+    : Structure(bricked(path, brickAtoms), blocking),
+      bricks(this->path),
+      cache(bricks, (budget/DRAWN_ATOM_BYTES)*sizeof(BrickAtom)),
+      bondCutOff(bondCutOff),
+      shownBricks(bricks.getBricks().size(), false),
+      slots(bricks.getBricks().size())
+    {
+        initialise();
+    }
+
+    ~BrickedStructure()
+    {
+        if (worker.joinable()) { worker.join(); }
+    }
+
+    uint64_t atomCount() const override { return atoms.size(); }
+
+    /**
+     * @brief If the last page has finished.
+     *
+     * @return true if it has, @see applyPage.
+     * @return false if Bricks are being paged.
+     */
+    bool frameReadComplete() const override { return !paging; }
+
+    /**
+     * @brief Page in the Bricks nearest the centre, up to the budget.
+     *
+     * @remark There is one frame, so frame is ignored.
+     * @remark Blocks until read, and applies the page.
+     * @param frame the frame position.
+     */
+    void readFrame(uint64_t frame) override
+    {
+        if (worker.joinable()) { worker.join(); }
+        paging = true;
+        pageBricks(Frustum(), bricks.getCentre(), margin(), bricks.getBricks().size());
+        applyPage();
+        currentFrame = 1;
+    }
+
+    /**
+     * @brief Page Bricks for a view.
+     *
+     * @remark atoms do not change until applyPage.
+     * @param frustum the Frustum, in the space of the Atoms.
+     * @param eye the camera position, in the space of the Atoms.
+     * @param loads the most Bricks to read.
+     */
+    void page(const Frustum & frustum, glm::vec3 eye, uint64_t loads = 8)
+    {
+        if (worker.joinable()) { worker.join(); }
+        paging = true;
+        if (blockingReads) { pageBricks(frustum, eye, margin(), loads); return; }
+        worker = std::thread
+        (
+            &BrickedStructure::pageBricks,
+            this,
+            frustum,
+            eye,
+            margin(),
+            loads
+        );
+    }
+
+    /**
+     * @brief Update atoms and bonds from the last page.
+     *
+     * @remark Call once frameReadComplete. The Atoms of new Bricks fill
+     * the slots of removed Bricks, then are appended or the last Atoms
+     * fill the slots left. Bonds are replaced the same way.
+     * @return true if atoms have changed.
+     * @return false if they have not.
+     */
+    bool applyPage()
+    {
+        if (paging) { return false; }
+        resident = cache.bytes();
+        if (added.empty() && removed.empty()) { return false; }
+
+        std::vector<uint64_t> holes;
+        for (uint64_t b : removed)
+        {
+            shownBricks[b] = false;
+            holes.insert(holes.end(), slots[b].begin(), slots[b].end());
+            std::vector<uint64_t>().swap(slots[b]);
+        }
+        std::sort(holes.begin(), holes.end());
+        const uint64_t before = atoms.size();
+        uint64_t count = 0;
+        for (uint64_t b : added) { count += cache.atoms(b).size(); }
+        const uint64_t n = before-holes.size()+count;
+        resizeAtoms(std::max(before, n));
+
+        uint64_t k = 0;
+        for (uint64_t b : added)
+        {
+            const std::vector<BrickAtom> & brick = cache.atoms(b);
+            slots[b].resize(brick.size());
+            for (uint64_t a = 0; a < brick.size(); a++)
+            {
+                const uint64_t i = k < holes.size() ? holes[k] : before+k-holes.size();
+                atoms.set(i, Atom(Element(brick[a].element), glm::vec3(brick[a].x, brick[a].y, brick[a].z)));
+                atomToFile[i] = brick[a].index;
+                atomBrick[i] = uint32_t(b);
+                atomLocal[i] = uint32_t(a);
+                slots[b][a] = i;
+                seen[brick[a].element] = true;
+                k++;
+            }
+            shownBricks[b] = true;
+        }
+        uint64_t tail = n;
+        for (uint64_t h = k; h < holes.size(); h++)
+        {
+            if (holes[h] >= n) { continue; }
+            while (!shownBricks[atomBrick[tail]]) { tail++; }
+            move(tail, holes[h]);
+            tail++;
+        }
+        resizeAtoms(n);
+        natoms = n;
+        atomsRead = n;
+
+        shown.erase
+        (
+            std::remove_if(shown.begin(), shown.end(), [this](uint64_t b) { return !shownBricks[b]; }),
+            shown.end()
+        );
+        shown.insert(shown.end(), added.begin(), added.end());
+
+        auto stale = [this](const BrickBond & link)
+        {
+            return !shownBricks[link.brickA] || !shownBricks[link.brickB];
+        };
+        std::vector<uint64_t> gaps;
+        for (uint64_t l = 0; l < links.size(); l++) { if (stale(links[l])) { gaps.push_back(l); } }
+        uint64_t g = 0;
+        for (const BrickBond & link : found)
+        {
+            if (g < gaps.size()) { links[gaps[g++]] = link; }
+            else { links.push_back(link); }
+        }
+        const uint64_t m = links.size()-(gaps.size()-g);
+        tail = m;
+        for (; g < gaps.size(); g++)
+        {
+            if (gaps[g] >= m) { continue; }
+            while (stale(links[tail])) { tail++; }
+            links[gaps[g]] = links[tail];
+            tail++;
+        }
+        links.resize(m);
+        bonds.clear();
+        bonds.reserve(links.size());
+        for (const BrickBond & link : links)
+        {
+            bonds.push_back({slots[link.brickA][link.atomA], slots[link.brickB][link.atomB]});
+        }
+
+        added.clear();
+        removed.clear();
+        found.clear();
+        return true;
+    }
+
+    /**
+     * @brief The Bonds of atoms.
+     *
+     * @remark Bonds keep their place as Bricks are paged, @see applyPage.
+     * @return const std::vector<Bond>& the Bonds, within the bond cutoff.
+     */
+    const std::vector<Bond> & getBonds() const { return bonds; }
+
+    /**
+     * @brief The mean position of all Atoms in the frame.
+     *
+     * @return glm::vec3 the mean position.
+     */
+    glm::vec3 centre() const { return bricks.getCentre(); }
+
+    /**
+     * @brief The number of Atoms in the frame.
+     *
+     * @return uint64_t the Atom count.
+     */
+    uint64_t frameAtomCount() const { return bricks.atomCount(); }
+
+    /**
+     * @brief The Atoms the budget can hold.
+     *
+     * @return uint64_t the largest size of atoms.
+     */
+    uint64_t capacity() const { return cache.getBudget()/sizeof(BrickAtom); }
+
+    /**
+     * @brief The bytes held by the Bricks and the drawn Atoms.
+     *
+     * @remark As of the last applyPage.
+     * @return uint64_t the bytes held, at most the budget.
+     */
+    uint64_t bytes() const
+    {
+        return resident+atoms.size()*(DRAWN_ATOM_BYTES-sizeof(BrickAtom));
+    }
+
+    /**
+     * @brief The Bricks in atoms.
+     *
+     * @return const std::vector<uint64_t>& the Brick indices.
+     */
+    const std::vector<uint64_t> & getShown() const { return shown; }
+
+    /**
+     * @brief The BrickCache, not to be used while paging.
+     *
+     */
+    const BrickCache & getCache() const { return cache; }
+
+private:
+
+    /**
+     * @brief A Bond between the index'th Atoms of two Bricks.
+     *
+     */
+    struct BrickBond
+    {
+        uint32_t brickA, atomA, brickB, atomB;
+    };
+
+    BrickFile bricks;
+    BrickCache cache;
+    float bondCutOff;
+    std::array<bool, ELEMENT_COUNT> seen = {};
+
+    std::thread worker;
+    std::atomic<bool> paging {false};
+
+    std::vector<uint64_t> shown;
+    std::vector<bool> shownBricks;
+    std::vector<std::vector<uint64_t>> slots;
+    std::vector<uint32_t> atomBrick;
+    std::vector<uint32_t> atomLocal;
+    std::vector<BrickBond> links;
+    std::vector<Bond> bonds;
+    uint64_t resident = 0;
+
+    std::vector<uint64_t> added;
+    std::vector<uint64_t> removed;
+    std::vector<BrickBond> found;
+
+    /**
+     * @brief Partition path into bricks, if not already done.
+     *
+     * @remark Throws if path does not appear to be [EXT]XYZ.
+     * @return std::filesystem::path the brick file path.
+     */
+    static std::filesystem::path bricked(std::filesystem::path path, uint64_t brickAtoms)
+    {
+        if (!ostensiblyXYZLike(path))
+        {
+            throw std::runtime_error(path.string()+" does not appear to be [EXT]XYZ, bricks are read from [EXT]XYZ");
+        }
+        std::filesystem::path target = path;
+        target += ".bricks";
+        if
+        (
+            !std::filesystem::exists(target) ||
+            std::filesystem::last_write_time(target) < std::filesystem::last_write_time(path)
+        )
+        {
+            std::cout << "Partitioning " << path << " into bricks at " << target << "\n";
+            partitionBricks(xyzBrickSource(path), target, brickAtoms);
+        }
+        return target;
+    }
+
+    /**
+     * @brief The largest radius of the Elements read so far.
+     *
+     */
+    float margin() const
+    {
+        float radius = 0.0f;
+        for (uint16_t e = 0; e < ELEMENT_COUNT; e++)
+        {
+            if (seen[e]) { radius = std::max(radius, atoms.getPalette().radius(Element(e))); }
+        }
+        return radius;
+    }
+
+    /**
+     * @brief Page Bricks, then find the Bricks added and removed, and the
+     * Bonds of those added.
+     *
+     * @remark Only reads shown, which applyPage does not change while paging.
+     */
+    void pageBricks(Frustum frustum, glm::vec3 eye, float margin, uint64_t loads)
+    {
+        cache.page(frustum, eye, margin, loads);
+        added.clear();
+        removed.clear();
+        found.clear();
+        std::vector<bool> drawn(shownBricks.size(), false);
+        std::vector<uint64_t> neighbours;
+        for (uint64_t b : cache.getDrawn())
+        {
+            drawn[b] = true;
+            if (shownBricks[b]) { neighbours.push_back(b); }
+            else { added.push_back(b); }
+        }
+        for (uint64_t b : shown) { if (!drawn[b]) { removed.push_back(b); } }
+        // A Bond between Bricks belongs to the later added.
+        for (uint64_t b : added)
+        {
+            bond(b, neighbours);
+            neighbours.push_back(b);
+        }
+        paging = false;
+    }
+
+    /**
+     * @brief Find the Bonds of a Brick's Atoms, within it and to neighbours.
+     *
+     * @param b the Brick index.
+     * @param neighbours the drawn Bricks to bond to.
+     */
+    void bond(uint64_t b, const std::vector<uint64_t> & neighbours)
+    {
+        if (bondCutOff <= 0.0f) { return; }
+        const std::vector<Brick> & table = bricks.getBricks();
+        const glm::vec3 lower = table[b].min-glm::vec3(bondCutOff);
+        const glm::vec3 upper = table[b].max+glm::vec3(bondCutOff);
+        const std::vector<BrickAtom> & own = cache.atoms(b);
+        AtomStore near;
+        std::vector<std::pair<uint32_t, uint32_t>> origin;
+        for (uint64_t a = 0; a < own.size(); a++)
+        {
+            near.push_back(Atom(Element::Unknown, glm::vec3(own[a].x, own[a].y, own[a].z)));
+            origin.push_back({uint32_t(b), uint32_t(a)});
+        }
+        for (uint64_t n : neighbours)
+        {
+            if
+            (
+                glm::any(glm::lessThan(table[n].max, lower)) ||
+                glm::any(glm::greaterThan(table[n].min, upper))
+            )
+            {
+                continue;
+            }
+            const std::vector<BrickAtom> & other = cache.atoms(n);
+            for (uint64_t a = 0; a < other.size(); a++)
+            {
+                const glm::vec3 r(other[a].x, other[a].y, other[a].z);
+                if (glm::all(glm::greaterThanEqual(r, lower)) && glm::all(glm::lessThanEqual(r, upper)))
+                {
+                    near.push_back(Atom(Element::Unknown, r));
+                    origin.push_back({uint32_t(n), uint32_t(a)});
+                }
+            }
+        }
+        VerletBondList search(bondCutOff, 0.0f);
+        for (const Bond & pair : search.update(near))
+        {
+            if (pair.atomIndexA >= own.size() && pair.atomIndexB >= own.size()) { continue; }
+            const auto & a = origin[pair.atomIndexA];
+            const auto & c = origin[pair.atomIndexB];
+            found.push_back({a.first, a.second, c.first, c.second});
+        }
+    }
+
+    /**
+     * @brief Move an Atom to another slot, replacing that Atom.
+     *
+     */
+    void move(uint64_t from, uint64_t to)
+    {
+        atoms.set(to, atoms[from]);
+        atomToFile[to] = atomToFile[from];
+        atomBrick[to] = atomBrick[from];
+        atomLocal[to] = atomLocal[from];
+        slots[atomBrick[to]][atomLocal[to]] = to;
+    }
+
+    void resizeAtoms(uint64_t n)
+    {
+        atoms.resize(n);
+        atomToFile.resize(n);
+        atomBrick.resize(n);
+        atomLocal.resize(n);
+    }
+
+    void initialise()
+    {
+        natoms = 0;
+        frames = 1;
+        linesPerFrame = 0;
+        cacheComplete = true;
+    }
+
+    void getFrame() {}
+
+    void getCell() {}
+};
+
+#endif /* BRICKS_H */
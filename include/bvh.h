@@ -0,0 +1,434 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <future>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include <atom.h>
+#include <visibility.h>
+
+/**
+ * @brief A node of a BVH.
+ *
+ * @remark Nodes are stored in pre-order, the left child of an internal
+ * node immediately follows it.
+ */
+struct BVHNode
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    /**
+     * @brief Index of the right child, 0 for a leaf.
+     *
+     */
+    uint64_t right;
+
+    /**
+     * @brief First leaf Atom in BVH::order.
+     *
+     */
+    uint64_t start;
+
+    /**
+     * @brief Number of Atoms in the node.
+     *
+     */
+    uint64_t count;
+
+    bool leaf() const { return right == 0; }
+};
+
+/**
+ * @brief A bounding volume hierarchy over Atom spheres.
+ *
+ * @remark Built by median splits along the longest axis, the top levels
+ * of the tree are built in parallel.
+ * @remark The topology only depends on the Atoms at build time. When Atoms
+ * move but keep their indices the tree may be refit, which only recomputes
+ * bounds.
+ * @remark The sphere radius of an Atom is its scale multiplied by a
+ * radius scale (the rendered atom size).
+ */
+class BVH
+{
+public:
+
+    /**
+     * @brief Construct an empty BVH.
+     *
+     * @param radiusScale multiplier of Atom::scale for the sphere radius.
+     * @param leafSize maximum Atoms per leaf.
+     */
+    BVH(float radiusScale = 1.0f, uint64_t leafSize = 4)
+    : radiusScale(radiusScale), leafSize(std::max(leafSize, uint64_t(1)))
+    {}
+
+    /**
+     * @brief Construct a BVH over some Atoms.
+     *
+     * @param atoms the Atoms to index.
+     * @param radiusScale multiplier of Atom::scale for the sphere radius.
+     * @param leafSize maximum Atoms per leaf.
+     */
+    BVH(const AtomStore & atoms, float radiusScale = 1.0f, uint64_t leafSize = 4)
+    : BVH(radiusScale, leafSize)
+    {
+        build(atoms);
+    }
+
+    /**
+     * @brief Build the hierarchy.
+     *
+     * @param atoms the Atoms to index.
+     */
+    void build(const AtomStore & atoms)
+    {
+        nodes.clear();
+        order.resize(atoms.size());
+        for (uint64_t i = 0; i < atoms.size(); i++) { order[i] = i; }
+        if (atoms.empty()) { return; }
+
+        leafCounts.clear();
+        nodes.resize(2*leaves(atoms.size())-1);
+
+        unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+        uint8_t parallelDepth = 0;
+        while ((1u << parallelDepth) < threads) { parallelDepth++; }
+
+        buildNode(atoms, 0, 0, atoms.size(), parallelDepth);
+    }
+
+    /**
+     * @brief Recompute bounds for moved Atoms.
+     *
+     * @param atoms the Atoms, with the same indices as when built.
+     * @remark Rebuilds if the Atom count has changed.
+     */
+    void refit(const AtomStore & atoms)
+    {
+        if (atoms.size() != order.size()) { build(atoms); return; }
+        // Children always follow their parent in pre-order.
+        for (uint64_t n = nodes.size(); n > 0; n--)
+        {
+            BVHNode & node = nodes[n-1];
+            if (node.leaf())
+            {
+                bound(atoms, node);
+            }
+            else
+            {
+                const BVHNode & l = nodes[n];
+                const BVHNode & r = nodes[node.right];
+                node.min = glm::min(l.min, r.min);
+                node.max = glm::max(l.max, r.max);
+            }
+        }
+    }
+
+    /**
+     * @brief Find the first Atom sphere hit by a ray.
+     *
+     * @param atoms the indexed Atoms.
+     * @param origin the ray origin.
+     * @param direction the ray direction.
+     * @param index the index of the hit Atom.
+     * @param distance the ray parameter of the hit.
+     * @param visibility if not null, hidden Atoms are passed through.
+     * @return true if an Atom was hit.
+     * @return false if no Atom was hit.
+     */
+    bool raycast
+    (
+        const AtomStore & atoms,
+        glm::vec3 origin,
+        glm::vec3 direction,
+        uint64_t & index,
+        float & distance,
+        const Visibility * visibility = nullptr
+    ) const
+    {
+        if (nodes.empty()) { return false; }
+        const glm::vec3 inverse = 1.0f/direction;
+        const float a = glm::dot(direction, direction);
+        float best = std::numeric_limits<float>::max();
+        bool hit = false;
+        std::vector<uint64_t> stack = {0};
+        while (!stack.empty())
+        {
+            uint64_t n = stack.back();
+            stack.pop_back();
+            const BVHNode & node = nodes[n];
+            float t;
+            if (!rayBox(origin, inverse, node, t) || t > best) { continue; }
+            if (node.leaf())
+            {
+                for (uint64_t k = node.start; k < node.start+node.count; k++)
+                {
+                    if (visibility != nullptr && visibility->isHidden(order[k], atoms.element(order[k]))) { continue; }
+                    float radius = atoms.scale(order[k])*radiusScale;
+                    glm::vec3 oc = origin-atoms.position(order[k]);
+                    float b = glm::dot(oc, direction);
+                    float c = glm::dot(oc, oc)-radius*radius;
+                    float discriminant = b*b-a*c;
+                    if (discriminant < 0.0f) { continue; }
+                    float sq = std::sqrt(discriminant);
+                    float s = (-b-sq)/a;
+                    if (s < 0.0f) { s = (-b+sq)/a; }
+                    if (s >= 0.0f && s < best)
+                    {
+                        best = s;
+                        index = order[k];
+                        hit = true;
+                    }
+                }
+            }
+            else
+            {
+                // Visit the nearer child first.
+                float tl, tr;
+                bool hl = rayBox(origin, inverse, nodes[n+1], tl);
+                bool hr = rayBox(origin, inverse, nodes[node.right], tr);
+                if (hl && hr)
+                {
+                    if (tl < tr) { stack.push_back(node.right); stack.push_back(n+1); }
+                    else { stack.push_back(n+1); stack.push_back(node.right); }
+                }
+                else if (hl) { stack.push_back(n+1); }
+                else if (hr) { stack.push_back(node.right); }
+            }
+        }
+        if (hit) { distance = best; }
+        return hit;
+    }
+
+    /**
+     * @brief Find the Atom with centre nearest to a point.
+     *
+     * @param atoms the indexed Atoms.
+     * @param point the query point.
+     * @param index the index of the nearest Atom.
+     * @return true if there are any Atoms.
+     * @return false if there are no Atoms.
+     */
+    bool nearest(const AtomStore & atoms, glm::vec3 point, uint64_t & index) const
+    {
+        if (nodes.empty()) { return false; }
+        float best = std::numeric_limits<float>::max();
+        std::vector<uint64_t> stack = {0};
+        while (!stack.empty())
+        {
+            uint64_t n = stack.back();
+            stack.pop_back();
+            const BVHNode & node = nodes[n];
+            if (boxDistance2(point, node) > best) { continue; }
+            if (node.leaf())
+            {
+                for (uint64_t k = node.start; k < node.start+node.count; k++)
+                {
+                    glm::vec3 r = atoms.position(order[k])-point;
+                    float d2 = glm::dot(r, r);
+                    if (d2 < best) { best = d2; index = order[k]; }
+                }
+            }
+            else
+            {
+                float dl = boxDistance2(point, nodes[n+1]);
+                float dr = boxDistance2(point, nodes[node.right]);
+                if (dl < dr) { stack.push_back(node.right); stack.push_back(n+1); }
+                else { stack.push_back(n+1); stack.push_back(node.right); }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Find the Atoms with centres within a radius of a point.
+     *
+     * @param atoms the indexed Atoms.
+     * @param point the query point.
+     * @param radius the query radius (inclusive).
+     * @return std::vector<uint64_t> the Atom indices.
+     */
+    std::vector<uint64_t> within(const AtomStore & atoms, glm::vec3 point, float radius) const
+    {
+        std::vector<uint64_t> found;
+        if (nodes.empty()) { return found; }
+        const float r2 = radius*radius;
+        std::vector<uint64_t> stack = {0};
+        while (!stack.empty())
+        {
+            uint64_t n = stack.back();
+            stack.pop_back();
+            const BVHNode & node = nodes[n];
+            if (boxDistance2(point, node) > r2) { continue; }
+            if (node.leaf())
+            {
+                for (uint64_t k = node.start; k < node.start+node.count; k++)
+                {
+                    glm::vec3 r = atoms.position(order[k])-point;
+                    if (glm::dot(r, r) <= r2) { found.push_back(order[k]); }
+                }
+            }
+            else
+            {
+                stack.push_back(node.right);
+                stack.push_back(n+1);
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Set the multiplier of Atom::scale for the sphere radius.
+     *
+     * @remark Requires a refit to take effect.
+     * @param s the radius scale.
+     */
+    void setRadiusScale(float s) { radiusScale = s; }
+
+    const std::vector<BVHNode> & getNodes() const { return nodes; }
+
+    uint64_t size() const { return order.size(); }
+
+private:
+
+    float radiusScale;
+    uint64_t leafSize;
+
+    std::vector<BVHNode> nodes;
+    std::vector<uint64_t> order;
+    std::map<uint64_t, uint64_t> leafCounts;
+
+    /**
+     * @brief Number of leaves for count Atoms.
+     *
+     * @remark Median splits only produce two sizes per level, so memoising
+     * makes this O(log^2 count).
+     */
+    uint64_t leaves(uint64_t count)
+    {
+        if (count <= leafSize) { return 1; }
+        auto known = leafCounts.find(count);
+        if (known != leafCounts.end()) { return known->second; }
+        uint64_t l = leaves(count/2)+leaves(count-count/2);
+        leafCounts[count] = l;
+        return l;
+    }
+
+    /**
+     * @brief Number of leaves for count Atoms, after leaves has been called.
+     *
+     * @remark Read only, so safe during the parallel build.
+     */
+    uint64_t leafCountOf(uint64_t count) const
+    {
+        if (count <= leafSize) { return 1; }
+        return leafCounts.at(count);
+    }
+
+    /**
+     * @brief Slab test of a ray against a node's box.
+     *
+     * @param t the entry ray parameter, clamped to 0.
+     */
+    bool rayBox(glm::vec3 origin, glm::vec3 inverseDirection, const BVHNode & node, float & t) const
+    {
+        glm::vec3 t0 = (node.min-origin)*inverseDirection;
+        glm::vec3 t1 = (node.max-origin)*inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+        t = enter;
+        return enter <= exit;
+    }
+
+    /**
+     * @brief Squared distance from a point to a node's box, 0 inside.
+     *
+     */
+    float boxDistance2(glm::vec3 point, const BVHNode & node) const
+    {
+        glm::vec3 d = glm::max(glm::max(node.min-point, point-node.max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    void bound(const AtomStore & atoms, BVHNode & node) const
+    {
+        node.min = glm::vec3(std::numeric_limits<float>::max());
+        node.max = glm::vec3(-std::numeric_limits<float>::max());
+        for (uint64_t k = node.start; k < node.start+node.count; k++)
+        {
+            glm::vec3 position = atoms.position(order[k]);
+            glm::vec3 r = glm::vec3(atoms.scale(order[k])*radiusScale);
+            node.min = glm::min(node.min, position-r);
+            node.max = glm::max(node.max, position+r);
+        }
+    }
+
+    void buildNode
+    (
+        const AtomStore & atoms,
+        uint64_t n,
+        uint64_t start,
+        uint64_t count,
+        uint8_t parallelDepth
+    )
+    {
+        BVHNode & node = nodes[n];
+        node.start = start;
+        node.count = count;
+        node.right = 0;
+        bound(atoms, node);
+        if (count <= leafSize) { return; }
+
+        glm::vec3 extent = node.max-node.min;
+        uint8_t axis = 0;
+        if (extent.y > extent[axis]) { axis = 1; }
+        if (extent.z > extent[axis]) { axis = 2; }
+
+        const std::vector<float> & coordinate = axis == 0 ? atoms.getX() : (axis == 1 ? atoms.getY() : atoms.getZ());
+        uint64_t half = count/2;
+        std::nth_element
+        (
+            order.begin()+start,
+            order.begin()+start+half,
+            order.begin()+start+count,
+            [&coordinate](uint64_t a, uint64_t b)
+            {
+                return coordinate[a] < coordinate[b];
+            }
+        );
+
+        // Pre-order layout, the right subtree follows the whole left subtree.
+        uint64_t right = n+2*leafCountOf(half);
+        node.right = right;
+
+        if (parallelDepth > 0)
+        {
+            auto left = std::async
+            (
+                std::launch::async,
+                [&]() { buildNode(atoms, n+1, start, half, parallelDepth-1); }
+            );
+            buildNode(atoms, right, start+half, count-half, parallelDepth-1);
+            left.wait();
+        }
+        else
+        {
+            buildNode(atoms, n+1, start, half, 0);
+            buildNode(atoms, right, start+half, count-half, 0);
+        }
+    }
+};
+
+#endif /* BVH_H */
@@ -5,6 +5,7 @@
 #include <cstdint>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <atom.h>
 #include <util.h>
@@ -33,7 +34,7 @@ public:
      * @param resX the screen resolution width.
      * @param resY the screen resolution in height.
      */
-    Camera(const std::vector<Atom> & atoms, uint16_t resX, uint16_t resY)
+    Camera(const AtomStore & atoms, uint16_t resX, uint16_t resY)
     : resX(resX), resY(resY)
     {
         reset(atoms);
@@ -86,7 +87,7 @@ public:
      * to see all the atoms, focussing on {0,0,0} and up point +tve y.
      * @param atoms the Atoms to fit in view.
      */
-    void reset(const std::vector<Atom> & atoms)
+    void reset(const AtomStore & atoms)
     {
         glm::vec3 ext = extent(atoms);
         positionSpherical = glm::vec3
@@ -218,6 +219,22 @@ public:
      */
     glm::mat4 getInversePV() const { return invPv; }
 
+    /**
+     * @brief The world space ray through a screen pixel.
+     *
+     * @param x the pixel x coordinate, from the left.
+     * @param y the pixel y coordinate, from the top.
+     * @param origin the ray origin on the near plane.
+     * @param direction the normalised ray direction.
+     */
+    void screenRay(double x, double y, glm::vec3 & origin, glm::vec3 & direction) const
+    {
+        glm::vec2 ndc = glm::vec2(2.0*x/resX-1.0, 1.0-2.0*y/resY);
+        glm::vec4 nearPoint = invPv*glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farPoint = invPv*glm::vec4(ndc, 1.0f, 1.0f);
+        origin = glm::vec3(nearPoint)/nearPoint.w;
+        direction = glm::normalize(glm::vec3(farPoint)/farPoint.w-origin);
+    }
 
     uint16_t getResX() const { return resX; }
     uint16_t getResY() const { return resY; }
@@ -2,11 +2,14 @@
 #define CELL_H
 
 #include <array>
+#include <cstring>
+#include <memory>
 
 #include <jGL/OpenGL/gl.h>
 #include <jGL/OpenGL/Shader/glShader.h>
 
 #include <glUtils.h>
+#include <streamBuffer.h>
 
 /**
  * @brief Draw the simulation cell (a box).
@@ -32,23 +35,14 @@ public:
         shader = std::make_unique<jGL::GL::glShader>(vertexShader, fragmentShader);
         shader->use();
         shader->setUniform<glm::vec4>("colour", {0.0,1.0,0.0,0.5});
+        shader->setUniform<glm::mat4>("model", glm::mat4(1.0f));
         glGenVertexArrays(1, &vao);
-        glGenBuffers(1, &a_vertices);
         glGenBuffers(1, &a_coords);
+        stream = std::make_unique<StreamBuffer>(sizeof(float)*cube.size());
+        updateVertices();
 
         glBindVertexArray(vao);
 
-            createBuffer
-            (
-                a_vertices,
-                cube.data(),
-                cube.size(),
-                GL_DYNAMIC_DRAW,
-                0,
-                3,
-                0
-            );
-
             createBuffer
             (
                 a_coords,
@@ -65,7 +59,6 @@ public:
 
     ~Cell()
     {
-        glDeleteBuffers(1, &a_vertices);
         glDeleteBuffers(1, &a_coords);
         glDeleteVertexArrays(1, &vao);
     }
@@ -81,6 +74,17 @@ public:
         shader->setUniform<glm::mat4>("proj", pv);
     }
 
+    /**
+     * @brief Set the model matrix, placing the cell in the scene.
+     *
+     * @param model the model matrix.
+     */
+    void setModel(glm::mat4 model)
+    {
+        shader->use();
+        shader->setUniform<glm::mat4>("model", model);
+    }
+
     /**
      * @brief Set the cell vectors.
      *
@@ -92,16 +96,7 @@ public:
     {
         this->a = a; this->b = b; this->c = c;
         generateFaces();
-        glBindVertexArray(vao);
-
-            subFullBuffer
-            (
-                a_vertices,
-                cube.data(),
-                cube.size()
-            );
-
-        glBindVertexArray(0);
+        updateVertices();
     }
 
     /**
@@ -151,7 +146,9 @@ private:
         1.0, 0.0, 0.0, 0.0, 0.0, 1.0
     };
 
-    GLuint vao, a_vertices, a_coords;
+    GLuint vao, a_coords;
+
+    std::unique_ptr<StreamBuffer> stream;
 
     const char * vertexShader =
         "#version " GLSL_VERSION "\n"
@@ -159,10 +156,11 @@ private:
         "layout(location=0) in vec3 a_vertices;\n"
         "layout(location=1) in vec2 a_coords;\n"
         "uniform mat4 proj;\n"
+        "uniform mat4 model;\n"
         "out vec2 coords;\n"
         "void main()\n"
         "{\n"
-        "    gl_Position = proj*vec4(a_vertices.xyz, 1.0);\n"
+        "    gl_Position = proj*model*vec4(a_vertices.xyz, 1.0);\n"
         "    coords = a_coords;\n"
         "}";
 
@@ -180,6 +178,16 @@ private:
         "    o_colour = vec4(1.0, 0.0, 0.0, d);\n"
         "}";
 
+    void updateVertices()
+    {
+        std::memcpy(stream->map(sizeof(float)*cube.size()), cube.data(), sizeof(float)*cube.size());
+        stream->unmap();
+        GLuint id = stream->id();
+        glBindVertexArray(vao);
+            interleavedAttribute(id, 0, 3, GL_FLOAT, false, 3*sizeof(float), stream->offset(), 0);
+        glBindVertexArray(0);
+    }
+
     void generateFaces()
     {
         // Front vertices.
@@ -376,18 +376,30 @@ struct CommandLine
             getArgument<uint8_t>(levelOfDetail, commandLine, c, count);
             getArgument<uint8_t>(msaa, commandLine, c, count);
             getArgument<bool>(meshes, commandLine, c, count);
+            getArgument<bool>(adaptiveDetail, commandLine, c, count);
+            getArgument<uint8_t>(depthOrder, commandLine, c, count);
+            getArgument<bool>(depthPrepass, commandLine, c, count);
+            getArgument<bool>(frustumCulling, commandLine, c, count);
+            getArgument<float>(hierarchicalDetail, commandLine, c, count);
+            getArgument<float>(memoryBudget, commandLine, c, count);
+            getArgument<float>(pointSprites, commandLine, c, count);
             getArgument<BASE_MESH>(mesh, commandLine, c, count);
             getArgument<float>(bondCutoff, commandLine, c, count);
             getArgument<float>(bondSize, commandLine, c, count);
+            getArgument<float>(bondSkin, commandLine, c, count);
+            getArgument<bool>(gpuBonds, commandLine, c, count);
             getArgument<bool>(hideAtoms, commandLine, c, count);
             getArgument<bool>(showAxes, commandLine, c, count);
             getArgument<bool>(showCell, commandLine, c, count);
             getArgument<float>(deemphasisAlpha, commandLine, c, count);
+            getArgument<bool>(oit, commandLine, c, count);
             getArgument<std::filesystem::path>(colourmap, commandLine, c, count);
             getArgument<float>(atomSize, commandLine, c, count);
             getArgument<vec<2>>(resolution, commandLine, c, count);
             getArgument<bool>(hideInfoText, commandLine, c, count);
             getArgument<bool>(play, commandLine, c, count);
+            getArgument<bool>(reorder, commandLine, c, count);
+            getArgument<bool>(compact, commandLine, c, count);
         }
     }
 
@@ -395,17 +407,29 @@ struct CommandLine
     Argument<uint8_t> msaa = {"msaa", "MSAA level [0-32].", 0, false};
     Argument<BASE_MESH> mesh = {"mesh", "The procedural mesh type.", BASE_MESH::ANY, false};
     Argument<bool> meshes = {"meshes", "Whether to use meshes for atoms.", false, false};
+    Argument<bool> adaptiveDetail = {"adaptiveDetail", "Use meshes with a level of detail per atom by its size on screen, distant atoms as impostors.", false, false};
+    Argument<uint8_t> depthOrder = {"depthOrder", "Sort atoms by camera distance, 0 unsorted, 1 front to back (opaque), 2 back to front (exact transparency).", 0, false};
+    Argument<bool> depthPrepass = {"depthPrepass", "Draw impostor depths first so each pixel is shaded about once.", false, false};
+    Argument<bool> frustumCulling = {"frustumCulling", "Only draw atoms and bonds in view, culled on the GPU when compute shaders are available.", false, false};
+    Argument<float> hierarchicalDetail = {"hierarchicalDetail", "Draw regions of atoms under this many pixels in radius on screen as one sphere, 0 draws every atom.", 0.0f, false};
+    Argument<float> memoryBudget = {"memoryBudget", "Megabytes of atoms to hold, paging spatial bricks of an [EXT]XYZ frame from disk by view, 0 reads whole frames.", 0.0f, false};
+    Argument<float> pointSprites = {"pointSprites", "Draw impostors as points when atoms average under this many pixels in radius on screen, 0 always draws quads.", 1.5f, false};
     Argument<std::filesystem::path> structure = {"atoms", "The structure path.", {}, true, 1};
     Argument<float> bondCutoff = {"bondCutOff","Angstrom cutoff to create a bond.", 0.0f, false};
     Argument<float> bondSize = {"bondSize", "The size of bonds.", 1.0f, false};
+    Argument<float> bondSkin = {"bondSkin", "Angstrom skin beyond the bond cutoff for incremental bond updates.", 0.5f, false};
+    Argument<bool> gpuBonds = {"gpuBonds", "Detect bonds with compute shaders (OpenGL 4.3), falls back to the CPU.", false, false};
     Argument<bool> hideAtoms = {"hideAtoms", "Whether to hide atoms (toggle-able at runtime).", false, false};
     Argument<bool> showAxes = {"showAxes", "Whether to show the coordinate axes (toggle-able at runtime).", false, false};
     Argument<bool> showCell = {"showCell", "Whether to show the simulation cell (toggle-able at runtime).", false, false};
     Argument<float> deemphasisAlpha = {"deemphasisAlpha", "Alpha colour channel for deemphasised atoms.", 0.25f, false};
+    Argument<bool> oit = {"oit", "Order independent transparency for deemphasised atoms and bonds.", false, false};
     Argument<std::filesystem::path> colourmap = {"colourmap", "The colourmap path.", {}, false};
     Argument<float> atomSize = {"atomSize", "Global atom size scaling factor.", 1.0f, false};
     Argument<vec<2>> resolution = {"resolution", "Window resolution in pixels.", {512, 512}, false};
     Argument<bool> hideInfoText = {"hideInfoText", "Hide information and statistics text (toggle-able at runtime).", false, false};
+    Argument<bool> reorder = {"reorder", "Reorder atoms along a Morton curve for spatial locality.", false, false};
+    Argument<bool> compact = {"compact", "Upload 16 bit positions and 8 bit colours to the GPU.", false, false};
     Argument<bool> play = {"play", "Set to play trajectories at start up (toggle-able at runtime).", false, false};
 
     /**
@@ -458,6 +482,10 @@ struct CommandLine
           << "\n"
           << argumentHelp(play)
           << "\n"
+          << argumentHelp(reorder)
+          << "\n"
+          << argumentHelp(compact)
+          << "\n"
           << argumentHelp(colourmap)
           << "\n"
           << argumentHelp(msaa)
@@ -466,12 +494,30 @@ struct CommandLine
           << "\n"
           << argumentHelp(meshes)
           << "\n"
+          << argumentHelp(adaptiveDetail)
+          << "\n"
+          << argumentHelp(depthOrder)
+          << "\n"
+          << argumentHelp(depthPrepass)
+          << "\n"
+          << argumentHelp(frustumCulling)
+          << "\n"
+          << argumentHelp(hierarchicalDetail)
+          << "\n"
+          << argumentHelp(memoryBudget)
+          << "\n"
+          << argumentHelp(pointSprites)
+          << "\n"
           << argumentHelp(levelOfDetail)
           << "\n"
           << argumentHelp(bondCutoff)
           << "\n"
           << argumentHelp(bondSize)
           << "\n"
+          << argumentHelp(bondSkin)
+          << "\n"
+          << argumentHelp(gpuBonds)
+          << "\n"
           << argumentHelp(atomSize)
           << "\n"
           << argumentHelp(hideAtoms)
@@ -482,6 +528,8 @@ struct CommandLine
           << "\n"
           << argumentHelp(deemphasisAlpha)
           << "\n"
+          << argumentHelp(oit)
+          << "\n"
           << argumentHelp(hideInfoText)
           << "\n";
         std::cout << h.str();
@@ -140,6 +140,8 @@ private:
         framePositions[0] = filestream.tellg();
         frames = 1;
         atoms.resize(natoms);
+        if (levcfg > 0) { atoms.addVelocities(); }
+        if (levcfg > 1) { atoms.addForces(); }
     }
 
     void beginning()
@@ -197,10 +199,8 @@ private:
                 checkRead(ss, line, "CONFIG reading atom "+std::to_string(a));
             }
 
-            atom.symbol = stringSymbolToElement(symbol);
-            atom.scale = ELEMENT_RADIUS.at(atom.symbol);
-            atom.colour = colourMap.at(atom.symbol);
-            atoms[a] = atom;
+            atom.symbol = labels.element(symbol);
+            atoms.set(atomSlot(a), atom);
             atomsRead = a+1;
         }
     }
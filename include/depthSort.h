@@ -0,0 +1,261 @@
+#ifndef DEPTHSORT_H
+#define DEPTHSORT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <parallel.h>
+
+/**
+ * @brief The order to draw Atoms by distance from the camera.
+ *
+ * @remark FRONT_TO_BACK lets opaque fragments behind drawn Atoms fail the
+ * depth test early, BACK_TO_FRONT blends translucent Atoms exactly.
+ */
+enum class DepthOrder : uint8_t
+{
+    NONE = 0,
+    FRONT_TO_BACK = 1,
+    BACK_TO_FRONT = 2
+};
+
+/**
+ * @brief A 32 bit key ordered as the float is.
+ *
+ * @param f the float.
+ * @return uint32_t the key, unsigned comparison orders as f.
+ */
+uint32_t sortableKey(float f)
+{
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(float));
+    // Negatives reverse, positives move above them.
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+/**
+ * @brief Sort indices by camera distance, reusing the last order.
+ *
+ * @remark A parallel least significant digit radix sort on 8 bit digits.
+ * Each thread histograms its chunk, a scan over digits then threads gives
+ * each thread's place for each digit, so the sort is stable.
+ * @remark The camera moves little between frames, so last frame's order is
+ * nearly sorted. It is kept when still sorted, or fixed by an insertion
+ * sort when few indices moved, before falling back to a full radix sort.
+ */
+class DepthSort
+{
+public:
+
+    /**
+     * @brief Order [0, distances.size()) by distance.
+     *
+     * @param distances the distance of each index.
+     * @param direction FRONT_TO_BACK for increasing, BACK_TO_FRONT for
+     * decreasing distance.
+     * @return const std::vector<uint64_t>& the ordered indices.
+     */
+    const std::vector<uint64_t> & sort
+    (
+        const std::vector<float> & distances,
+        DepthOrder direction
+    )
+    {
+        const uint64_t n = distances.size();
+        const bool reversed = direction == DepthOrder::BACK_TO_FRONT;
+        incremental = order.size() == n && reversed == lastReversed;
+        lastReversed = reversed;
+        keys.resize(n);
+        if (incremental)
+        {
+            // Keys in last frame's order, so a sorted order has no descents.
+            const unsigned threads = parallelThreads(n);
+            std::vector<uint64_t> descents(threads, 0);
+            parallelFor
+            (
+                n,
+                threads,
+                [&](uint64_t begin, uint64_t end, unsigned t)
+                {
+                    for (uint64_t k = begin; k < end; k++)
+                    {
+                        keys[k] = key(distances[order[k]], reversed);
+                    }
+                    for (uint64_t k = begin+1; k < end; k++)
+                    {
+                        if (keys[k] < keys[k-1]) { descents[t]++; }
+                    }
+                }
+            );
+            uint64_t total = 0;
+            for (unsigned t = 0; t < threads; t++)
+            {
+                total += descents[t];
+                // Descents across chunk boundaries.
+                uint64_t boundary = std::min((n+threads-1)/threads*t, n);
+                if (boundary > 0 && boundary < n && keys[boundary] < keys[boundary-1]) { total++; }
+            }
+            if (total == 0) { return order; }
+            if (total <= n/INCREMENTAL_DESCENTS && insertionSort(n*INCREMENTAL_MOVES)) { return order; }
+            incremental = false;
+        }
+        parallelFor
+        (
+            n,
+            parallelThreads(n),
+            [&](uint64_t begin, uint64_t end, unsigned)
+            {
+                for (uint64_t i = begin; i < end; i++) { keys[i] = key(distances[i], reversed); }
+            }
+        );
+        order.resize(n);
+        for (uint64_t i = 0; i < n; i++) { order[i] = i; }
+        radixSort();
+        return order;
+    }
+
+    /**
+     * @brief The ordered indices of the last sort.
+     *
+     * @return const std::vector<uint64_t>& the ordered indices.
+     */
+    const std::vector<uint64_t> & getOrder() const { return order; }
+
+    /**
+     * @brief Whether the last sort reused the previous order.
+     *
+     * @return true if no radix sort was needed.
+     * @return false if the indices were radix sorted.
+     */
+    bool wasIncremental() const { return incremental; }
+
+    /**
+     * @brief Forget the previous order.
+     *
+     */
+    void clear() { order.clear(); }
+
+    /**
+     * @brief An order with more than 1 in this many descents is radix sorted.
+     *
+     */
+    static const uint64_t INCREMENTAL_DESCENTS = 64;
+
+    /**
+     * @brief An insertion sort may move each index this many places on average.
+     *
+     */
+    static const uint64_t INCREMENTAL_MOVES = 4;
+
+private:
+
+    std::vector<uint64_t> order, scratchOrder;
+    std::vector<uint32_t> keys, scratchKeys;
+    bool lastReversed = false;
+    bool incremental = false;
+
+    static const uint16_t RADIX = 256;
+
+    uint32_t key(float distance, bool reversed) const
+    {
+        uint32_t k = sortableKey(distance);
+        return reversed ? ~k : k;
+    }
+
+    /**
+     * @brief Insertion sort keys and order, giving up after a budget of moves.
+     *
+     * @param budget the most places to move indices.
+     * @return true if sorted.
+     * @return false if the budget ran out, order is then unsorted.
+     */
+    bool insertionSort(uint64_t budget)
+    {
+        uint64_t moves = 0;
+        for (uint64_t k = 1; k < keys.size(); k++)
+        {
+            const uint32_t kk = keys[k];
+            if (kk >= keys[k-1]) { continue; }
+            const uint64_t ok = order[k];
+            uint64_t j = k;
+            while (j > 0 && keys[j-1] > kk)
+            {
+                keys[j] = keys[j-1];
+                order[j] = order[j-1];
+                j--;
+            }
+            keys[j] = kk;
+            order[j] = ok;
+            moves += k-j;
+            if (moves > budget) { return false; }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stable parallel radix sort of keys, carrying order.
+     *
+     */
+    void radixSort()
+    {
+        const uint64_t n = keys.size();
+        const unsigned threads = parallelThreads(n);
+        scratchKeys.resize(n);
+        scratchOrder.resize(n);
+        std::vector<uint64_t> counts(threads*RADIX);
+        for (uint8_t shift = 0; shift < 32; shift += 8)
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+            parallelFor
+            (
+                n,
+                threads,
+                [&](uint64_t begin, uint64_t end, unsigned t)
+                {
+                    for (uint64_t i = begin; i < end; i++) { counts[t*RADIX+((keys[i] >> shift) & 0xff)]++; }
+                }
+            );
+            // A digit every key shares leaves the order unchanged.
+            bool skip = false;
+            for (uint16_t d = 0; d < RADIX; d++)
+            {
+                uint64_t c = 0;
+                for (unsigned t = 0; t < threads; t++) { c += counts[t*RADIX+d]; }
+                if (c == n) { skip = true; break; }
+                if (c > 0) { break; }
+            }
+            if (skip) { continue; }
+
+            uint64_t position = 0;
+            for (uint16_t d = 0; d < RADIX; d++)
+            {
+                for (unsigned t = 0; t < threads; t++)
+                {
+                    uint64_t c = counts[t*RADIX+d];
+                    counts[t*RADIX+d] = position;
+                    position += c;
+                }
+            }
+            parallelFor
+            (
+                n,
+                threads,
+                [&](uint64_t begin, uint64_t end, unsigned t)
+                {
+                    for (uint64_t i = begin; i < end; i++)
+                    {
+                        uint64_t p = counts[t*RADIX+((keys[i] >> shift) & 0xff)]++;
+                        scratchKeys[p] = keys[i];
+                        scratchOrder[p] = order[i];
+                    }
+                }
+            );
+            keys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+};
+
+#endif /* DEPTHSORT_H */
@@ -0,0 +1,92 @@
+#ifndef DIRTYRANGE_H
+#define DIRTYRANGE_H
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+/**
+ * @brief A half open range of bytes [first, second).
+ *
+ */
+typedef std::pair<uint64_t, uint64_t> ByteRange;
+
+/**
+ * @brief The changed indices of an attribute, as one half open range.
+ *
+ * @remark Indices between changes are included, one upload per range
+ * outweighs the unchanged bytes between.
+ */
+struct DirtyRange
+{
+    uint64_t begin = std::numeric_limits<uint64_t>::max();
+    uint64_t end = 0;
+
+    /**
+     * @brief Mark an index changed.
+     *
+     * @param i the index.
+     */
+    void mark(uint64_t i) { begin = std::min(begin, i); end = std::max(end, i+1); }
+
+    /**
+     * @brief Mark indices [first, last) changed.
+     *
+     * @param first the first index.
+     * @param last one past the last index.
+     */
+    void mark(uint64_t first, uint64_t last)
+    {
+        if (last <= first) { return; }
+        begin = std::min(begin, first);
+        end = std::max(end, last);
+    }
+
+    bool empty() const { return end <= begin; }
+
+    void clear() { begin = std::numeric_limits<uint64_t>::max(); end = 0; }
+
+    /**
+     * @brief The changed bytes of an attribute block.
+     *
+     * @param offset the byte offset of the block.
+     * @param stride the bytes per index.
+     * @return ByteRange the changed bytes, empty if unchanged.
+     */
+    ByteRange bytes(uint64_t offset, uint64_t stride) const
+    {
+        if (empty()) { return {offset, offset}; }
+        return {offset+begin*stride, offset+end*stride};
+    }
+};
+
+/**
+ * @brief Add a range to a sorted list of disjoint ranges.
+ *
+ * @remark Overlapping and touching ranges are coalesced. Past maxRanges
+ * the list is replaced by its hull.
+ * @param ranges sorted disjoint ranges.
+ * @param range the range to add, ignored if empty.
+ * @param maxRanges the most ranges to keep.
+ */
+void mergeRange(std::vector<ByteRange> & ranges, ByteRange range, uint64_t maxRanges = 8)
+{
+    if (range.second <= range.first) { return; }
+    auto at = std::lower_bound(ranges.begin(), ranges.end(), range);
+    at = ranges.insert(at, range);
+    if (at != ranges.begin() && std::prev(at)->second >= at->first) { at = std::prev(at); }
+    auto next = std::next(at);
+    while (next != ranges.end() && next->first <= at->second)
+    {
+        at->second = std::max(at->second, next->second);
+        next = ranges.erase(next);
+    }
+    if (ranges.size() > maxRanges)
+    {
+        ranges = {{ranges.front().first, ranges.back().second}};
+    }
+}
+
+#endif /* DIRTYRANGE_H */
@@ -0,0 +1,252 @@
+#ifndef DISTANCEKERNEL_H
+#define DISTANCEKERNEL_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SFOAV_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Instruction sets available to the distance kernels.
+ *
+ */
+enum class SIMD {SCALAR, SSE, AVX2};
+
+/**
+ * @brief The widest SIMD instruction set supported by this cpu.
+ *
+ * @remark Detected once at runtime.
+ * @return SIMD the instruction set.
+ */
+SIMD simdSupport()
+{
+    static const SIMD support = []()
+    {
+        #ifdef SFOAV_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) { return SIMD::AVX2; }
+        if (__builtin_cpu_supports("sse2")) { return SIMD::SSE; }
+        #endif
+        return SIMD::SCALAR;
+    }();
+    return support;
+}
+
+/**
+ * @brief Padding required after the last index written by squaredDistanceWithin.
+ *
+ * @remark Vector paths store whole blocks of 8 indices.
+ */
+const uint64_t DISTANCE_KERNEL_PADDING = 8;
+
+/**
+ * @brief Scalar squaredDistanceWithin.
+ *
+ */
+uint64_t squaredDistanceWithinScalar
+(
+    const float * x,
+    const float * y,
+    const float * z,
+    uint64_t count,
+    glm::vec3 r,
+    float cutOff2,
+    uint32_t * indices
+)
+{
+    uint64_t n = 0;
+    for (uint64_t k = 0; k < count; k++)
+    {
+        float dx = x[k]-r.x;
+        float dy = y[k]-r.y;
+        float dz = z[k]-r.z;
+        if (dx*dx+dy*dy+dz*dz <= cutOff2) { indices[n++] = uint32_t(k); }
+    }
+    return n;
+}
+
+#ifdef SFOAV_X86_SIMD
+
+/**
+ * @brief Left-packing permutations for each 8 bit compare mask.
+ *
+ * @remark Each entry stores 8 lane indices as 4 bit nibbles.
+ */
+constexpr std::array<uint32_t, 256> compressPermutations()
+{
+    std::array<uint32_t, 256> lut {};
+    for (uint32_t mask = 0; mask < 256; mask++)
+    {
+        uint32_t packed = 0;
+        uint32_t slot = 0;
+        for (uint32_t lane = 0; lane < 8; lane++)
+        {
+            if (mask & (1 << lane)) { packed |= lane << (4*slot++); }
+        }
+        lut[mask] = packed;
+    }
+    return lut;
+}
+
+const std::array<uint32_t, 256> COMPRESS_PERMUTATIONS = compressPermutations();
+
+/**
+ * @brief SSE squaredDistanceWithin, 4 candidates per compare.
+ *
+ */
+__attribute__((target("sse2")))
+uint64_t squaredDistanceWithinSSE
+(
+    const float * x,
+    const float * y,
+    const float * z,
+    uint64_t count,
+    glm::vec3 r,
+    float cutOff2,
+    uint32_t * indices
+)
+{
+    const __m128 rx = _mm_set1_ps(r.x);
+    const __m128 ry = _mm_set1_ps(r.y);
+    const __m128 rz = _mm_set1_ps(r.z);
+    const __m128 c2 = _mm_set1_ps(cutOff2);
+    uint64_t n = 0;
+    uint64_t k = 0;
+    for (; k+8 <= count; k += 8)
+    {
+        uint32_t mask = 0;
+        for (uint64_t h = 0; h < 8; h += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(x+k+h), rx);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(y+k+h), ry);
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(z+k+h), rz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            mask |= uint32_t(_mm_movemask_ps(_mm_cmple_ps(d2, c2))) << h;
+        }
+        uint32_t packed = COMPRESS_PERMUTATIONS[mask];
+        uint32_t hits = __builtin_popcount(mask);
+        for (uint32_t s = 0; s < hits; s++)
+        {
+            indices[n++] = uint32_t(k+((packed >> (4*s)) & 0xF));
+        }
+    }
+    uint64_t tail = squaredDistanceWithinScalar(x+k, y+k, z+k, count-k, r, cutOff2, indices+n);
+    for (uint64_t t = 0; t < tail; t++) { indices[n+t] += uint32_t(k); }
+    return n+tail;
+}
+
+/**
+ * @brief AVX2 squaredDistanceWithin, 8 candidates per compare.
+ *
+ * @remark Indices are left-packed with a permutation and written as a
+ * whole block, the emulated compressed store.
+ */
+__attribute__((target("avx2")))
+uint64_t squaredDistanceWithinAVX2
+(
+    const float * x,
+    const float * y,
+    const float * z,
+    uint64_t count,
+    glm::vec3 r,
+    float cutOff2,
+    uint32_t * indices
+)
+{
+    const __m256 rx = _mm256_set1_ps(r.x);
+    const __m256 ry = _mm256_set1_ps(r.y);
+    const __m256 rz = _mm256_set1_ps(r.z);
+    const __m256 c2 = _mm256_set1_ps(cutOff2);
+    const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i nibble = _mm256_set1_epi32(0xF);
+    uint64_t n = 0;
+    uint64_t k = 0;
+    for (; k+8 <= count; k += 8)
+    {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x+k), rx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y+k), ry);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z+k), rz);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        uint32_t mask = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(d2, c2, _CMP_LE_OQ)));
+        if (mask == 0) { continue; }
+        __m256i lanes = _mm256_and_si256
+        (
+            _mm256_srlv_epi32(_mm256_set1_epi32(int(COMPRESS_PERMUTATIONS[mask])), shifts),
+            nibble
+        );
+        lanes = _mm256_add_epi32(lanes, _mm256_set1_epi32(int(k)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices+n), lanes);
+        n += __builtin_popcount(mask);
+    }
+    uint64_t tail = squaredDistanceWithinScalar(x+k, y+k, z+k, count-k, r, cutOff2, indices+n);
+    for (uint64_t t = 0; t < tail; t++) { indices[n+t] += uint32_t(k); }
+    return n+tail;
+}
+
+#endif /* SFOAV_X86_SIMD */
+
+/**
+ * @brief Find the candidates within a distance of a point.
+ *
+ * @param x candidate x coordinates.
+ * @param y candidate y coordinates.
+ * @param z candidate z coordinates.
+ * @param count the number of candidates.
+ * @param r the point to test against.
+ * @param cutOff2 the squared distance cutoff (inclusive).
+ * @param indices output candidate indices in [0, count), in ascending order.
+ * @param simd the instruction set to use, clamped to simdSupport().
+ * @remark indices must hold count+DISTANCE_KERNEL_PADDING values.
+ * @return uint64_t the number of indices written.
+ */
+uint64_t squaredDistanceWithin
+(
+    const float * x,
+    const float * y,
+    const float * z,
+    uint64_t count,
+    glm::vec3 r,
+    float cutOff2,
+    uint32_t * indices,
+    SIMD simd
+)
+{
+    #ifdef SFOAV_X86_SIMD
+    if (simd == SIMD::AVX2 && simdSupport() == SIMD::AVX2)
+    {
+        return squaredDistanceWithinAVX2(x, y, z, count, r, cutOff2, indices);
+    }
+    if (simd != SIMD::SCALAR && simdSupport() != SIMD::SCALAR)
+    {
+        return squaredDistanceWithinSSE(x, y, z, count, r, cutOff2, indices);
+    }
+    #endif
+    return squaredDistanceWithinScalar(x, y, z, count, r, cutOff2, indices);
+}
+
+/**
+ * @brief Find the candidates within a distance of a point.
+ *
+ * @remark Uses the widest available instruction set, @see squaredDistanceWithin.
+ */
+uint64_t squaredDistanceWithin
+(
+    const float * x,
+    const float * y,
+    const float * z,
+    uint64_t count,
+    glm::vec3 r,
+    float cutOff2,
+    uint32_t * indices
+)
+{
+    return squaredDistanceWithin(x, y, z, count, r, cutOff2, indices, simdSupport());
+}
+
+#endif /* DISTANCEKERNEL_H */
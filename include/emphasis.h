@@ -0,0 +1,116 @@
+#ifndef EMPHASIS_H
+#define EMPHASIS_H
+
+#include <array>
+#include <cstdint>
+
+#include <element.h>
+
+/**
+ * @brief The 32 bit words of an Emphasis mask.
+ *
+ */
+const uint8_t EMPHASIS_WORDS = 4;
+
+static_assert(ELEMENT_COUNT <= 32*EMPHASIS_WORDS, "Emphasis mask too small for the Elements");
+
+/**
+ * @brief GLSL declaring the Emphasis uniforms and float emphasis(int element).
+ *
+ * @remark emphasis returns the alpha multiplier of an Element, one bit per
+ * Element is read from four int uniforms (jGL has no array uniforms).
+ */
+#define EMPHASIS_GLSL \
+    "uniform int deemphasised0;\n" \
+    "uniform int deemphasised1;\n" \
+    "uniform int deemphasised2;\n" \
+    "uniform int deemphasised3;\n" \
+    "uniform float deemphasisAlpha;\n" \
+    "float emphasis(int element)\n" \
+    "{\n" \
+    "    int word = element/32;\n" \
+    "    int mask = word == 0 ? deemphasised0 : (word == 1 ? deemphasised1 : (word == 2 ? deemphasised2 : deemphasised3));\n" \
+    "    return ((mask >> (element-32*word)) & 1) == 1 ? deemphasisAlpha : 1.0;\n" \
+    "}\n"
+
+/**
+ * @brief Which Elements are emphasised, as a bitmask read by the shaders.
+ *
+ * @remark Deemphasised Elements are drawn with their alpha scaled by the
+ * deemphasis alpha. Toggling an Element changes one bit, no Atom data
+ * is written or uploaded.
+ */
+class Emphasis
+{
+public:
+
+    /**
+     * @brief Construct a new Emphasis, every Element emphasised.
+     *
+     * @param deemphasisAlpha the alpha multiplier of deemphasised Elements.
+     */
+    Emphasis(float deemphasisAlpha = 0.25f)
+    : deemphasisAlpha(deemphasisAlpha)
+    {
+        mask.fill(0);
+    }
+
+    /**
+     * @brief Toggle an Element's emphasis.
+     *
+     * @param e the Element.
+     */
+    void toggle(Element e)
+    {
+        const uint16_t i = uint16_t(e);
+        mask[i/32] ^= uint32_t(1) << (i%32);
+    }
+
+    /**
+     * @brief Set an Element's emphasis.
+     *
+     * @param e the Element.
+     * @param emphasised whether the Element is emphasised.
+     */
+    void set(Element e, bool emphasised)
+    {
+        if (isEmphasised(e) != emphasised) { toggle(e); }
+    }
+
+    /**
+     * @brief Whether an Element is emphasised.
+     *
+     * @param e the Element.
+     * @return true if emphasised.
+     * @return false if deemphasised.
+     */
+    bool isEmphasised(Element e) const
+    {
+        const uint16_t i = uint16_t(e);
+        return ((mask[i/32] >> (i%32)) & 1) == 0;
+    }
+
+    /**
+     * @brief The alpha multiplier of an Element.
+     *
+     * @param e the Element.
+     * @return float 1 if emphasised, else the deemphasis alpha.
+     */
+    float alpha(Element e) const { return isEmphasised(e) ? 1.0f : deemphasisAlpha; }
+
+    float getDeemphasisAlpha() const { return deemphasisAlpha; }
+
+    /**
+     * @brief The mask, bit i set if Element i is deemphasised.
+     *
+     * @return const std::array<uint32_t, EMPHASIS_WORDS>& the mask words.
+     */
+    const std::array<uint32_t, EMPHASIS_WORDS> & getMask() const { return mask; }
+
+private:
+
+    float deemphasisAlpha;
+    std::array<uint32_t, EMPHASIS_WORDS> mask;
+};
+
+#endif /* EMPHASIS_H */
@@ -0,0 +1,70 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief The six planes bounding what a projection view matrix draws.
+ *
+ * @remark Planes are taken from the rows of the matrix (Gribb and
+ * Hartmann), with normals pointing inwards, so a point p is inside a plane
+ * when dot(plane.xyz, p)+plane.w >= 0.
+ * @remark The planes are in the space the matrix maps from, giving the
+ * projection view times a model matrix tests model space positions.
+ */
+struct Frustum
+{
+    /**
+     * @brief Construct a Frustum that contains everything.
+     *
+     */
+    Frustum() { planes.fill(glm::vec4(0.0f)); }
+
+    /**
+     * @brief Construct a new Frustum from a projection view matrix.
+     *
+     * @param pv the projection view (times model) matrix.
+     */
+    Frustum(const glm::mat4 & pv)
+    {
+        const glm::vec4 x(pv[0][0], pv[1][0], pv[2][0], pv[3][0]);
+        const glm::vec4 y(pv[0][1], pv[1][1], pv[2][1], pv[3][1]);
+        const glm::vec4 z(pv[0][2], pv[1][2], pv[2][2], pv[3][2]);
+        const glm::vec4 w(pv[0][3], pv[1][3], pv[2][3], pv[3][3]);
+        planes = {w+x, w-x, w+y, w-y, w+z, w-z};
+        for (glm::vec4 & plane : planes)
+        {
+            float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f) { plane /= length; }
+        }
+    }
+
+    /**
+     * @brief Whether a sphere may be drawn.
+     *
+     * @remark Conservative, a sphere near a corner outside the Frustum but
+     * not wholly behind any one plane is kept.
+     * @param centre the centre of the sphere.
+     * @param radius the radius of the sphere.
+     * @return true if the sphere is not wholly outside a plane.
+     * @return false if the sphere is outside.
+     */
+    bool intersects(glm::vec3 centre, float radius) const
+    {
+        for (const glm::vec4 & plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), centre)+plane.w < -radius) { return false; }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Left, right, bottom, top, near and far planes.
+     *
+     */
+    std::array<glm::vec4, 6> planes;
+};
+
+#endif /* FRUSTUM_H */
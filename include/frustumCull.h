@@ -0,0 +1,335 @@
+#ifndef FRUSTUMCULL_H
+#define FRUSTUMCULL_H
+
+#include <cstdint>
+#include <string>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+#include <jGL/OpenGL/gl.h>
+
+#include <glUtils.h>
+#include <frustum.h>
+
+/**
+ * @brief Frustum culling of instances with OpenGL compute shaders.
+ *
+ * @remark The passes are,
+ *  1. count: each work group counts its records inside the Frustum.
+ *  2. scan: prefix sum the counts to work group offsets.
+ *  3. emit: each work group copies its kept records to its offset.
+ * Records keep their order, so depth sorted instances stay sorted. The
+ * final work group writes the instance count of an indirect draw command,
+ * so counts are never read back to draw.
+ * @remark The kept count is read back for information only, once a fence
+ * placed after the cull has signalled, so reading never waits on the GPU.
+ * @remark A record is described by GLSL defining,
+ *  vec4 bound(uint i), the centre and radius of record i's bounding sphere.
+ *  void copy(uint i, uint slot), writing record i to target[] at slot.
+ * reading the source with word(w), halfWord(h) or byteOf(b), indexed from
+ * the source offset.
+ * @remark Requires computeShadersAvailable().
+ */
+class FrustumCull
+{
+public:
+
+    /**
+     * @brief Construct a new FrustumCull.
+     *
+     * @param record the GLSL describing a record.
+     * @param vectors the uvec4s copy writes per record.
+     */
+    FrustumCull(const std::string & record, uint8_t vectors)
+    : vectors(vectors)
+    {
+        program = compileComputeProgram(header+record+cullShader);
+        scan = compileComputeProgram(PREFIX_SUM_COMPUTE_GLSL);
+
+        glGenBuffers(1, &groupCounts);
+        glGenBuffers(1, &groupOffsets);
+        glGenBuffers(1, &target);
+        glGenBuffers(1, &command);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commandWords), commandWords.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    ~FrustumCull()
+    {
+        glDeleteProgram(program);
+        glDeleteProgram(scan);
+        glDeleteBuffers(1, &groupCounts);
+        glDeleteBuffers(1, &groupOffsets);
+        glDeleteBuffers(1, &target);
+        glDeleteBuffers(1, &command);
+        if (fence != nullptr) { glDeleteSync(fence); }
+    }
+
+    FrustumCull(const FrustumCull &) = delete;
+    FrustumCull & operator=(const FrustumCull &) = delete;
+
+    /**
+     * @brief Use the culling program, to set the record's uniforms.
+     *
+     */
+    void use() const { glUseProgram(program); }
+
+    /**
+     * @brief The location of a uniform of the record.
+     *
+     * @param name the uniform's name.
+     * @return GLint the location.
+     */
+    GLint uniform(const char * name) const { return glGetUniformLocation(program, name); }
+
+    /**
+     * @brief Copy the records inside a Frustum to the target.
+     *
+     * @param frustum the Frustum, in the space of the bounding spheres.
+     * @param source the buffer of records.
+     * @param offset the byte offset of the records in source, a multiple of 4.
+     * @param records the number of records.
+     * @param sourceCommand if not 0, a draw command buffer whose instance
+     * count (at most records) is the number of records, e.g. written on the GPU.
+     */
+    void cull
+    (
+        const Frustum & frustum,
+        GLuint source,
+        uint64_t offset,
+        uint64_t records,
+        GLuint sourceCommand = 0
+    )
+    {
+        readCount();
+        // A cull still in flight is superseded by this one.
+        if (fence != nullptr) { glDeleteSync(fence); fence = nullptr; }
+        if (records == 0)
+        {
+            uint32_t none = 0;
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, sizeof(uint32_t), sizeof(uint32_t), &none);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            lastKept = 0;
+            return;
+        }
+        reserve(records);
+        const uint32_t groups = uint32_t((records+WORKGROUP-1)/WORKGROUP);
+
+        // Sources written by compute shaders are visible to this one.
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // Bind the source from an aligned base near the offset, so the
+        // word offset left for the shader fits its 32 bit uniform.
+        const uint64_t base = bindSource(source, offset);
+        bindBase(1, groupCounts);
+        bindBase(2, target);
+        bindBase(3, groupOffsets);
+        bindBase(4, command);
+        bindBase(5, sourceCommand == 0 ? command : sourceCommand);
+
+        glUseProgram(program);
+        glUniform4fv(glGetUniformLocation(program, "planes"), 6, &frustum.planes[0][0]);
+        glUniform1ui(glGetUniformLocation(program, "sourceOffset"), GLuint((offset-base)/sizeof(uint32_t)));
+        glUniform1ui(glGetUniformLocation(program, "records"), GLuint(records));
+        glUniform1i(glGetUniformLocation(program, "countFromCommand"), sourceCommand == 0 ? 0 : 1);
+        glUniform1i(glGetUniformLocation(program, "emit"), 0);
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(scan);
+        glUniform1ui(glGetUniformLocation(scan, "count"), groups);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "emit"), 1);
+        glDispatchCompute(groups, 1, 1);
+
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        glUseProgram(0);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    /**
+     * @brief Read back the records kept by the last cull, if it has finished.
+     *
+     * @remark Until the cull's fence has signalled the previous count is
+     * kept, so reading never stalls.
+     */
+    void readCount()
+    {
+        if (fence == nullptr) { return; }
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) { return; }
+        glDeleteSync(fence);
+        fence = nullptr;
+        uint32_t kept = 0;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+        glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, sizeof(uint32_t), sizeof(uint32_t), &kept);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        lastKept = kept;
+    }
+
+    /**
+     * @brief Set the draw command, other than the instance count.
+     *
+     * @remark The command is read as glDrawArraysIndirect's (count,
+     * instanceCount, first, baseInstance) or glDrawElementsIndirect's
+     * (count, instanceCount, firstIndex, baseVertex, baseInstance).
+     * @param count the vertices or indices per instance.
+     * @param first the first vertex or index.
+     * @param baseVertex the base vertex of indexed draws, else 0.
+     */
+    void setCommand(GLuint count, GLuint first = 0, GLint baseVertex = 0)
+    {
+        const std::array<uint32_t, 3> words = {count, first, uint32_t(baseVertex)};
+        if (words[0] == commandWords[0] && words[1] == commandWords[2] && words[2] == commandWords[3]) { return; }
+        commandWords[0] = words[0];
+        commandWords[2] = words[1];
+        commandWords[3] = words[2];
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(uint32_t), &commandWords[0]);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 2*sizeof(uint32_t), 2*sizeof(uint32_t), &commandWords[2]);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    /**
+     * @brief The buffer of kept records, vectors uvec4s each.
+     *
+     * @return GLuint the buffer id.
+     */
+    GLuint targetBuffer() const { return target; }
+
+    /**
+     * @brief The indirect draw command buffer.
+     *
+     * @return GLuint the buffer id.
+     */
+    GLuint commandBuffer() const { return command; }
+
+    /**
+     * @brief The records kept by the last cull read back.
+     *
+     * @return uint64_t the kept records, @see readCount.
+     */
+    uint64_t lastCount() const { return lastKept; }
+
+private:
+
+    static const uint32_t WORKGROUP = 128;
+
+    uint8_t vectors;
+    uint64_t capacity = 0;
+    uint64_t lastKept = 0;
+    GLsync fence = nullptr;
+
+    GLuint program, scan;
+    GLuint groupCounts, groupOffsets, target, command;
+
+    std::array<uint32_t, 5> commandWords = {4, 0, 0, 0, 0};
+
+    void bindBase(GLuint binding, GLuint buffer)
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    }
+
+    uint64_t bindSource(GLuint source, uint64_t offset)
+    {
+        GLint alignment = 1;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        const uint64_t base = offset-offset%uint64_t(std::max(alignment, 1));
+        GLint64 size = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, source);
+        glGetBufferParameteri64v(GL_SHADER_STORAGE_BUFFER, GL_BUFFER_SIZE, &size);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        if (uint64_t(size) <= base)
+        {
+            throw std::runtime_error("FrustumCull source offset "+std::to_string(offset)+" is past the end of the buffer");
+        }
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, source, GLintptr(base), GLsizeiptr(uint64_t(size)-base));
+        return base;
+    }
+
+    void allocate(GLuint buffer, uint64_t bytes)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    /**
+     * @brief Grow the buffers to hold a number of records.
+     *
+     * @remark The target keeps its id, so vertex arrays pointing at it
+     * stay valid.
+     */
+    void reserve(uint64_t records)
+    {
+        if (records <= capacity) { return; }
+        capacity = records+records/4;
+        const uint64_t groups = (capacity+WORKGROUP-1)/WORKGROUP;
+        allocate(groupCounts, groups*sizeof(uint32_t));
+        allocate(groupOffsets, groups*sizeof(uint32_t));
+        allocate(target, capacity*vectors*4*sizeof(uint32_t));
+    }
+
+    const std::string header =
+        "#version 430\n"
+        "layout(local_size_x = 128) in;\n"
+        "layout(std430, binding = 0) readonly buffer Source { uint source[]; };\n"
+        "layout(std430, binding = 1) buffer GroupCounts { uint groupCounts[]; };\n"
+        "layout(std430, binding = 2) writeonly buffer Target { uvec4 target[]; };\n"
+        "layout(std430, binding = 3) readonly buffer GroupOffsets { uint groupOffsets[]; };\n"
+        "layout(std430, binding = 4) buffer Command { uint vertices; uint instanceCount; uint first; uint baseVertex; uint baseInstance; };\n"
+        "layout(std430, binding = 5) readonly buffer SourceCommand { uint sourceCommand[]; };\n"
+        "uniform vec4 planes[6];\n"
+        "uniform uint sourceOffset;\n"
+        "uniform uint records;\n"
+        "uniform int countFromCommand;\n"
+        "uniform int emit;\n"
+        "uint word(uint w) { return source[sourceOffset+w]; }\n"
+        "uint halfWord(uint h) { return (word(h >> 1u) >> ((h & 1u)*16u)) & 0xffffu; }\n"
+        "uint byteOf(uint b) { return (word(b >> 2u) >> ((b & 3u)*8u)) & 0xffu; }\n";
+
+    const char * cullShader =
+        "shared uint partial[128];\n"
+        "void main()\n"
+        "{\n"
+        "    uint i = gl_GlobalInvocationID.x;\n"
+        "    uint t = gl_LocalInvocationID.x;\n"
+        "    uint g = gl_WorkGroupID.x;\n"
+        "    uint n = countFromCommand == 1 ? min(records, sourceCommand[1]) : records;\n"
+        "    bool keep = false;\n"
+        "    if (i < n)\n"
+        "    {\n"
+        "        vec4 sphere = bound(i);\n"
+        "        keep = true;\n"
+        "        for (int p = 0; p < 6; p++)\n"
+        "        {\n"
+        "            if (dot(planes[p].xyz, sphere.xyz)+planes[p].w < -sphere.w) { keep = false; }\n"
+        "        }\n"
+        "    }\n"
+        // Inclusive scan of the kept flags in the work group.
+        "    partial[t] = keep ? 1u : 0u;\n"
+        "    barrier();\n"
+        "    for (uint o = 1u; o < 128u; o <<= 1u)\n"
+        "    {\n"
+        "        uint add = t >= o ? partial[t-o] : 0u;\n"
+        "        barrier();\n"
+        "        partial[t] += add;\n"
+        "        barrier();\n"
+        "    }\n"
+        "    if (emit == 0)\n"
+        "    {\n"
+        "        if (t == 127u) { groupCounts[g] = partial[127]; }\n"
+        "        return;\n"
+        "    }\n"
+        "    if (keep) { copy(i, groupOffsets[g]+partial[t]-1u); }\n"
+        "    if (t == 127u && g == gl_NumWorkGroups.x-1u) { instanceCount = groupOffsets[g]+partial[127]; }\n"
+        "}";
+};
+
+#endif /* FRUSTUMCULL_H */
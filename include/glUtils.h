@@ -1,6 +1,10 @@
 #ifndef GLUTILS_H
 #define GLUTILS_H
 
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
 #include <jGL/OpenGL/gl.h>
@@ -56,6 +60,46 @@ void enableBuffer
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+/**
+ * @brief Point a vertex attribute into an interleaved GL_ARRAY_BUFFER.
+ *
+ * @param buffer the GL_ARRAY_BUFFER id.
+ * @param attribute the vertex attribute.
+ * @param size the dimension.
+ * @param type the component type, e.g. GL_FLOAT or GL_UNSIGNED_SHORT.
+ * @param normalised whether integer components are mapped to [0, 1].
+ * @param stride the bytes between consecutive vertices.
+ * @param offset the byte offset of the attribute in the buffer, 64 bit
+ * as stream segments of large buffers may start past 4 GiB.
+ * @param divisor the instance divisor.
+ */
+void interleavedAttribute
+(
+    GLuint & buffer,
+    GLuint attribute,
+    GLuint size,
+    GLenum type,
+    bool normalised,
+    GLuint stride,
+    GLintptr offset,
+    GLuint divisor
+)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribPointer
+        (
+            attribute,
+            size,
+            type,
+            normalised,
+            stride,
+            (void*)(uintptr_t(offset))
+        );
+        glVertexAttribDivisor(attribute, divisor);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 /**
  * @brief Create a GL_ARRAY_BUFFER from data.
  *
@@ -100,4 +144,133 @@ void createBuffer
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+/**
+ * @brief Check for compute shader support.
+ *
+ * @remark Requires OpenGL 4.3, unavailable on macOS. The compute shaders
+ * are GLSL 430, so older contexts with the ARB extensions alone use the
+ * CPU paths rather than fail to compile.
+ * @return true if compute shaders, storage buffers, buffer clears and
+ * indirect draws are supported.
+ * @return false otherwise.
+ */
+bool computeShadersAvailable()
+{
+    return GLEW_VERSION_4_3 &&
+        glDispatchCompute != nullptr &&
+        glBindBufferBase != nullptr &&
+        glMemoryBarrier != nullptr &&
+        glClearBufferSubData != nullptr &&
+        glDrawArraysIndirect != nullptr;
+}
+
+/**
+ * @brief Check for persistently mappable buffer support.
+ *
+ * @remark Requires OpenGL 4.4 (or ARB_buffer_storage), unavailable on macOS.
+ * @return true if immutable buffer storage and persistent mapping are supported.
+ * @return false otherwise.
+ */
+bool bufferStorageAvailable()
+{
+    return (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) &&
+        glBufferStorage != nullptr &&
+        glFenceSync != nullptr;
+}
+
+/**
+ * @brief Check for multi draw indirect support.
+ *
+ * @remark Requires OpenGL 4.3 (or the equivalent extensions), unavailable
+ * on macOS.
+ * @return true if glMultiDrawElementsIndirect with base instances is supported.
+ * @return false otherwise.
+ */
+bool multiDrawIndirectAvailable()
+{
+    bool extensions = GLEW_VERSION_4_3 ||
+    (
+        GLEW_ARB_multi_draw_indirect &&
+        GLEW_ARB_draw_indirect &&
+        GLEW_ARB_base_instance
+    );
+    return extensions && glMultiDrawElementsIndirect != nullptr;
+}
+
+/**
+ * @brief An exclusive prefix sum compute shader.
+ *
+ * @remark Reads count uints bound at 1, writes their offsets bound at 3.
+ * A single work group loops over blocks of 256 with a carry, so dispatch
+ * (1, 1, 1).
+ */
+#define PREFIX_SUM_COMPUTE_GLSL \
+    "#version 430\n" \
+    "layout(local_size_x = 256) in;\n" \
+    "layout(std430, binding = 1) readonly buffer Values { uint values[]; };\n" \
+    "layout(std430, binding = 3) writeonly buffer Offsets { uint offsets[]; };\n" \
+    "uniform uint count;\n" \
+    "shared uint partial[256];\n" \
+    "void main()\n" \
+    "{\n" \
+    "    uint t = gl_LocalInvocationID.x;\n" \
+    "    uint carry = 0u;\n" \
+    "    for (uint base = 0u; base < count; base += 256u)\n" \
+    "    {\n" \
+    "        uint v = base+t < count ? values[base+t] : 0u;\n" \
+    "        partial[t] = v;\n" \
+    "        barrier();\n" \
+    "        for (uint o = 1u; o < 256u; o <<= 1u)\n" \
+    "        {\n" \
+    "            uint add = t >= o ? partial[t-o] : 0u;\n" \
+    "            barrier();\n" \
+    "            partial[t] += add;\n" \
+    "            barrier();\n" \
+    "        }\n" \
+    "        if (base+t < count) { offsets[base+t] = carry+partial[t]-v; }\n" \
+    "        carry += partial[255];\n" \
+    "        barrier();\n" \
+    "    }\n" \
+    "}"
+
+/**
+ * @brief Compile and link a compute shader program.
+ *
+ * @param source the GLSL source.
+ * @return GLuint the program id.
+ * @remark Throws std::runtime_error with the info log on failure.
+ */
+GLuint compileComputeProgram(const std::string & source)
+{
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    const char * code = source.c_str();
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, log);
+        glDeleteShader(shader);
+        throw std::runtime_error("Compute shader compilation failed: "+std::string(log));
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, 1024, NULL, log);
+        glDeleteProgram(program);
+        throw std::runtime_error("Compute shader linking failed: "+std::string(log));
+    }
+    return program;
+}
+
 #endif /* GLUTILS_H */
@@ -11,6 +11,8 @@
 #include <memory>
 #include <limits>
 #include <numeric>
+#include <unordered_map>
+#include <functional>
 
 #include <glm/glm.hpp>
 
@@ -235,6 +237,68 @@ public:
     return n;
   }
 
+  /**
+   * @brief Get the mesh with shared vertices welded and indexed triangles.
+   *
+   * @remark Each vertex is stored once rather than in each of its
+   * triangles (about 6 times). Vertices are welded by a hash of their exact
+   * coordinates, subdivision computes shared midpoints identically.
+   * @remark Normals are smooth, the normalised vertex positions.
+   * @param vertices the unique vertices, flattened.
+   * @param normals the vertex normals, flattened.
+   * @param indices 3 vertex indices per triangle, in vertices() order.
+   */
+  void indexed
+  (
+    std::vector<T> & vertices,
+    std::vector<T> & normals,
+    std::vector<uint32_t> & indices
+  ) const
+  {
+    struct VertexHash
+    {
+      std::size_t operator()(const std::array<T, 3> & v) const
+      {
+        std::size_t h = 0;
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          h ^= std::hash<T>()(v[k]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        }
+        return h;
+      }
+    };
+
+    std::vector<uint32_t> leaves = leafIndices();
+    std::unordered_map<std::array<T, 3>, uint32_t, VertexHash> welded;
+    welded.reserve(leaves.size());
+    vertices.clear();
+    normals.clear();
+    indices.clear();
+    indices.reserve(3*leaves.size());
+    for (uint32_t i = 0; i < leaves.size(); i++)
+    {
+      auto u = mesh[leaves[i]].getVertices();
+      for (uint32_t j = 0; j < u.size(); j++)
+      {
+        // -0 and 0 are the same vertex.
+        std::array<T, 3> v;
+        for (uint8_t k = 0; k < 3; k++) { v[k] = u[j][k] == T(0) ? T(0) : T(u[j][k]); }
+        auto found = welded.find(v);
+        if (found == welded.end())
+        {
+          found = welded.insert({v, uint32_t(welded.size())}).first;
+          T length = std::sqrt(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]);
+          for (uint8_t k = 0; k < 3; k++)
+          {
+            vertices.push_back(v[k]);
+            normals.push_back(v[k]/length);
+          }
+        }
+        indices.push_back(found->second);
+      }
+    }
+  }
+
 private:
 
   uint32_t depth;
@@ -0,0 +1,135 @@
+#ifndef LEVELOFDETAIL_H
+#define LEVELOFDETAIL_H
+
+#include <cstdint>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <parallel.h>
+
+/**
+ * @brief Choose per Atom levels of detail from projected screen radii.
+ *
+ * @remark Atoms are bucketed by level, bucket l < impostor() draws mesh l
+ * and bucket impostor() draws impostors.
+ * @remark A mesh is chosen so its visible triangles cover at most
+ * pixelsPerTriangle pixels, spheres under impostorPixels in radius are
+ * impostors.
+ */
+class LevelOfDetail
+{
+public:
+
+    /**
+     * @brief Construct a new LevelOfDetail.
+     *
+     * @param triangleCounts the triangles of each mesh, increasing.
+     * @param pixelsPerTriangle the target screen area of a triangle.
+     * @param impostorPixels the projected radius below which impostors are drawn.
+     */
+    LevelOfDetail
+    (
+        std::vector<uint32_t> triangleCounts,
+        float pixelsPerTriangle = 16.0f,
+        float impostorPixels = 4.0f
+    )
+    : triangleCounts(triangleCounts),
+      pixelsPerTriangle(pixelsPerTriangle),
+      impostorPixels(impostorPixels)
+    {}
+
+    /**
+     * @brief The impostor bucket.
+     *
+     * @return uint8_t one past the finest mesh.
+     */
+    uint8_t impostor() const { return triangleCounts.size(); }
+
+    /**
+     * @brief The bucket for a projected radius.
+     *
+     * @param pixels the projected sphere radius in pixels.
+     * @param maxLevel the finest mesh to use.
+     * @return uint8_t the bucket.
+     */
+    uint8_t level(float pixels, uint8_t maxLevel) const
+    {
+        if (!(pixels >= impostorPixels)) { return impostor(); }
+        // The visible half of the mesh covers pi*pixels^2.
+        float triangles = 2.0f*float(M_PI)*pixels*pixels/pixelsPerTriangle;
+        maxLevel = std::min(maxLevel, uint8_t(impostor()-1));
+        for (uint8_t l = 0; l < maxLevel; l++)
+        {
+            if (triangleCounts[l] >= triangles) { return l; }
+        }
+        return maxLevel;
+    }
+
+    /**
+     * @brief Group indices by bucket, stably, with a parallel counting sort.
+     *
+     * @param buckets the bucket of each index.
+     * @param order the indices ordered by bucket.
+     * @param offsets bucket b is order[offsets[b]] to order[offsets[b+1]-1].
+     */
+    void sort
+    (
+        const std::vector<uint8_t> & buckets,
+        std::vector<uint64_t> & order,
+        std::vector<uint64_t> & offsets
+    ) const
+    {
+        const uint16_t nb = uint16_t(impostor())+1;
+        const uint64_t n = buckets.size();
+        const unsigned threads = parallelThreads(n);
+        std::vector<uint64_t> counts(threads*nb, 0);
+
+        parallelFor
+        (
+            n,
+            threads,
+            [&](uint64_t begin, uint64_t end, unsigned t)
+            {
+                for (uint64_t i = begin; i < end; i++) { counts[t*nb+buckets[i]]++; }
+            }
+        );
+
+        // Each thread starts after every earlier thread's atoms in its bucket.
+        offsets.assign(nb+1, 0);
+        uint64_t position = 0;
+        for (uint16_t b = 0; b < nb; b++)
+        {
+            offsets[b] = position;
+            for (unsigned t = 0; t < threads; t++)
+            {
+                uint64_t c = counts[t*nb+b];
+                counts[t*nb+b] = position;
+                position += c;
+            }
+        }
+        offsets[nb] = position;
+
+        order.resize(n);
+        parallelFor
+        (
+            n,
+            threads,
+            [&](uint64_t begin, uint64_t end, unsigned t)
+            {
+                for (uint64_t i = begin; i < end; i++) { order[counts[t*nb+buckets[i]]++] = i; }
+            }
+        );
+    }
+
+    float getPixelsPerTriangle() const { return pixelsPerTriangle; }
+    float getImpostorPixels() const { return impostorPixels; }
+
+private:
+
+    std::vector<uint32_t> triangleCounts;
+    float pixelsPerTriangle;
+    float impostorPixels;
+};
+
+#endif /* LEVELOFDETAIL_H */
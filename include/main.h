@@ -21,18 +21,19 @@
 #include <util.h>
 #include <glUtils.h>
 #include <structureUtils.h>
+#include <bricks.h>
 #include <commandLine.h>
 #include <xyz.h>
 #include <config.h>
 #include <camera.h>
 #include <cell.h>
+#include <bvh.h>
+#include <emphasis.h>
 
 const float dr = (1.0)*0.5;
 const float dtheta = (3.14)*0.025;
 const float dphi = (2.0*3.14)*0.05;
 
-const float emphasisedAlpha = 1.0f;
-
 std::unique_ptr<jGL::jGLInstance> jGLInstance;
 
 /**
@@ -70,85 +71,63 @@ void cameraControls(jGL::DesktopDisplay & display, Camera & camera)
 }
 
 /**
- * @brief Controls for the Atoms position's
+ * @brief Controls for the Atoms position's and emphasis.
  *
+ * @remark Translation only changes offset, applied by the renderers' model
+ * matrices, so it costs nothing per Atom. Likewise emphasis only changes
+ * the Emphasis mask.
  * @param display the display to get events from.
- * @param atoms the Atoms to modify.
+ * @param offset the translation of the Atoms in the scene.
  * @param emphasisControls key bindings to emphasise elements.
+ * @param emphasis the Element emphasis to toggle.
  *
- * @return true if the Atoms were modified.
- * @return false if the Atoms were not modified.
+ * @return true if the emphasis changed.
+ * @return false if the emphasis did not change.
  */
 bool atomControls
 (
     jGL::DesktopDisplay & display,
-    std::vector<Atom> & atoms,
+    glm::vec3 & offset,
     std::map<int, Element> & emphasisControls,
-    std::multimap<Element, uint64_t> & elementMap,
-    std::vector<float> & alphaOverrides,
-    float deemphasisAlpha
+    Emphasis & emphasis
 )
 {
-    bool elementsNeedUpdate = false;
+    bool emphasisChanged = false;
     if (display.keyHasEvent(GLFW_KEY_LEFT, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_LEFT, jGL::EventType::HOLD))
     {
-        translate(atoms, {-dr, 0.0, 0.0});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{-dr, 0.0, 0.0};
     }
     if (display.keyHasEvent(GLFW_KEY_RIGHT, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_RIGHT, jGL::EventType::HOLD))
     {
-        translate(atoms, {dr, 0.0, 0.0});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{dr, 0.0, 0.0};
     }
     if (display.keyHasEvent(GLFW_KEY_PERIOD, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_PERIOD, jGL::EventType::HOLD))
     {
-        translate(atoms, {0.0, -dr, 0.0});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{0.0, -dr, 0.0};
     }
     if (display.keyHasEvent(GLFW_KEY_SLASH, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_SLASH, jGL::EventType::HOLD))
     {
-        translate(atoms, {0.0, dr, 0.0});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{0.0, dr, 0.0};
     }
     if (display.keyHasEvent(GLFW_KEY_DOWN, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_DOWN, jGL::EventType::HOLD))
     {
-        translate(atoms, {0.0, 0.0, -dr});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{0.0, 0.0, -dr};
     }
     if (display.keyHasEvent(GLFW_KEY_UP, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_UP, jGL::EventType::HOLD))
     {
-        translate(atoms, {0.0, 0.0, dr});
-        elementsNeedUpdate = true;
+        offset += glm::vec3{0.0, 0.0, dr};
     }
 
     for (const auto & control : emphasisControls)
     {
         if (display.keyHasEvent(control.first, jGL::EventType::PRESS))
         {
-            auto iter = elementMap.equal_range(control.second);
-            while (iter.first != iter.second)
-            {
-                float & alpha = alphaOverrides[iter.first->second];
-                alpha = (alpha == emphasisedAlpha ? deemphasisAlpha : emphasisedAlpha);
-                atoms[iter.first->second].colour.a = alpha;
-                iter.first++;
-            }
-            elementsNeedUpdate = true;
+            emphasis.toggle(control.second);
+            emphasisChanged = true;
         }
     }
 
-    return elementsNeedUpdate;
-}
-
-/**
- * @brief Set the alpha channel of Atom colours.
- *
- * @param atoms the atoms to set.
- * @param alphas the alphas to set.
- */
-void setAlpha(std::vector<Atom> & atoms, std::vector<float> alphas)
-{
-    for (uint64_t i = 0; i < atoms.size(); i++) { atoms[i].colour.a = alphas[i]; }
+    return emphasisChanged;
 }
 
 /**
@@ -0,0 +1,79 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+#include <atom.h>
+
+/**
+ * @brief Spread the lower 21 bits of x so there are 2 zero bits between each.
+ *
+ */
+uint64_t spreadBits(uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+/**
+ * @brief The 63 bit Morton (Z-order) code of a position in a box.
+ *
+ * @param r the position.
+ * @param min the lower corner of the box.
+ * @param max the upper corner of the box.
+ * @return uint64_t the Morton code, 21 bits per axis.
+ */
+uint64_t mortonCode(glm::vec3 r, glm::vec3 min, glm::vec3 max)
+{
+    const float levels = float((1 << 21)-1);
+    glm::vec3 extent = glm::max(max-min, glm::vec3(std::numeric_limits<float>::min()));
+    glm::vec3 u = glm::clamp((r-min)/extent, 0.0f, 1.0f)*levels;
+    return spreadBits(uint64_t(u.x)) | (spreadBits(uint64_t(u.y)) << 1) | (spreadBits(uint64_t(u.z)) << 2);
+}
+
+/**
+ * @brief The Atom order along a Morton curve.
+ *
+ * @param atoms the Atoms to order.
+ * @return std::vector<uint64_t> order[i] is the index in atoms of the i'th Atom along the curve.
+ * @remark The sort is stable, ties keep their original order.
+ */
+std::vector<uint64_t> mortonOrder(const AtomStore & atoms)
+{
+    std::vector<uint64_t> order(atoms.size());
+    if (atoms.empty()) { return order; }
+
+    glm::vec3 min = atoms.position(0);
+    glm::vec3 max = atoms.position(0);
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        min = glm::min(min, atoms.position(i));
+        max = glm::max(max, atoms.position(i));
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> codes(atoms.size());
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        codes[i] = {mortonCode(atoms.position(i), min, max), i};
+    }
+    std::stable_sort
+    (
+        codes.begin(),
+        codes.end(),
+        [](const auto & a, const auto & b) { return a.first < b.first; }
+    );
+    for (uint64_t i = 0; i < atoms.size(); i++) { order[i] = codes[i].second; }
+    return order;
+}
+
+#endif /* MORTON_H */
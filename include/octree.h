@@ -0,0 +1,425 @@
+#ifndef OCTREE_H
+#define OCTREE_H
+
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include <atom.h>
+#include <element.h>
+#include <morton.h>
+#include <frustum.h>
+#include <parallel.h>
+
+/**
+ * @brief A node of an Octree, with the aggregate of its Atoms.
+ *
+ * @remark The children of a node are stored together, from firstChild.
+ */
+struct OctreeNode
+{
+    /**
+     * @brief The mean position of the node's Atoms.
+     *
+     */
+    glm::vec3 centre;
+
+    /**
+     * @brief The furthest Atom centre from centre.
+     *
+     */
+    float spread;
+
+    /**
+     * @brief The largest Atom radius.
+     *
+     */
+    float maxRadius;
+
+    /**
+     * @brief The sum of the cubed Atom radii.
+     *
+     */
+    float volume;
+
+    /**
+     * @brief First Atom of the node in Octree::order.
+     *
+     */
+    uint64_t start;
+
+    /**
+     * @brief Number of Atoms in the node.
+     *
+     */
+    uint64_t count;
+
+    /**
+     * @brief Index of the first child.
+     *
+     */
+    uint64_t firstChild;
+
+    /**
+     * @brief Number of children, 0 for a leaf.
+     *
+     */
+    uint8_t children;
+
+    /**
+     * @brief The dominant Element id of the node's Atoms.
+     *
+     * @remark Exact for leaves, above them the most common dominant
+     * Element of the children weighted by their Atoms.
+     */
+    uint8_t element;
+
+    /**
+     * @brief The mean alpha of the node's Atoms.
+     *
+     */
+    uint8_t alpha;
+
+    bool leaf() const { return children == 0; }
+
+    /**
+     * @brief The radius of a sphere enclosing the node's Atom spheres.
+     *
+     * @param scaling the Atom radius scaling factor.
+     * @return float the bounding radius about centre.
+     */
+    float bound(float scaling = 1.0f) const { return spread+maxRadius*scaling; }
+
+    /**
+     * @brief The radius of one sphere standing in for the node's Atoms.
+     *
+     * @remark The sphere has the Atoms' total volume, so dense regions
+     * fill the node and sparse regions stay sparse, but never exceeds the
+     * bound.
+     * @param scaling the Atom radius scaling factor.
+     * @return float the fused radius.
+     */
+    float fusedRadius(float scaling = 1.0f) const { return std::min(std::cbrt(volume), bound(1.0f))*scaling; }
+};
+
+/**
+ * @brief An octree over Atoms, nodes aggregating the Atoms below them.
+ *
+ * @remark Built from sorted Morton codes, each node is the Atoms sharing
+ * a code prefix, so a node's Atoms are contiguous in order and children
+ * split their parent's cube into (non-empty) octants. Codes are computed
+ * and sorted in parallel.
+ * @remark Cutting the tree by screen-space error gives near regions as
+ * their Atoms and far regions as single aggregates, @see select.
+ * @remark Atoms are given by index, so any subset of a larger set of
+ * Atoms can be indexed.
+ */
+class Octree
+{
+public:
+
+    /**
+     * @brief Construct an empty Octree.
+     *
+     * @param leafSize maximum Atoms per leaf, unless their codes match.
+     */
+    Octree(uint64_t leafSize = 16)
+    : leafSize(std::max(leafSize, uint64_t(1)))
+    {}
+
+    /**
+     * @brief Construct an Octree over some Atoms.
+     *
+     * @param atoms the Atoms to index.
+     * @param leafSize maximum Atoms per leaf, unless their codes match.
+     */
+    Octree(const AtomStore & atoms, uint64_t leafSize = 16)
+    : Octree(leafSize)
+    {
+        build(atoms);
+    }
+
+    /**
+     * @brief Build the tree over some Atoms.
+     *
+     * @param atoms the Atoms to index.
+     */
+    void build(const AtomStore & atoms)
+    {
+        build
+        (
+            atoms.size(),
+            [&atoms](uint64_t i) { return atoms.position(i); },
+            [&atoms](uint64_t i) { return uint8_t(atoms.element(i)); },
+            [&atoms](uint64_t i) { return atoms.getAlphas()[i]; },
+            atoms.getPalette().getRadii()
+        );
+    }
+
+    /**
+     * @brief Build the tree over Atoms given by accessors.
+     *
+     * @param count the number of Atoms.
+     * @param position position(i) is the position of Atom i.
+     * @param element element(i) is the Element id of Atom i.
+     * @param alpha alpha(i) is the alpha byte of Atom i.
+     * @param radii the radius of each Element.
+     */
+    template <class Position, class Id, class Alpha>
+    void build
+    (
+        uint64_t count,
+        Position position,
+        Id element,
+        Alpha alpha,
+        const std::array<float, ELEMENT_COUNT> & radii
+    )
+    {
+        nodes.clear();
+        order.resize(count);
+        if (count == 0) { return; }
+
+        glm::vec3 min = position(0);
+        glm::vec3 max = position(0);
+        for (uint64_t i = 1; i < count; i++)
+        {
+            min = glm::min(min, position(i));
+            max = glm::max(max, position(i));
+        }
+
+        std::vector<std::pair<uint64_t, uint64_t>> codes(count);
+        const unsigned threads = parallelThreads(count);
+        std::vector<uint64_t> chunks(threads+1, count);
+        parallelFor
+        (
+            count,
+            threads,
+            [&](uint64_t begin, uint64_t end, unsigned t)
+            {
+                for (uint64_t i = begin; i < end; i++) { codes[i] = {mortonCode(position(i), min, max), i}; }
+                std::sort(codes.begin()+begin, codes.begin()+end);
+                chunks[t] = begin;
+            }
+        );
+        // Merge the sorted chunks pairwise.
+        for (unsigned width = 1; width < threads; width *= 2)
+        {
+            for (unsigned t = 0; t+width < threads; t += 2*width)
+            {
+                std::inplace_merge
+                (
+                    codes.begin()+chunks[t],
+                    codes.begin()+chunks[t+width],
+                    codes.begin()+chunks[std::min(t+2*width, threads)]
+                );
+            }
+        }
+
+        std::vector<uint64_t> keys(count);
+        for (uint64_t k = 0; k < count; k++)
+        {
+            keys[k] = codes[k].first;
+            order[k] = codes[k].second;
+        }
+
+        nodes.push_back({});
+        buildNode(keys, 0, 0, count, 0, position, element, alpha, radii);
+    }
+
+    /**
+     * @brief Cut the tree by screen-space error.
+     *
+     * @remark Nodes outside the Frustum are skipped. A node whose bounding
+     * sphere projects to at most pixels in radius is drawn as an aggregate,
+     * otherwise its children are visited, down to leaves whose Atoms are
+     * drawn themselves.
+     * @remark Each Atom in view is covered once, by itself or by one
+     * aggregate.
+     * @param frustum the Frustum, in the space of the Atoms.
+     * @param eye the camera position, in the space of the Atoms.
+     * @param pixelScale the projected pixel radius of a unit sphere at unit distance.
+     * @param pixels the largest projected radius of an aggregate.
+     * @param scaling the Atom radius scaling factor.
+     * @param atoms the indices of Atoms drawn themselves.
+     * @param aggregates the indices of nodes drawn as aggregates.
+     */
+    void select
+    (
+        const Frustum & frustum,
+        glm::vec3 eye,
+        float pixelScale,
+        float pixels,
+        float scaling,
+        std::vector<uint64_t> & atoms,
+        std::vector<uint64_t> & aggregates
+    ) const
+    {
+        atoms.clear();
+        aggregates.clear();
+        if (nodes.empty()) { return; }
+        std::vector<uint64_t> stack = {0};
+        while (!stack.empty())
+        {
+            const OctreeNode & node = nodes[stack.back()];
+            const uint64_t n = stack.back();
+            stack.pop_back();
+            const float bound = node.bound(scaling);
+            if (!frustum.intersects(node.centre, bound)) { continue; }
+            const float distance = glm::length(node.centre-eye)-bound;
+            const bool small = node.count > 1 && distance > 0.0f && bound*pixelScale <= pixels*distance;
+            if (small)
+            {
+                aggregates.push_back(n);
+            }
+            else if (node.leaf())
+            {
+                atoms.insert(atoms.end(), order.begin()+node.start, order.begin()+node.start+node.count);
+            }
+            else
+            {
+                for (uint8_t c = node.children; c > 0; c--) { stack.push_back(node.firstChild+c-1); }
+            }
+        }
+    }
+
+    const std::vector<OctreeNode> & getNodes() const { return nodes; }
+
+    /**
+     * @brief The Atoms in Morton order, node Atoms are contiguous.
+     *
+     * @return const std::vector<uint64_t>& the Atom indices.
+     */
+    const std::vector<uint64_t> & getOrder() const { return order; }
+
+    uint64_t size() const { return order.size(); }
+
+private:
+
+    uint64_t leafSize;
+
+    std::vector<OctreeNode> nodes;
+    std::vector<uint64_t> order;
+
+    static const uint8_t LEVELS = 21;
+
+    template <class Position, class Id, class Alpha>
+    void buildNode
+    (
+        const std::vector<uint64_t> & keys,
+        uint64_t n,
+        uint64_t start,
+        uint64_t count,
+        uint8_t depth,
+        Position & position,
+        Id & element,
+        Alpha & alpha,
+        const std::array<float, ELEMENT_COUNT> & radii
+    )
+    {
+        nodes[n].start = start;
+        nodes[n].count = count;
+        nodes[n].children = 0;
+        nodes[n].firstChild = 0;
+
+        if (count > leafSize && depth < LEVELS)
+        {
+            // Split by the 3 bits of this level, the keys are sorted.
+            const uint8_t shift = 3*(LEVELS-1-depth);
+            std::vector<std::pair<uint64_t, uint64_t>> octants;
+            uint64_t begin = start;
+            while (begin < start+count)
+            {
+                const uint64_t octant = keys[begin] >> shift;
+                uint64_t end = std::upper_bound
+                (
+                    keys.begin()+begin,
+                    keys.begin()+start+count,
+                    octant,
+                    [shift](uint64_t o, uint64_t key) { return o < (key >> shift); }
+                )-keys.begin();
+                octants.push_back({begin, end-begin});
+                begin = end;
+            }
+            if (octants.size() == 1)
+            {
+                // All Atoms share this octant, descend without a node.
+                buildNode(keys, n, start, count, depth+1, position, element, alpha, radii);
+                return;
+            }
+            const uint64_t first = nodes.size();
+            nodes[n].firstChild = first;
+            nodes[n].children = uint8_t(octants.size());
+            nodes.resize(first+octants.size());
+            for (uint8_t c = 0; c < octants.size(); c++)
+            {
+                buildNode(keys, first+c, octants[c].first, octants[c].second, depth+1, position, element, alpha, radii);
+            }
+        }
+        aggregate(nodes[n], position, element, alpha, radii);
+    }
+
+    template <class Position, class Id, class Alpha>
+    void aggregate
+    (
+        OctreeNode & node,
+        Position & position,
+        Id & element,
+        Alpha & alpha,
+        const std::array<float, ELEMENT_COUNT> & radii
+    )
+    {
+        std::array<uint64_t, ELEMENT_COUNT> counts;
+        counts.fill(0);
+        glm::dvec3 sum(0.0);
+        uint64_t alphas = 0;
+        node.maxRadius = 0.0f;
+        node.volume = 0.0f;
+        node.spread = 0.0f;
+        if (node.leaf())
+        {
+            for (uint64_t k = node.start; k < node.start+node.count; k++)
+            {
+                const uint64_t i = order[k];
+                const uint8_t e = element(i);
+                const float r = radii[e];
+                sum += glm::dvec3(position(i));
+                alphas += alpha(i);
+                counts[e]++;
+                node.maxRadius = std::max(node.maxRadius, r);
+                node.volume += r*r*r;
+            }
+            node.centre = glm::vec3(sum/double(node.count));
+            for (uint64_t k = node.start; k < node.start+node.count; k++)
+            {
+                node.spread = std::max(node.spread, glm::length(position(order[k])-node.centre));
+            }
+        }
+        else
+        {
+            for (uint8_t c = 0; c < node.children; c++)
+            {
+                const OctreeNode & child = nodes[node.firstChild+c];
+                sum += glm::dvec3(child.centre)*double(child.count);
+                alphas += uint64_t(child.alpha)*child.count;
+                counts[child.element] += child.count;
+                node.maxRadius = std::max(node.maxRadius, child.maxRadius);
+                node.volume += child.volume;
+            }
+            node.centre = glm::vec3(sum/double(node.count));
+            for (uint8_t c = 0; c < node.children; c++)
+            {
+                const OctreeNode & child = nodes[node.firstChild+c];
+                node.spread = std::max(node.spread, glm::length(child.centre-node.centre)+child.spread);
+            }
+        }
+        node.element = uint8_t(std::max_element(counts.begin(), counts.end())-counts.begin());
+        node.alpha = uint8_t((alphas+node.count/2)/node.count);
+    }
+};
+
+#endif /* OCTREE_H */
@@ -0,0 +1,97 @@
+#ifndef OVERDRAWCOUNTER_H
+#define OVERDRAWCOUNTER_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <jGL/OpenGL/gl.h>
+
+/**
+ * @brief Count the samples passing the depth test between begin and end.
+ *
+ * @remark Each passing sample is shaded and written, so the count over the
+ * pixels drawn is the overdraw. With MSAA each sample counts.
+ * @remark Queries are used in turn, one per frame in flight, and a result
+ * is only read once available, so counting never waits on the GPU. A
+ * query is not reused until its result is read, frames are not counted
+ * while the next query is still pending.
+ */
+class OverdrawCounter
+{
+public:
+
+    /**
+     * @brief Construct a new OverdrawCounter.
+     *
+     * @param frames the number of frames in flight.
+     */
+    OverdrawCounter(uint8_t frames = 3)
+    : queries(std::max(frames, uint8_t(1)), 0),
+      pending(queries.size(), false)
+    {
+        glGenQueries(queries.size(), queries.data());
+    }
+
+    ~OverdrawCounter()
+    {
+        glDeleteQueries(queries.size(), queries.data());
+    }
+
+    OverdrawCounter(const OverdrawCounter &) = delete;
+    OverdrawCounter & operator=(const OverdrawCounter &) = delete;
+
+    /**
+     * @brief Start counting samples, if the next query is free.
+     *
+     */
+    void begin()
+    {
+        collect();
+        counting = !pending[current];
+        if (counting) { glBeginQuery(GL_SAMPLES_PASSED, queries[current]); }
+    }
+
+    /**
+     * @brief Stop counting samples, and read the oldest finished count.
+     *
+     */
+    void end()
+    {
+        if (!counting) { return; }
+        glEndQuery(GL_SAMPLES_PASSED);
+        counting = false;
+        pending[current] = true;
+        current = (current+1) % queries.size();
+        collect();
+    }
+
+    /**
+     * @brief The latest available count.
+     *
+     * @return uint64_t the samples, a few frames old.
+     */
+    uint64_t samples() const { return counted; }
+
+private:
+
+    std::vector<GLuint> queries;
+    std::vector<bool> pending;
+    uint8_t current = 0;
+    uint64_t counted = 0;
+    bool counting = false;
+
+    void collect()
+    {
+        if (!pending[current]) { return; }
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) { return; }
+        GLuint64 count = 0;
+        glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &count);
+        counted = count;
+        pending[current] = false;
+    }
+};
+
+#endif /* OVERDRAWCOUNTER_H */
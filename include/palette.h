@@ -0,0 +1,53 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include <element.h>
+#include <colour.h>
+
+/**
+ * @brief Colours and radii indexed by Element.
+ *
+ * @remark Per-atom colours and scales are looked up here by Element,
+ * rather than stored for each atom.
+ */
+class Palette
+{
+public:
+
+    /**
+     * @brief Construct a new Palette.
+     *
+     * @param colours Element colours.
+     * @param radii Element radii.
+     */
+    Palette
+    (
+        const ElementTable<glm::vec4> & colours = CPK_COLOURS,
+        const ElementTable<float> & radii = ELEMENT_RADIUS
+    )
+    : colours(colours), radii(radii)
+    {}
+
+    glm::vec4 colour(Element e) const { return colours[e]; }
+
+    float radius(Element e) const { return radii[e]; }
+
+    void setColour(Element e, glm::vec4 c) { colours[e] = c; }
+
+    void setRadius(Element e, float r) { radii[e] = r; }
+
+    const std::array<glm::vec4, ELEMENT_COUNT> & getColours() const { return colours.values; }
+
+    const std::array<float, ELEMENT_COUNT> & getRadii() const { return radii.values; }
+
+private:
+
+    ElementTable<glm::vec4> colours;
+    ElementTable<float> radii;
+};
+
+#endif /* PALETTE_H */
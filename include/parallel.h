@@ -0,0 +1,86 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+/**
+ * @brief The number of threads to split n items over.
+ *
+ * @param n the number of items.
+ * @param minChunk the fewest items worth a thread.
+ * @return unsigned the number of threads, at least 1.
+ */
+unsigned parallelThreads(uint64_t n, uint64_t minChunk = 4096)
+{
+    uint64_t chunks = std::max(n/std::max(minChunk, uint64_t(1)), uint64_t(1));
+    return unsigned(std::min(uint64_t(std::max(std::thread::hardware_concurrency(), 1u)), chunks));
+}
+
+/**
+ * @brief Call f(begin, end, thread) over contiguous chunks of [0, n) in parallel.
+ *
+ * @remark The calling thread runs the first chunk.
+ * @param n the number of items.
+ * @param threads the number of chunks, @see parallelThreads.
+ * @param f the work for a chunk.
+ */
+template <class F>
+void parallelFor(uint64_t n, unsigned threads, F f)
+{
+    if (threads <= 1 || n == 0) { f(uint64_t(0), n, 0u); return; }
+    uint64_t chunk = (n+threads-1)/threads;
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        uint64_t begin = std::min(t*chunk, n);
+        uint64_t end = std::min(begin+chunk, n);
+        workers.push_back(std::thread(f, begin, end, t));
+    }
+    f(uint64_t(0), std::min(chunk, n), 0u);
+    for (std::thread & worker : workers) { worker.join(); }
+}
+
+/**
+ * @brief The indices in [0, n) kept by a predicate, in order.
+ *
+ * @remark A parallel stream compaction. Each chunk counts what it keeps,
+ * an exclusive scan of the counts gives each chunk's place in the output
+ * and the chunks then write their indices there.
+ * @param n the number of items.
+ * @param keep keep(i) is true if item i is kept.
+ * @param indices the kept indices.
+ */
+template <class F>
+void parallelCompact(uint64_t n, F keep, std::vector<uint64_t> & indices)
+{
+    const unsigned threads = parallelThreads(n);
+    std::vector<uint64_t> offsets(threads+1, 0);
+    parallelFor
+    (
+        n,
+        threads,
+        [&](uint64_t begin, uint64_t end, unsigned t)
+        {
+            uint64_t count = 0;
+            for (uint64_t i = begin; i < end; i++) { if (keep(i)) { count++; } }
+            offsets[t+1] = count;
+        }
+    );
+    for (unsigned t = 0; t < threads; t++) { offsets[t+1] += offsets[t]; }
+    indices.resize(offsets[threads]);
+    parallelFor
+    (
+        n,
+        threads,
+        [&](uint64_t begin, uint64_t end, unsigned t)
+        {
+            uint64_t k = offsets[t];
+            for (uint64_t i = begin; i < end; i++) { if (keep(i)) { indices[k++] = i; } }
+        }
+    );
+}
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,105 @@
+#ifndef QUANTISE_H
+#define QUANTISE_H
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include <atom.h>
+
+/**
+ * @brief Map positions in a bounding box to 16 bit unsigned integers.
+ *
+ * @remark Uploaded as normalised unsigned shorts OpenGL reads q/65535,
+ * so origin+extent*q/65535 recovers the position in a shader.
+ * @remark The error per axis is at most half a step, extent/131070.
+ */
+struct Quantisation
+{
+    /**
+     * @brief The identity, used when positions are not quantised.
+     *
+     */
+    Quantisation()
+    : origin(0.0f), extent(1.0f)
+    {}
+
+    /**
+     * @brief Construct a Quantisation of a box.
+     *
+     * @param min the lower corner of the box.
+     * @param max the upper corner of the box.
+     */
+    Quantisation(glm::vec3 min, glm::vec3 max)
+    : origin(min), extent(glm::max(max-min, glm::vec3(std::numeric_limits<float>::min())))
+    {}
+
+    /**
+     * @brief Construct a Quantisation of the bounding box of some Atoms.
+     *
+     * @param atoms the Atoms to bound.
+     */
+    Quantisation(const AtomStore & atoms)
+    : Quantisation()
+    {
+        if (atoms.empty()) { return; }
+        glm::vec3 min, max;
+        bounds(atoms, min, max);
+        *this = Quantisation(min, max);
+    }
+
+    /**
+     * @brief Quantise a position.
+     *
+     * @param r the position, clamped to the box.
+     * @return glm::u16vec3 the quantised position.
+     */
+    glm::u16vec3 quantise(glm::vec3 r) const
+    {
+        glm::vec3 u = glm::clamp((r-origin)/extent, 0.0f, 1.0f)*float(LEVELS);
+        return glm::u16vec3(std::round(u.x), std::round(u.y), std::round(u.z));
+    }
+
+    /**
+     * @brief Recover a position, as the shaders do.
+     *
+     * @param q the quantised position.
+     * @return glm::vec3 the position.
+     */
+    glm::vec3 dequantise(glm::u16vec3 q) const
+    {
+        return origin+extent*(glm::vec3(q)/float(LEVELS));
+    }
+
+    /**
+     * @brief The largest error in a dequantised position.
+     *
+     * @return float the error length.
+     */
+    float maxError() const
+    {
+        return 0.5f*glm::length(extent)/float(LEVELS);
+    }
+
+    glm::vec3 origin;
+    glm::vec3 extent;
+
+    static const uint16_t LEVELS = std::numeric_limits<uint16_t>::max();
+};
+
+/**
+ * @brief Quantise a colour to 8 bits per channel.
+ *
+ * @param colour the colour, clamped to [0, 1].
+ * @return glm::u8vec4 the RGBA8 colour.
+ */
+glm::u8vec4 quantiseColour(glm::vec4 colour)
+{
+    glm::vec4 c = glm::clamp(colour, 0.0f, 1.0f)*255.0f;
+    return glm::u8vec4(std::round(c.r), std::round(c.g), std::round(c.b), std::round(c.a));
+}
+
+#endif /* QUANTISE_H */
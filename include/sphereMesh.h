@@ -0,0 +1,116 @@
+#ifndef SPHEREMESH_H
+#define SPHEREMESH_H
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <algorithm>
+
+#include <hierarchicalTriangularMesh.h>
+
+/**
+ * @brief An indexed sphere mesh.
+ *
+ * @remark @see HierarchicalTriangularMesh::indexed.
+ */
+struct SphereMesh
+{
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief A level of detail, a refinement of a base mesh.
+ *
+ */
+struct SphereMeshLevel
+{
+    BASE_MESH base;
+    uint8_t depth;
+    uint32_t triangles;
+};
+
+/**
+ * @brief The levels of detail of a base mesh, by increasing triangles.
+ *
+ * @remark BASE_MESH::ANY interleaves refinements of all base meshes with
+ * regular triangular faces, giving a finer range of levels of detail.
+ * @remark Nothing is built, triangle counts follow from the base meshes.
+ * @param mesh the base mesh type.
+ * @return std::vector<SphereMeshLevel> the levels of detail.
+ */
+std::vector<SphereMeshLevel> sphereMeshLevels(BASE_MESH mesh)
+{
+    std::vector<SphereMeshLevel> levels;
+    auto refine = [&levels](BASE_MESH m, uint8_t depths)
+    {
+        HierarchicalTriangularMesh<float> htm(m);
+        htm.build(0);
+        for (uint8_t d = 0; d < depths; d++)
+        {
+            levels.push_back({m, d, uint32_t(htm.triangles()*std::pow(4, d))});
+        }
+    };
+
+    if (mesh == BASE_MESH::ANY)
+    {
+        // Non-regular triangular faces not yet supported.
+        for (BASE_MESH m : {BASE_MESH::CUBE, BASE_MESH::DODECAHEDRON}) { refine(m, 1); }
+        for (BASE_MESH m : {BASE_MESH::TETRAHEDRON, BASE_MESH::OCTAHEDRON, BASE_MESH::ICOSAHEDRON}) { refine(m, 7); }
+        std::stable_sort
+        (
+            levels.begin(),
+            levels.end(),
+            [](const SphereMeshLevel & a, const SphereMeshLevel & b) { return a.triangles < b.triangles; }
+        );
+    }
+    else
+    {
+        refine(mesh, 7);
+    }
+    return levels;
+}
+
+/**
+ * @brief Build a SphereMesh.
+ *
+ * @param level the level of detail to build.
+ * @return std::shared_ptr<const SphereMesh> the mesh.
+ */
+std::shared_ptr<const SphereMesh> buildSphereMesh(SphereMeshLevel level)
+{
+    HierarchicalTriangularMesh<float> htm(level.base);
+    htm.build(level.depth);
+    std::shared_ptr<SphereMesh> sphere = std::make_shared<SphereMesh>();
+    htm.indexed(sphere->vertices, sphere->normals, sphere->indices);
+    return sphere;
+}
+
+/**
+ * @brief Request a SphereMesh, built once per process on a background thread.
+ *
+ * @remark Requests of the same level, e.g. from the loading screen and
+ * main AtomRenderers, share one build.
+ * @param level the level of detail to build.
+ * @return std::shared_future<std::shared_ptr<const SphereMesh>> the pending mesh.
+ */
+std::shared_future<std::shared_ptr<const SphereMesh>> requestSphereMesh(SphereMeshLevel level)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<BASE_MESH, uint8_t>, std::shared_future<std::shared_ptr<const SphereMesh>>> built;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::pair(level.base, level.depth);
+    auto found = built.find(key);
+    if (found != built.end()) { return found->second; }
+    auto pending = std::async(std::launch::async, buildSphereMesh, level).share();
+    built.insert({key, pending});
+    return pending;
+}
+
+#endif /* SPHEREMESH_H */
@@ -0,0 +1,301 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+
+#include <jGL/OpenGL/gl.h>
+
+#include <glUtils.h>
+#include <dirtyRange.h>
+
+/**
+ * @brief A GL_ARRAY_BUFFER rewritten every frame.
+ *
+ * @remark With buffer storage (OpenGL 4.4) the buffer is persistently
+ * mapped and split into segments used in turn, the CPU writes the next
+ * segment while the GPU draws from the last. A fence per segment guards
+ * against overwriting a segment still being drawn.
+ * @remark Otherwise the buffer is orphaned with glBufferData and mapped,
+ * so the driver may allocate new storage instead of synchronising.
+ * @remark Partial updates track the bytes each segment is missing, so a
+ * segment is only written where it differs from the source.
+ * @remark Attributes must be re-pointed at offset() after each update, map
+ * or claim.
+ */
+class StreamBuffer
+{
+public:
+
+    /**
+     * @brief Construct a new StreamBuffer.
+     *
+     * @param capacity the bytes written per frame.
+     * @param segments the number of frames in flight, when persistent.
+     */
+    StreamBuffer(uint64_t capacity, uint8_t segments = 3)
+    : persistent(bufferStorageAvailable()),
+      segments(persistent ? std::max(segments, uint8_t(1)) : 1)
+    {
+        allocate(capacity);
+    }
+
+    ~StreamBuffer() { release(); }
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer & operator=(const StreamBuffer &) = delete;
+
+    /**
+     * @brief Grow the capacity per frame.
+     *
+     * @remark Immutable storage cannot be resized, the buffer id may change.
+     * @param capacity the bytes written per frame.
+     */
+    void reserve(uint64_t capacity)
+    {
+        if (capacity <= bytes) { return; }
+        release();
+        allocate(capacity);
+    }
+
+    /**
+     * @brief Upload changed bytes of a source to the next segment.
+     *
+     * @remark The next segment is also sent changes it missed while other
+     * segments were written. Without persistent mapping, small changes use
+     * glBufferSubData and large ones orphan the buffer.
+     * @param data the source, laid out as a segment.
+     * @param size the bytes of the source, at most capacity().
+     * @param changed the changed ranges of the source.
+     * @return true if the segment changed.
+     * @return false if nothing needed uploading.
+     */
+    bool update(const uint8_t * data, uint64_t size, const std::vector<ByteRange> & changed)
+    {
+        size = std::min(size, bytes);
+        for (std::vector<ByteRange> & missing : pending)
+        {
+            for (const ByteRange & range : changed)
+            {
+                mergeRange(missing, {range.first, std::min(range.second, size)});
+            }
+        }
+        if (persistent)
+        {
+            if (pending[segment].empty()) { return false; }
+            advance();
+            for (const ByteRange & range : clamp(pending[segment], size))
+            {
+                std::memcpy(mapped+offset()+range.first, data+range.first, range.second-range.first);
+            }
+            pending[segment].clear();
+            return true;
+        }
+
+        std::vector<ByteRange> ranges = clamp(pending[0], size);
+        pending[0].clear();
+        if (ranges.empty()) { return false; }
+        uint64_t changedBytes = 0;
+        for (const ByteRange & range : ranges) { changedBytes += range.second-range.first; }
+        if (2*changedBytes >= size)
+        {
+            std::memcpy(map(size), data, size);
+            unmap();
+            pending[0].clear();
+            return true;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            for (const ByteRange & range : ranges)
+            {
+                glBufferSubData(GL_ARRAY_BUFFER, range.first, range.second-range.first, data+range.first);
+            }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    /**
+     * @brief Map the next segment for writing.
+     *
+     * @remark Blocks if the GPU has not finished with the segment.
+     * @remark The data written replaces the source of update, which will
+     * next write every segment fully.
+     * @param size the bytes to be written, at most capacity().
+     * @return uint8_t* the writable segment.
+     */
+    uint8_t * map(uint64_t size)
+    {
+        stale();
+        if (persistent)
+        {
+            advance();
+            return mapped+offset();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            uint8_t * data = static_cast<uint8_t*>
+            (
+                glMapBufferRange
+                (
+                    GL_ARRAY_BUFFER,
+                    0,
+                    std::max(std::min(size, bytes), uint64_t(1)),
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT
+                )
+            );
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return data;
+    }
+
+    /**
+     * @brief Finish writing the mapped segment.
+     *
+     */
+    void unmap()
+    {
+        if (persistent) { return; }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /**
+     * @brief Take the next segment for writing on the GPU.
+     *
+     * @remark As for map, update will next write every segment fully.
+     * @return uint64_t the byte offset of the segment.
+     */
+    uint64_t claim()
+    {
+        stale();
+        if (persistent) { advance(); }
+        return offset();
+    }
+
+    /**
+     * @brief The buffer id.
+     *
+     * @return GLuint the GL_ARRAY_BUFFER id.
+     */
+    GLuint id() const { return buffer; }
+
+    /**
+     * @brief The byte offset of the current segment.
+     *
+     * @return uint64_t the offset.
+     */
+    uint64_t offset() const { return uint64_t(segment)*bytes; }
+
+    /**
+     * @brief The bytes per frame.
+     *
+     * @return uint64_t the capacity.
+     */
+    uint64_t capacity() const { return bytes; }
+
+    /**
+     * @brief Whether the buffer is persistently mapped.
+     *
+     * @return true if persistently mapped with fences.
+     * @return false if orphaned.
+     */
+    bool isPersistent() const { return persistent; }
+
+private:
+
+    bool persistent;
+    uint8_t segments;
+    uint8_t segment = 0;
+    uint64_t bytes = 0;
+    GLuint buffer = 0;
+    uint8_t * mapped = nullptr;
+    std::vector<GLsync> fences;
+    std::vector<std::vector<ByteRange>> pending;
+
+    // Suits vertex attribute and storage buffer offset alignments.
+    static const uint64_t ALIGNMENT = 256;
+
+    void allocate(uint64_t capacity)
+    {
+        bytes = std::max(((capacity+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT, ALIGNMENT);
+        segment = 0;
+        fences = std::vector<GLsync>(segments, nullptr);
+        pending = std::vector<std::vector<ByteRange>>(segments, {{0, bytes}});
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            if (persistent)
+            {
+                const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                glBufferStorage(GL_ARRAY_BUFFER, bytes*segments, nullptr, flags);
+                mapped = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes*segments, flags));
+            }
+            else
+            {
+                glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+            }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void release()
+    {
+        for (GLsync & fence : fences) { wait(fence); }
+        if (mapped != nullptr)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    /**
+     * @brief Fence the current segment, then wait for the next.
+     *
+     * @remark Every draw from the current segment has been issued by now.
+     */
+    void advance()
+    {
+        if (fences[segment] != nullptr) { glDeleteSync(fences[segment]); }
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        segment = (segment+1)%segments;
+        wait(fences[segment]);
+    }
+
+    /**
+     * @brief Mark every segment as differing from the update source.
+     *
+     */
+    void stale()
+    {
+        for (std::vector<ByteRange> & missing : pending) { missing = {{0, bytes}}; }
+    }
+
+    static std::vector<ByteRange> clamp(const std::vector<ByteRange> & ranges, uint64_t size)
+    {
+        std::vector<ByteRange> clamped;
+        for (const ByteRange & range : ranges)
+        {
+            if (range.first < std::min(range.second, size))
+            {
+                clamped.push_back({range.first, std::min(range.second, size)});
+            }
+        }
+        return clamped;
+    }
+
+    void wait(GLsync & fence)
+    {
+        if (fence == nullptr) { return; }
+        GLenum status = GL_TIMEOUT_EXPIRED;
+        while (status == GL_TIMEOUT_EXPIRED)
+        {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+};
+
+#endif /* STREAMBUFFER_H */
@@ -12,6 +12,7 @@
 #include <vendored/jThread/jThread.h>
 
 #include <atom.h>
+#include <morton.h>
 
 /**
  * @brief Specification for the structure file interface.
@@ -138,13 +139,13 @@ public:
      * @return true if all Atoms in the frame have been read.
      * @return false if reading is in progress.
      */
-    bool frameReadComplete() const { return atomsRead == atoms.size(); }
+    virtual bool frameReadComplete() const { return atomsRead == atoms.size(); }
 
     /**
      * @brief The Atoms read in the current frame.
      *
      */
-    std::vector<Atom> atoms;
+    AtomStore atoms;
 
     /**
      * @brief Get the a cell vector.
@@ -167,7 +168,33 @@ public:
      */
     glm::vec3 getCellC() const { return cellC; }
 
-    std::map<Element, glm::vec4> colourMap = CPK_COLOURS;
+    /**
+     * @brief Reorder the Atoms along a Morton (Z-order) curve.
+     *
+     * @remark The order is found from the current frame, which must be
+     * fully read. It is then kept for every later frame, so an Atom index
+     * refers to the same atom in the file for all frames.
+     * @see fileIndex to recover the index in the file.
+     */
+    void reorder()
+    {
+        std::vector<uint64_t> order = mortonOrder(atoms);
+        atoms.permute(order);
+        fileToAtom.resize(order.size());
+        for (uint64_t i = 0; i < order.size(); i++) { fileToAtom[order[i]] = i; }
+        atomToFile = std::move(order);
+    }
+
+    /**
+     * @brief The index in the file of an Atom.
+     *
+     * @param atom the index in atoms.
+     * @return uint64_t the index of the atom in each file frame.
+     */
+    uint64_t fileIndex(uint64_t atom) const
+    {
+        return atomToFile.empty() ? atom : atomToFile[atom];
+    }
 
 protected:
 
@@ -190,6 +217,20 @@ protected:
 
     std::map<uint64_t, uint64_t> framePositions;
 
+    std::vector<uint64_t> atomToFile;
+    std::vector<uint64_t> fileToAtom;
+
+    LabelCache labels;
+
+    /**
+     * @brief Index in atoms for the a'th atom of a file frame.
+     *
+     * @remark Identity unless reorder has been called.
+     */
+    uint64_t atomSlot(uint64_t a) const
+    {
+        return fileToAtom.empty() ? a : fileToAtom[a];
+    }
 
 
     virtual void beginning()
@@ -0,0 +1,321 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#include <array>
+#include <memory>
+
+#include <jGL/OpenGL/gl.h>
+#include <jGL/OpenGL/Shader/glShader.h>
+
+#include <glUtils.h>
+
+/**
+ * @brief Which fragments a draw writes, and how.
+ *
+ * @remark BLENDED draws every fragment alpha blended in submission order.
+ * @remark SOLID draws only fragments with alpha 1, without blending.
+ * @remark WEIGHTED draws only fragments with alpha below 1, accumulating
+ * into a WeightedBlendedOIT.
+ * @remark TRANSLUCENT draws only fragments with alpha below 1, alpha
+ * blended in submission order, e.g. after a SOLID pass.
+ */
+enum class TransparencyPass : int
+{
+    BLENDED = 0,
+    SOLID = 1,
+    WEIGHTED = 2,
+    TRANSLUCENT = 3
+};
+
+/**
+ * @brief GLSL declaring bool opaque(float alpha).
+ *
+ * @remark Alphas within half an 8 bit step of 1 are opaque, 8 bit alphas
+ * divided by 255 in a shader need not give exactly 1.
+ */
+#define OPAQUE_ALPHA_GLSL \
+    "bool opaque(float alpha) { return alpha >= 1.0-0.5/255.0; }\n"
+
+/**
+ * @brief GLSL for vertex shaders, bool passCulls(float alpha).
+ *
+ * @remark True when no fragment of a primitive of this alpha is drawn in
+ * the current pass, so it can be clipped away before rasterisation.
+ */
+#define TRANSPARENCY_VERTEX_GLSL \
+    "uniform int transparencyPass;\n" \
+    OPAQUE_ALPHA_GLSL \
+    "bool passCulls(float alpha)\n" \
+    "{\n" \
+    "    return (transparencyPass == 1 && !opaque(alpha)) || (transparencyPass >= 2 && opaque(alpha));\n" \
+    "}\n"
+
+/**
+ * @brief GLSL for fragment shaders, declaring the outputs and
+ * void writeColour(vec4 c).
+ *
+ * @remark In the WEIGHTED pass the premultiplied colour, weighted by
+ * alpha and depth, and alpha are written to the first output, the weight
+ * times alpha to the second, @see WeightedBlendedOIT.
+ */
+#define TRANSPARENCY_FRAGMENT_GLSL \
+    "layout(location=0) out vec4 colour;\n" \
+    "layout(location=1) out vec4 weight;\n" \
+    "uniform int transparencyPass;\n" \
+    OPAQUE_ALPHA_GLSL \
+    "void writeColour(vec4 c)\n" \
+    "{\n" \
+    "    if (transparencyPass == 1 && !opaque(c.a)) { discard; }\n" \
+    "    if (transparencyPass >= 2 && opaque(c.a)) { discard; }\n" \
+    "    if (transparencyPass == 2)\n" \
+    "    {\n" \
+    "        float w = clamp(pow(min(1.0, c.a*10.0)+0.01, 3.0)*1e8*pow(1.0-gl_FragCoord.z*0.9, 3.0), 1e-2, 3e3);\n" \
+    "        colour = vec4(c.rgb*c.a*w, c.a);\n" \
+    "        weight = vec4(c.a*w, 0.0, 0.0, 0.0);\n" \
+    "    }\n" \
+    "    else\n" \
+    "    {\n" \
+    "        colour = c;\n" \
+    "        weight = vec4(0.0);\n" \
+    "    }\n" \
+    "}\n"
+
+/**
+ * @brief Set the blend and depth state of a TransparencyPass.
+ *
+ * @param pass the pass.
+ */
+void transparencyState(TransparencyPass pass)
+{
+    glEnable(GL_DEPTH_TEST);
+    switch (pass)
+    {
+        case TransparencyPass::SOLID:
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+            break;
+        case TransparencyPass::WEIGHTED:
+            // Colours and weights add, the alpha of the first target
+            // becomes the product of (1-alpha), the revealage.
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+            glDepthMask(GL_FALSE);
+            break;
+        default:
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glDepthMask(GL_TRUE);
+            break;
+    }
+}
+
+/**
+ * @brief Weighted blended order independent transparency.
+ *
+ * @remark Translucent fragments are accumulated, in any order, into a
+ * colour and revealage target and a weight target, then composited over
+ * the framebuffer in one full screen pass. No sorting is needed.
+ * @remark Opaque geometry is drawn first with TransparencyPass::SOLID, its
+ * depth is copied so translucent fragments behind it are rejected.
+ * @remark Uses only a single blend function (OpenGL 3.3), the weight sum
+ * takes the red channel of a second target. Both targets are 32 bit
+ * floats, so sums over thousands of layers at the largest weight stay
+ * finite.
+ * @remark McGuire and Bavoil, Weighted Blended Order-Independent
+ * Transparency, JCGT 2(2), 2013.
+ */
+class WeightedBlendedOIT
+{
+public:
+
+    WeightedBlendedOIT()
+    {
+        shader = std::make_unique<jGL::GL::glShader>(vertexShader, fragmentShader);
+        shader->use();
+        shader->setUniform<jGL::Sampler2D>("accumulation", jGL::Sampler2D(0));
+        shader->setUniform<jGL::Sampler2D>("weights", jGL::Sampler2D(1));
+
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(2, targets.data());
+        glGenRenderbuffers(1, &depth);
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &a_quad);
+
+        glBindVertexArray(vao);
+            createBuffer(a_quad, quad.data(), quad.size(), GL_STATIC_DRAW, 0, 2, 0);
+        glBindVertexArray(0);
+    }
+
+    ~WeightedBlendedOIT()
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(2, targets.data());
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &a_quad);
+    }
+
+    WeightedBlendedOIT(const WeightedBlendedOIT &) = delete;
+    WeightedBlendedOIT & operator=(const WeightedBlendedOIT &) = delete;
+
+    /**
+     * @brief Start accumulating translucent fragments.
+     *
+     * @remark Call after drawing opaque geometry into the bound framebuffer,
+     * then draw with TransparencyPass::WEIGHTED.
+     */
+    void begin()
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        resize(viewport[2], viewport[3]);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, target);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        const GLenum buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, buffers);
+        const float clearAccumulation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        const float clearWeights[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+        glClearBufferfv(GL_COLOR, 1, clearWeights);
+    }
+
+    /**
+     * @brief Composite the accumulated fragments over the framebuffer bound
+     * at begin.
+     *
+     */
+    void end()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        shader->use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, targets[0]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, targets[1]);
+        glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+
+        glEnable(GL_DEPTH_TEST);
+    }
+
+private:
+
+    std::unique_ptr<jGL::GL::glShader> shader;
+    GLuint fbo, depth, vao, a_quad;
+    std::array<GLuint, 2> targets;
+    GLint target = 0;
+    GLint width = 0;
+    GLint height = 0;
+    GLenum depthFormat = GL_NONE;
+
+    const std::array<float, 8> quad =
+    {
+        -1.0,-1.0,
+        -1.0,1.0,
+        1.0,-1.0,
+        1.0,1.0
+    };
+
+    /**
+     * @brief The depth format of the framebuffer being drawn to.
+     *
+     * @remark Depth blits need matching formats.
+     */
+    GLenum targetDepthFormat()
+    {
+        const GLenum attachment = target == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+        const GLenum stencil = target == 0 ? GL_STENCIL : GL_DEPTH_ATTACHMENT;
+        GLint depthBits = 24, stencilBits = 0, type = GL_UNSIGNED_NORMALIZED;
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, stencil, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+        glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &type);
+        if (type == GL_FLOAT) { return stencilBits > 0 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F; }
+        if (stencilBits > 0) { return GL_DEPTH24_STENCIL8; }
+        if (depthBits > 24) { return GL_DEPTH_COMPONENT32; }
+        return depthBits > 16 ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16;
+    }
+
+    void resize(GLint w, GLint h)
+    {
+        GLenum format = targetDepthFormat();
+        if (w == width && h == height && format == depthFormat) { return; }
+        width = w;
+        height = h;
+        depthFormat = format;
+
+        // Near fragments weigh up to 3e3, so half floats would overflow
+        // after tens of translucent layers.
+        const GLint internal[2] = {GL_RGBA32F, GL_R32F};
+        const GLenum formats[2] = {GL_RGBA, GL_RED};
+        for (uint8_t t = 0; t < 2; t++)
+        {
+            glBindTexture(GL_TEXTURE_2D, targets[t]);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal[t], width, height, 0, formats[t], GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        const bool stencil = depthFormat == GL_DEPTH24_STENCIL8 || depthFormat == GL_DEPTH32F_STENCIL8;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets[0], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, targets[1], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            throw std::runtime_error("Incomplete order independent transparency framebuffer");
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+    }
+
+    const char * vertexShader =
+        "#version " GLSL_VERSION "\n"
+        "precision lowp float; precision lowp int;\n"
+        "layout(location=0) in vec2 a_vertices;\n"
+        "out vec2 texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    texCoord = 0.5*(a_vertices+1.0);\n"
+        "    gl_Position = vec4(a_vertices, 0.0, 1.0);\n"
+        "}";
+
+    const char * fragmentShader =
+        "#version " GLSL_VERSION "\n"
+        "precision lowp float; precision lowp int;\n"
+        "in vec2 texCoord;\n"
+        "uniform sampler2D accumulation;\n"
+        "uniform sampler2D weights;\n"
+        "out vec4 colour;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 accumulated = texture(accumulation, texCoord);\n"
+        "    float revealage = accumulated.a;\n"
+        "    if (revealage >= 1.0) { discard; }\n"
+        "    float weight = texture(weights, texCoord).r;\n"
+        "    colour = vec4(accumulated.rgb/max(weight, 1e-5), 1.0-revealage);\n"
+        "}";
+};
+
+#endif /* TRANSPARENCY_H */
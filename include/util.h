@@ -124,67 +124,68 @@ std::vector<std::string> split(std::string str, std::regex delim)
 /**
  * @brief A set of atoms spelling SFOAV to display during loading.
  *
+ * @remark Drawn at half the atom scale.
  */
-const std::vector<Atom> sfoavAtoms =
+const AtomStore sfoavAtoms =
 {
-    {Element::S, {-11.3966, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-10.3966, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-9.39655, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-10.3966, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-9.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-8.39655, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-8.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-11.3966, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-11.3966, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-10.3966, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-9.39655, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::S, {-8.39655, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::S), CPK_COLOURS.at(Element::S)},
-    {Element::F, {-6.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-5.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-4.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-6.39655, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-5.39655, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-6.39655, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-6.39655, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-6.39655, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-4.39655, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::F, {-3.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::F), CPK_COLOURS.at(Element::F)},
-    {Element::O, {-1.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-1.39655, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-1.39655, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-1.39655, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-1.39655, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-0.39655, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {0.603449, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {1.603449, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {1.603449, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {1.603449, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {1.603449, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {1.603449, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {0.603449, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::O, {-0.39655, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::O), CPK_COLOURS.at(Element::O)},
-    {Element::Ar, {-1.39655+1.603449*3.0, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {-1.39655+1.603449*3.0, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {-1.39655+1.603449*3.0, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {-1.39655+1.603449*3.0, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {-0.396552+1.603449*3.0, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {0.603448+1.603449*3.0, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {1.60345+1.603449*3.0, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {1.60345+1.603449*3.0, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {1.60345+1.603449*3.0, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {1.60345+1.603449*3.0, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {0.603448+1.603449*3.0, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::Ar, {-0.396552+1.603449*3.0, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::Ar), CPK_COLOURS.at(Element::Ar)},
-    {Element::V, {8.60345, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {11.6034, 1.89655, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {8.60345, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {8.60345, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {11.6034, 0.896552, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {11.6034, -0.103448, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {10.6034, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {9.60345, -2.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {8.60345, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)},
-    {Element::V, {11.6034, -1.10345, 0.0}, 0.5f*ELEMENT_RADIUS.at(Element::V), CPK_COLOURS.at(Element::V)}
+    {Element::S, {-11.3966, -2.10345, 0.0}},
+    {Element::S, {-10.3966, -2.10345, 0.0}},
+    {Element::S, {-9.39655, -2.10345, 0.0}},
+    {Element::S, {-10.3966, 1.89655, 0.0}},
+    {Element::S, {-9.39655, 1.89655, 0.0}},
+    {Element::S, {-8.39655, -2.10345, 0.0}},
+    {Element::S, {-8.39655, 1.89655, 0.0}},
+    {Element::S, {-11.3966, 1.89655, 0.0}},
+    {Element::S, {-11.3966, 0.896552, 0.0}},
+    {Element::S, {-10.3966, -0.103448, 0.0}},
+    {Element::S, {-9.39655, -0.103448, 0.0}},
+    {Element::S, {-8.39655, -1.10345, 0.0}},
+    {Element::F, {-6.39655, 1.89655, 0.0}},
+    {Element::F, {-5.39655, 1.89655, 0.0}},
+    {Element::F, {-4.39655, 1.89655, 0.0}},
+    {Element::F, {-6.39655, -0.103448, 0.0}},
+    {Element::F, {-5.39655, -0.103448, 0.0}},
+    {Element::F, {-6.39655, 0.896552, 0.0}},
+    {Element::F, {-6.39655, -1.10345, 0.0}},
+    {Element::F, {-6.39655, -2.10345, 0.0}},
+    {Element::F, {-4.39655, -0.103448, 0.0}},
+    {Element::F, {-3.39655, 1.89655, 0.0}},
+    {Element::O, {-1.39655, 1.89655, 0.0}},
+    {Element::O, {-1.39655, 0.896552, 0.0}},
+    {Element::O, {-1.39655, -0.103448, 0.0}},
+    {Element::O, {-1.39655, -1.10345, 0.0}},
+    {Element::O, {-1.39655, -2.10345, 0.0}},
+    {Element::O, {-0.39655, -2.10345, 0.0}},
+    {Element::O, {0.603449, -2.10345, 0.0}},
+    {Element::O, {1.603449, -2.10345, 0.0}},
+    {Element::O, {1.603449, -1.10345, 0.0}},
+    {Element::O, {1.603449, -0.103448, 0.0}},
+    {Element::O, {1.603449, 0.896552, 0.0}},
+    {Element::O, {1.603449, 1.89655, 0.0}},
+    {Element::O, {0.603449, 1.89655, 0.0}},
+    {Element::O, {-0.39655, 1.89655, 0.0}},
+    {Element::Ar, {-1.39655+1.603449*3.0, -2.10345, 0.0}},
+    {Element::Ar, {-1.39655+1.603449*3.0, -1.10345, 0.0}},
+    {Element::Ar, {-1.39655+1.603449*3.0, -0.103448, 0.0}},
+    {Element::Ar, {-1.39655+1.603449*3.0, 0.896552, 0.0}},
+    {Element::Ar, {-0.396552+1.603449*3.0, 1.89655, 0.0}},
+    {Element::Ar, {0.603448+1.603449*3.0, 1.89655, 0.0}},
+    {Element::Ar, {1.60345+1.603449*3.0, 0.896552, 0.0}},
+    {Element::Ar, {1.60345+1.603449*3.0, -0.103448, 0.0}},
+    {Element::Ar, {1.60345+1.603449*3.0, -1.10345, 0.0}},
+    {Element::Ar, {1.60345+1.603449*3.0, -2.10345, 0.0}},
+    {Element::Ar, {0.603448+1.603449*3.0, -0.103448, 0.0}},
+    {Element::Ar, {-0.396552+1.603449*3.0, -0.103448, 0.0}},
+    {Element::V, {8.60345, 1.89655, 0.0}},
+    {Element::V, {11.6034, 1.89655, 0.0}},
+    {Element::V, {8.60345, 0.896552, 0.0}},
+    {Element::V, {8.60345, -0.103448, 0.0}},
+    {Element::V, {11.6034, 0.896552, 0.0}},
+    {Element::V, {11.6034, -0.103448, 0.0}},
+    {Element::V, {10.6034, -2.10345, 0.0}},
+    {Element::V, {9.60345, -2.10345, 0.0}},
+    {Element::V, {8.60345, -1.10345, 0.0}},
+    {Element::V, {11.6034, -1.10345, 0.0}}
 };
 
 #endif /* UTIL_H */
@@ -0,0 +1,116 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include <element.h>
+#include <atom.h>
+#include <parallel.h>
+
+/**
+ * @brief Which Atoms are drawn, hiding by Element and by selection.
+ *
+ * @remark Hidden Atoms, and Bonds to them, are compacted out of the
+ * uploads rather than drawn transparent, @see parallelCompact.
+ */
+class Visibility
+{
+public:
+
+    /**
+     * @brief Construct a new Visibility, every Atom shown.
+     *
+     */
+    Visibility() { hiddenElements.fill(false); }
+
+    /**
+     * @brief Hide or show an Element.
+     *
+     * @param e the Element.
+     * @param hidden whether to hide the Element.
+     */
+    void hide(Element e, bool hidden = true) { hiddenElements[uint16_t(e)] = hidden; }
+
+    /**
+     * @brief Hide or show an Atom.
+     *
+     * @param i the index of the Atom.
+     * @param hidden whether to hide the Atom.
+     */
+    void hideAtom(uint64_t i, bool hidden = true)
+    {
+        if (i >= hiddenAtoms.size())
+        {
+            if (!hidden) { return; }
+            hiddenAtoms.resize(i+1, 0);
+        }
+        hiddenAtoms[i] = hidden;
+    }
+
+    /**
+     * @brief Show every Atom hidden by hideAtom.
+     *
+     */
+    void showAtoms() { hiddenAtoms.clear(); }
+
+    /**
+     * @brief Whether an Element is hidden.
+     *
+     * @param e the Element.
+     * @return true if hidden.
+     * @return false if shown.
+     */
+    bool isHidden(Element e) const { return hiddenElements[uint16_t(e)]; }
+
+    /**
+     * @brief Whether an Atom is hidden, by its Element or itself.
+     *
+     * @param i the index of the Atom.
+     * @param e the Element of the Atom.
+     * @return true if hidden.
+     * @return false if shown.
+     */
+    bool isHidden(uint64_t i, Element e) const
+    {
+        return hiddenElements[uint16_t(e)] || (i < hiddenAtoms.size() && hiddenAtoms[i]);
+    }
+
+    /**
+     * @brief Whether any Atom may be hidden.
+     *
+     * @return true if an Element or Atom is hidden.
+     * @return false if every Atom is shown.
+     */
+    bool hidesAny() const
+    {
+        for (bool hidden : hiddenElements) { if (hidden) { return true; } }
+        for (uint8_t hidden : hiddenAtoms) { if (hidden) { return true; } }
+        return false;
+    }
+
+    /**
+     * @brief The indices of the shown Atoms, in order.
+     *
+     * @param atoms the Atoms.
+     * @param indices the shown indices.
+     */
+    void visibleAtoms(const AtomStore & atoms, std::vector<uint64_t> & indices) const
+    {
+        const std::vector<Element> & elements = atoms.getElements();
+        parallelCompact
+        (
+            atoms.size(),
+            [&](uint64_t i) { return !isHidden(i, elements[i]); },
+            indices
+        );
+    }
+
+private:
+
+    std::array<bool, ELEMENT_COUNT> hiddenElements;
+    std::vector<uint8_t> hiddenAtoms;
+};
+
+#endif /* VISIBILITY_H */
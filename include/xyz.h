@@ -123,10 +123,8 @@ private:
                 >> atom.position.y
                 >> atom.position.z;
             checkRead(ss, line, "XYZ reading atom "+std::to_string(a));
-            atom.symbol = stringSymbolToElement(symbol);
-            atom.scale = ELEMENT_RADIUS.at(atom.symbol);
-            atom.colour = colourMap.at(atom.symbol);
-            atoms[a] = atom;
+            atom.symbol = labels.element(symbol);
+            atoms.set(atomSlot(a), atom);
             atomsRead = a+1;
         }
     }
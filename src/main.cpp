@@ -49,13 +49,34 @@ int main(int argv, char ** argc)
         throw std::runtime_error("No atoms path specified, specify one with -atoms <path>");
     }
 
+    bool gpuBonds = options.gpuBonds.value && options.bondCutoff.value > 0.0;
+    if (gpuBonds && !computeShadersAvailable())
+    {
+        std::cout << "Compute shaders are unavailable, bonds will be found on the CPU\n";
+        gpuBonds = false;
+    }
+
     std::unique_ptr<Structure> structure;
-    readStructureFile(options.structure.value, structure);
-    glm::vec3 com = glm::vec3(0);
+    BrickedStructure * bricked = nullptr;
+    if (options.memoryBudget.value > 0.0f)
+    {
+        auto paged = std::make_unique<BrickedStructure>
+        (
+            options.structure.value,
+            uint64_t(double(options.memoryBudget.value)*1024.0*1024.0),
+            gpuBonds ? 0.0f : float(options.bondCutoff.value)
+        );
+        bricked = paged.get();
+        structure = std::move(paged);
+    }
+    else
+    {
+        readStructureFile(options.structure.value, structure);
+    }
 
     if (!options.colourmap.value.empty())
     {
-        structure->colourMap = coloursFromFile(options.colourmap.value);
+        structure->atoms.setPalette(Palette(coloursFromFile(options.colourmap.value)));
     }
 
     structure->readFrame(0);
@@ -70,7 +91,7 @@ int main(int argv, char ** argc)
         loadingCamera.position(),
         options.mesh.value
     );
-    loadingAtoms.setAtomScale(options.atomSize.value);
+    loadingAtoms.setAtomScale(0.5f*options.atomSize.value);
 
     while (display.isOpen() && !structure->frameReadComplete())
     {
@@ -86,10 +107,12 @@ int main(int argv, char ** argc)
 
     if (!display.isOpen()) { return 0; }
 
+    // Bricks are already spatially ordered, and change as they are paged.
+    if (options.reorder.value && bricked == nullptr) { structure->reorder(); }
+
     std::set<Element> elements = uniqueElements(structure->atoms);
-    std::multimap<Element, uint64_t> elementMap = elementIndices(structure->atoms);
     std::map<int, Element> emphasisControls;
-    std::vector<float> alphaOverrides(structure->atoms.size(), 1.0f);
+    Emphasis emphasis(options.deemphasisAlpha.value);
     for (uint8_t i = 0; i < std::min(size_t(6), elements.size()); i++)
     {
         Element e = *std::next(elements.begin(), i);
@@ -97,13 +120,14 @@ int main(int argv, char ** argc)
         std::cout << "Element " << e << " emphasis bound to key " << keyCodes.at(GLFW_KEY_1+i) << "\n";
     }
 
-    center(structure->atoms);
+    // Centring and translation are applied by model matrices, not to the Atoms.
+    glm::vec3 centre = bricked == nullptr ? getCenter(structure->atoms) : bricked->centre();
+    glm::vec3 offset = glm::vec3(0);
 
-    std::vector<Bond> bonds;
-    if (options.bondCutoff.value > 0.0)
-    {
-        bonds = determineBonds(structure->atoms, options.bondCutoff.value);
-    }
+    VerletBondList bondList(options.bondCutoff.value, options.bondSkin.value);
+    if (!gpuBonds && bricked == nullptr) { bondList.update(structure->atoms); }
+    // Bricks find their own bonds as they are paged.
+    const std::vector<Bond> & bonds = bricked == nullptr ? bondList.getBonds() : bricked->getBonds();
 
     Camera camera {structure->atoms, resX, resY};
 
@@ -112,18 +136,60 @@ int main(int argv, char ** argc)
         structure->atoms,
         options.levelOfDetail.value,
         camera.position(),
-        options.mesh.value
+        options.mesh.value,
+        options.compact.value,
+        bricked == nullptr ? 0 : bricked->capacity()
     );
     atomRenderer.setAtomScale(options.atomSize.value);
+    bool meshes = options.meshes.value || options.adaptiveDetail.value;
+    if (options.adaptiveDetail.value)
+    {
+        atomRenderer.updateCamera(camera);
+        atomRenderer.setAdaptiveLevelOfDetail(true);
+    }
+    if (options.depthOrder.value > 0)
+    {
+        atomRenderer.updateCamera(camera);
+        atomRenderer.setDepthOrder(DepthOrder(std::min(options.depthOrder.value, uint8_t(DepthOrder::BACK_TO_FRONT))));
+    }
+    atomRenderer.setDepthPrepass(options.depthPrepass.value);
+    atomRenderer.setFrustumCulling(options.frustumCulling.value);
+    if (options.hierarchicalDetail.value > 0.0f)
+    {
+        atomRenderer.updateCamera(camera);
+        atomRenderer.setHierarchicalLevelOfDetail(options.hierarchicalDetail.value);
+    }
+    atomRenderer.setPointSprites(options.pointSprites.value);
+    OverdrawCounter overdraw;
+    atomRenderer.countOverdraw(&overdraw);
 
     BondRenderer bondRenderer
     (
         bonds,
         structure->atoms,
-        bonds.size()
+        bonds.size(),
+        options.compact.value
     );
 
     bondRenderer.setBondScale(options.bondSize.value);
+    bondRenderer.setFrustumCulling(options.frustumCulling.value);
+
+    std::unique_ptr<WeightedBlendedOIT> oit;
+    if (options.oit.value)
+    {
+        oit = std::make_unique<WeightedBlendedOIT>();
+        atomRenderer.setTransparencyPass(TransparencyPass::SOLID);
+        bondRenderer.setTransparencyPass(TransparencyPass::SOLID);
+    }
+
+    BVH bvh(structure->atoms, options.atomSize.value);
+    bool bvhNeedsRefit = false;
+    bool atomPicked = false;
+    uint64_t pickedAtom = 0;
+
+    Visibility visibility;
+    bool hideDeemphasised = false;
+    bool visibilityChanged = false;
 
     Axes axes(camera);
     Cell cell
@@ -154,28 +220,49 @@ int main(int argv, char ** argc)
         }
 
         cameraControls(display, camera);
-        elementsNeedUpdate = atomControls
-        (
-            display,
-            structure->atoms,
-            emphasisControls,
-            elementMap,
-            alphaOverrides,
-            options.deemphasisAlpha.value
-        );
+        if (atomControls(display, offset, emphasisControls, emphasis))
+        {
+            atomRenderer.setEmphasis(emphasis);
+            bondRenderer.setEmphasis(emphasis);
+            visibilityChanged = hideDeemphasised;
+        }
+
+        if (display.keyHasEvent(GLFW_KEY_V, jGL::EventType::PRESS))
+        {
+            hideDeemphasised = !hideDeemphasised;
+            visibilityChanged = true;
+        }
+
+        if (display.keyHasEvent(GLFW_KEY_DELETE, jGL::EventType::PRESS) && atomPicked)
+        {
+            visibility.hideAtom(pickedAtom);
+            atomPicked = false;
+            visibilityChanged = true;
+        }
+
+        if (display.keyHasEvent(GLFW_KEY_BACKSPACE, jGL::EventType::PRESS))
+        {
+            visibility.showAtoms();
+            visibilityChanged = true;
+        }
+
+        if (visibilityChanged)
+        {
+            for (Element e : elements) { visibility.hide(e, hideDeemphasised && !emphasis.isEmphasised(e)); }
+            atomRenderer.setVisibility(visibility);
+            bondRenderer.setVisibility(visibility);
+        }
 
         if (display.keyHasEvent(GLFW_KEY_SPACE, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_SPACE, jGL::EventType::HOLD))
         {
-            center(structure->atoms);
+            offset = glm::vec3(0);
             camera.reset(structure->atoms);
-            elementsNeedUpdate = true;
         }
 
         if (display.keyHasEvent(GLFW_KEY_F, jGL::EventType::PRESS) || display.keyHasEvent(GLFW_KEY_F, jGL::EventType::HOLD))
         {
             if (!readInProgress)
             {
-                com = getCenter(structure->atoms);
                 structure->readFrame(structure->framePosition());
                 readInProgress = true;
             }
@@ -185,7 +272,6 @@ int main(int argv, char ** argc)
         {
             if (!readInProgress)
             {
-                com = getCenter(structure->atoms);
                 uint64_t f = structure->framePosition();
                 if (f > 2) { f -= 2; }
                 else { f = structure->frameCount()-2+f;}
@@ -198,7 +284,6 @@ int main(int argv, char ** argc)
         {
             if (!readInProgress)
             {
-                com = getCenter(structure->atoms);
                 structure->readFrame(0);
                 readInProgress = true;
             }
@@ -223,30 +308,81 @@ int main(int argv, char ** argc)
         {
             // Previous threaded read is done.
             readInProgress = false;
-            center(structure->atoms);
-            translate(structure->atoms, com);
-            if (options.bondCutoff.value > 0.0)
+            if (bricked == nullptr)
+            {
+                centre = getCenter(structure->atoms);
+                if (!gpuBonds) { bondList.update(structure->atoms); }
+                cell.setVectors(structure->getCellA(), structure->getCellB(), structure->getCellC());
+                elementsNeedUpdate = true;
+            }
+            else if (bricked->applyPage())
             {
-                bonds = determineBonds(structure->atoms, options.bondCutoff.value);
+                // Atom indices now refer to other atoms.
+                visibility.showAtoms();
+                atomRenderer.setVisibility(visibility);
+                bondRenderer.setVisibility(visibility);
+                atomPicked = false;
+                elementsNeedUpdate = true;
             }
-            setAlpha(structure->atoms, alphaOverrides);
-            cell.setVectors(structure->getCellA(), structure->getCellB(), structure->getCellC());
-            elementsNeedUpdate = true;
         }
 
+        if (bricked != nullptr && !readInProgress)
+        {
+            // Page bricks for the view, in the Atoms' frame, while drawing.
+            const glm::mat4 toAtoms = glm::translate(glm::mat4(1.0f), offset-centre);
+            bricked->page(Frustum(camera.getPV()*toAtoms), camera.position()-(offset-centre));
+            readInProgress = true;
+        }
+
+        if (elementsNeedUpdate) { bvhNeedsRefit = true; }
+
+        if (!options.hideAtoms.value && display.keyHasEvent(GLFW_MOUSE_BUTTON_LEFT, jGL::EventType::PRESS))
+        {
+            // Bounds are only refit when a pick needs them.
+            if (bvhNeedsRefit) { bvh.refit(structure->atoms); bvhNeedsRefit = false; }
+            double mouseX, mouseY;
+            display.mousePosition(mouseX, mouseY);
+            glm::vec3 origin, direction;
+            camera.screenRay(mouseX, mouseY, origin, direction);
+            // Into the Atoms' frame, undoing the model matrix.
+            origin -= offset-centre;
+            float distance;
+            atomPicked = bvh.raycast(structure->atoms, origin, direction, pickedAtom, distance, &visibility);
+        }
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), offset-centre);
+        atomRenderer.setModel(model);
+        bondRenderer.setModel(model);
         atomRenderer.updateCamera(camera);
         bondRenderer.updateCamera(camera);
 
-        if (!options.hideAtoms.value)
+        if (!options.hideAtoms.value && elementsNeedUpdate) { atomRenderer.updateAtoms(structure->atoms); }
+
+        // Bonds dropped by a full instance buffer are found again once it grows.
+        if (elementsNeedUpdate || visibilityChanged || (gpuBonds && bondRenderer.gpuBondsDropped()))
         {
-            if (elementsNeedUpdate) { atomRenderer.updateAtoms(structure->atoms); }
-            atomRenderer.draw(!options.meshes.value);
+            if (gpuBonds) { bondRenderer.updateOnGPU(structure->atoms, options.bondCutoff.value); }
+            else { bondRenderer.update(bonds, structure->atoms); }
         }
 
-        if (elementsNeedUpdate) { bondRenderer.update(bonds, structure->atoms); }
+        if (!options.hideAtoms.value) { atomRenderer.draw(!meshes); }
         bondRenderer.draw();
 
+        if (oit)
+        {
+            // Opaque fragments are drawn, now accumulate translucent ones.
+            oit->begin();
+            atomRenderer.setTransparencyPass(TransparencyPass::WEIGHTED);
+            bondRenderer.setTransparencyPass(TransparencyPass::WEIGHTED);
+            if (!options.hideAtoms.value) { atomRenderer.draw(!meshes); }
+            bondRenderer.draw();
+            atomRenderer.setTransparencyPass(TransparencyPass::SOLID);
+            bondRenderer.setTransparencyPass(TransparencyPass::SOLID);
+            oit->end();
+        }
+
         elementsNeedUpdate = false;
+        visibilityChanged = false;
 
         std::stringstream debugText;
 
@@ -266,7 +402,28 @@ int main(int argv, char ** argc)
                       << "\nDelta: " << fixedLengthNumber(delta,6) << " ms"
                       << " (FPS: " << fixedLengthNumber(1.0/(delta*1e-3),4)
                       << ")\n"
-                      << "Atoms/Triangles: " << structure->atoms.size() << "/" << atomRenderer.triangles(true)+bondRenderer.triangles() << "\n";
+                      << "Atoms/Triangles: " << atomRenderer.visibleCount() << "/" << atomRenderer.triangles(!meshes)+bondRenderer.triangles() << "\n";
+
+            double samples = double(resX)*double(resY)*std::max(options.msaa.value, uint8_t(1));
+            debugText << "Atom overdraw: " << fixedLengthNumber(overdraw.samples()/samples, 4) << "\n";
+
+            if (bricked != nullptr)
+            {
+                debugText << "Bricks: " << bricked->getShown().size()
+                          << " drawn, " << fixedLengthNumber(bricked->bytes()/(1024.0*1024.0), 6)
+                          << "/" << fixedLengthNumber(options.memoryBudget.value, 6) << " MB"
+                          << ", atoms " << structure->atomCount() << "/" << bricked->frameAtomCount() << "\n";
+            }
+
+            if (atomPicked && pickedAtom < structure->atoms.size())
+            {
+                Atom atom = structure->atoms[pickedAtom];
+                atom.position += offset-centre;
+                debugText << "Selected: " << structure->fileIndex(pickedAtom) << " " << STRING_FROM_ELEMENT.at(atom.symbol)
+                          << " at " << fixedLengthNumber(atom.position.x, 6)
+                          << ", " << fixedLengthNumber(atom.position.y, 6)
+                          << ", " << fixedLengthNumber(atom.position.z, 6) << "\n";
+            }
 
             jGLInstance->text(
                 debugText.str(),
@@ -285,12 +442,12 @@ int main(int argv, char ** argc)
         if (options.showCell.value)
         {
             cell.setProjectionView(camera.getPV());
+            cell.setModel(glm::translate(glm::mat4(1.0f), offset));
             cell.draw();
         }
 
         if (!readInProgress && options.play.value)
         {
-            com = getCenter(structure->atoms);
             structure->readFrame(structure->framePosition());
             readInProgress = true;
         }
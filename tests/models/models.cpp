@@ -30,10 +30,12 @@ int main(int argv, char ** argc)
     jGLInstance->setTextProjection(glm::ortho(0.0,double(resX),0.0,double(resY)));
     jGLInstance->setMSAA(MSAA);
 
+    if (!checkGPUBonds()) { return 1; }
+
     float d = 1.75f;
 
-    std::vector<Atom> atoms;
-    std::vector<Atom> impostorAtoms;
+    AtomStore atoms;
+    AtomStore impostorAtoms;
     int col = 0;
     int row = 0;
     for (int i = 0; i < count; i++)
@@ -46,11 +48,8 @@ int main(int argv, char ** argc)
 
     center(atoms);
     center(impostorAtoms);
-    for (int i = 0; i < count; i++)
-    {
-        atoms[i].position -= vec3<float>(-d*cols*0.75,0.0,0.0);
-        impostorAtoms[i].position += vec3<float>(-d*cols*0.75,0.0,0.0);
-    }
+    translate(atoms, -vec3<float>(-d*cols*0.75,0.0,0.0));
+    translate(impostorAtoms, vec3<float>(-d*cols*0.75,0.0,0.0));
 
     glm::vec3 cameraPositionSpherical = glm::vec3(1*count, M_PI*0.5f, M_PI);
 
@@ -70,6 +69,7 @@ int main(int argv, char ** argc)
 
     AtomRenderer renderer(atoms, 8, spherical2cartesian(cameraPositionSpherical));
     AtomRenderer impostorRenderer(impostorAtoms, 0, spherical2cartesian(cameraPositionSpherical));
+    renderer.waitForMeshes();
     renderer.setView(view);
     renderer.setProjection(projection);
     renderer.setLighting
@@ -15,6 +15,8 @@
 
 #include <atom.h>
 #include <atomRenderer.h>
+#include <bondRenderer.h>
+#include <bond.h>
 #include <util.h>
 
 
@@ -29,4 +31,50 @@ const int cols = 4;
 
 std::unique_ptr<jGL::jGLInstance> jGLInstance;
 
+/**
+ * @brief Check bonds found on the GPU against determineBonds.
+ *
+ * @remark A cubic lattice bonded to its first and second neighbours has
+ * about 9 bonds per Atom, more than the first detection has room for, so
+ * detection must grow and run again, @see BondRenderer::gpuBondsDropped.
+ * @return true if the bond counts match, or compute shaders are unavailable.
+ * @return false otherwise.
+ */
+bool checkGPUBonds()
+{
+    if (!computeShadersAvailable()) { return true; }
+    const uint64_t side = 12;
+    const float cutOff = 1.5f;
+    AtomStore lattice;
+    lattice.resize(side*side*side);
+    uint64_t i = 0;
+    for (uint64_t x = 0; x < side; x++)
+    {
+        for (uint64_t y = 0; y < side; y++)
+        {
+            for (uint64_t z = 0; z < side; z++)
+            {
+                lattice.setPosition(i, glm::vec3(x, y, z));
+                lattice.setElement(i, Element::C);
+                i++;
+            }
+        }
+    }
+    const uint64_t expected = determineBonds(lattice, cutOff).size();
+
+    BondRenderer renderer({}, lattice, 0);
+    renderer.updateOnGPU(lattice, cutOff);
+    for (uint8_t detections = 0; detections < 8; detections++)
+    {
+        glFinish();
+        if (!renderer.gpuBondsDropped()) { break; }
+        renderer.updateOnGPU(lattice, cutOff);
+    }
+    glFinish();
+    renderer.gpuBondsDropped();
+    const uint64_t found = renderer.triangles()/2;
+    std::cout << "GPU bonds: " << found << "/" << expected << "\n";
+    return found == expected;
+}
+
 #endif /* MODELS_H */
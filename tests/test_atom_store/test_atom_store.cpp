@@ -0,0 +1,122 @@
+#include <atom.h>
+
+void checkVec3(glm::vec3 actual, glm::vec3 exected, double tol);
+
+SCENARIO("AtomStore columns")
+{
+    GIVEN("An AtomStore of 3 Atoms")
+    {
+        AtomStore atoms =
+        {
+            {Element::H, {1.0f, 2.0f, 3.0f}, 0.5f, {1.0f, 0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 1.0f}},
+            {Element::O, {-1.0f, 0.0f, 1.0f}, 1.0f, {0.0f, 1.0f, 0.0f, 0.5f}},
+            {Element::H, {3.0f, 4.0f, 5.0f}, 0.5f, {0.0f, 0.0f, 1.0f, 1.0f}}
+        };
+        THEN("The columns hold the Atoms and velocity and force are not stored")
+        {
+            REQUIRE(atoms.size() == 3);
+            REQUIRE(atoms.getX() == std::vector<float>({1.0f, -1.0f, 3.0f}));
+            REQUIRE(atoms.getY() == std::vector<float>({2.0f, 0.0f, 4.0f}));
+            REQUIRE(atoms.getZ() == std::vector<float>({3.0f, 1.0f, 5.0f}));
+            REQUIRE(atoms[1].symbol == Element::O);
+            REQUIRE(atoms[1].scale == ELEMENT_RADIUS.at(Element::O));
+            REQUIRE(atoms[2].colour == CPK_COLOURS.at(Element::H));
+            REQUIRE(atoms.getAlphas() == std::vector<uint8_t>({255, 128, 255}));
+            REQUIRE(atoms.colour(1).a == Approx(128.0f/255.0f));
+            REQUIRE(!atoms.hasVelocities());
+            REQUIRE(!atoms.hasForces());
+            checkVec3(atoms[0].velocity, glm::vec3(0.0f), 1e-6);
+            REQUIRE(uniqueElements(atoms) == std::set<Element>({Element::H, Element::O}));
+            REQUIRE(elementIndices(atoms).count(Element::H) == 2);
+        }
+        WHEN("A velocity column is added and an Atom set")
+        {
+            atoms.addVelocities();
+            atoms.set(0, Atom(Element::C, {0.0f, 0.0f, 0.0f}, 0.7f, {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}));
+            THEN("The velocity is kept but the force is not")
+            {
+                REQUIRE(atoms.hasVelocities());
+                REQUIRE(atoms[0].symbol == Element::C);
+                checkVec3(atoms[0].velocity, glm::vec3(1.0f, 2.0f, 3.0f), 1e-6);
+                checkVec3(atoms[0].force, glm::vec3(0.0f), 1e-6);
+                checkVec3(atoms[1].velocity, glm::vec3(0.0f), 1e-6);
+            }
+        }
+        WHEN("The Palette is changed")
+        {
+            Palette palette;
+            palette.setColour(Element::O, {0.1f, 0.2f, 0.3f, 1.0f});
+            palette.setRadius(Element::H, 2.0f);
+            atoms.setPalette(palette);
+            THEN("Colours and scales follow the Palette and alphas are kept")
+            {
+                REQUIRE(atoms.scale(0) == 2.0f);
+                REQUIRE(atoms.scale(1) == ELEMENT_RADIUS.at(Element::O));
+                REQUIRE(atoms.colour(1).r == 0.1f);
+                REQUIRE(atoms.colour(1).a == Approx(128.0f/255.0f));
+            }
+        }
+        WHEN("A property column is added and the Atoms are resized")
+        {
+            atoms.addProperty("charge")[2] = -1.0f;
+            atoms.resize(4);
+            THEN("The property column is resized")
+            {
+                REQUIRE(atoms.hasProperty("charge"));
+                REQUIRE(!atoms.hasProperty("mass"));
+                REQUIRE(atoms.getProperty("charge") == std::vector<float>({0.0f, 0.0f, -1.0f, 0.0f}));
+                REQUIRE(atoms[3].symbol == Element::Unknown);
+            }
+        }
+        WHEN("The Atoms are centered")
+        {
+            center(atoms);
+            THEN("The centre is the origin and the extent is unchanged")
+            {
+                checkVec3(getCenter(atoms), glm::vec3(0.0f), 1e-6);
+                checkVec3(extent(atoms), glm::vec3(4.0f), 1e-6);
+                checkVec3(atoms.position(0), glm::vec3(0.0f), 1e-6);
+            }
+        }
+        WHEN("The Atoms are permuted")
+        {
+            atoms.addProperty("charge") = {0.0f, 1.0f, 2.0f};
+            atoms.permute({2, 0, 1});
+            THEN("Every column follows the order")
+            {
+                checkVec3(atoms.position(0), glm::vec3(3.0f, 4.0f, 5.0f), 1e-6);
+                REQUIRE(atoms.element(2) == Element::O);
+                REQUIRE(atoms.getAlphas()[2] == 128);
+                REQUIRE(atoms.getProperty("charge") == std::vector<float>({2.0f, 0.0f, 1.0f}));
+            }
+        }
+    }
+}
+
+SCENARIO("Parallel centre of mass")
+{
+    GIVEN("An AtomStore of 100003 Atoms")
+    {
+        AtomStore atoms;
+        atoms.resize(100003);
+        glm::dvec3 sum(0.0);
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            glm::vec3 r(float(i % 17), float(i % 101)*0.5f, -float(i % 7));
+            atoms.setPosition(i, r);
+            sum += glm::dvec3(r);
+        }
+        THEN("The centre equals the serial mean")
+        {
+            checkVec3(getCenter(atoms), glm::vec3(sum/double(atoms.size())), 1e-5);
+        }
+        WHEN("The Atoms are emptied")
+        {
+            atoms.resize(0);
+            THEN("The centre is the origin")
+            {
+                checkVec3(getCenter(atoms), glm::vec3(0.0f), 1e-6);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include <bond.h>
+
+#include <random>
+
+AtomStore randomAtoms(uint64_t n, float length, std::mt19937 & rng)
+{
+    std::uniform_real_distribution<float> u(0.0f, length);
+    AtomStore atoms;
+    atoms.resize(n);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        atoms.setPosition(i, glm::vec3(u(rng), u(rng), u(rng)));
+    }
+    return atoms;
+}
+
+void jiggle(AtomStore & atoms, float amount, std::mt19937 & rng)
+{
+    std::uniform_real_distribution<float> u(-amount, amount);
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        atoms.setPosition(i, atoms.position(i)+glm::vec3(u(rng), u(rng), u(rng)));
+    }
+}
+
+bool sameBonds(const std::vector<Bond> & a, const std::vector<Bond> & b)
+{
+    if (a.size() != b.size()) { return false; }
+    for (uint64_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].atomIndexA != b[i].atomIndexA || a[i].atomIndexB != b[i].atomIndexB)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+SCENARIO("Incremental bond updates")
+{
+    std::mt19937 rng(31415);
+    GIVEN("512 random atoms in a 12 Angstrom box")
+    {
+        AtomStore atoms = randomAtoms(512, 12.0f, rng);
+        WHEN("Bonds are updated by a VerletBondList with cutoff 1.5 and skin 0.5")
+        {
+            VerletBondList bondList(1.5f, 0.5f);
+            bondList.update(atoms);
+            THEN("The bonds equal determineBonds")
+            {
+                REQUIRE(bondList.getBonds().size() > 0);
+                REQUIRE(sameBonds(bondList.getBonds(), determineBonds(atoms, 1.5f)));
+                REQUIRE(bondList.rebuildCount() == 1);
+                REQUIRE(bondList.candidateCount() >= bondList.getBonds().size());
+            }
+            AND_WHEN("The atoms move by less than half the skin")
+            {
+                jiggle(atoms, 0.1f, rng);
+                bondList.update(atoms);
+                THEN("No rebuild occurs and the bonds equal determineBonds")
+                {
+                    REQUIRE(bondList.rebuildCount() == 1);
+                    REQUIRE(sameBonds(bondList.getBonds(), determineBonds(atoms, 1.5f)));
+                }
+            }
+            AND_WHEN("The atoms move by more than half the skin")
+            {
+                jiggle(atoms, 1.0f, rng);
+                bondList.update(atoms);
+                THEN("A rebuild occurs and the bonds equal determineBonds")
+                {
+                    REQUIRE(bondList.rebuildCount() == 2);
+                    REQUIRE(sameBonds(bondList.getBonds(), determineBonds(atoms, 1.5f)));
+                }
+            }
+            AND_WHEN("The atom count changes")
+            {
+                atoms.resize(atoms.size()-1);
+                bondList.update(atoms);
+                THEN("A rebuild occurs and the bonds equal determineBonds")
+                {
+                    REQUIRE(bondList.rebuildCount() == 2);
+                    REQUIRE(sameBonds(bondList.getBonds(), determineBonds(atoms, 1.5f)));
+                }
+            }
+        }
+        WHEN("Bonds are updated by a VerletBondList with cutoff 0")
+        {
+            VerletBondList bondList(0.0f, 0.5f);
+            bondList.update(atoms);
+            THEN("There are no bonds")
+            {
+                REQUIRE(bondList.getBonds().size() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("SIMD distance kernels")
+{
+    std::mt19937 rng(27182);
+    GIVEN("1003 random points and a query point")
+    {
+        AtomStore atoms = randomAtoms(1003, 10.0f, rng);
+        const std::vector<float> & x = atoms.getX();
+        const std::vector<float> & y = atoms.getY();
+        const std::vector<float> & z = atoms.getZ();
+        glm::vec3 r(5.0f, 5.0f, 5.0f);
+        std::vector<uint32_t> expected(x.size()+DISTANCE_KERNEL_PADDING);
+        uint64_t n = squaredDistanceWithin(x.data(), y.data(), z.data(), x.size(), r, 9.0f, expected.data(), SIMD::SCALAR);
+        THEN("The scalar kernel finds some points")
+        {
+            REQUIRE(n > 0);
+            REQUIRE(n < x.size());
+        }
+        for (SIMD simd : {SIMD::SSE, SIMD::AVX2})
+        {
+            WHEN("The kernel is run with SIMD level " + std::to_string(int(simd)))
+            {
+                std::vector<uint32_t> actual(x.size()+DISTANCE_KERNEL_PADDING);
+                uint64_t m = squaredDistanceWithin(x.data(), y.data(), z.data(), x.size(), r, 9.0f, actual.data(), simd);
+                THEN("The indices equal the scalar kernel's")
+                {
+                    REQUIRE(m == n);
+                    for (uint64_t k = 0; k < n; k++)
+                    {
+                        REQUIRE(actual[k] == expected[k]);
+                    }
+                }
+            }
+        }
+    }
+}
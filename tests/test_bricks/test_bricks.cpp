@@ -0,0 +1,262 @@
+#include <bricks.h>
+#include <camera.h>
+
+#include <random>
+#include <filesystem>
+
+AtomStore randomAtoms(uint64_t n, float length, std::mt19937 & rng);
+std::string randomFileName();
+
+SCENARIO("Out of core bricks")
+{
+    std::mt19937 rng(1618);
+    GIVEN("5000 random Atoms partitioned into bricks of about 64")
+    {
+        AtomStore atoms = randomAtoms(5000, 40.0f, rng);
+        auto source = [&atoms](auto visit)
+        {
+            for (uint64_t i = 0; i < atoms.size(); i++)
+            {
+                glm::vec3 r = atoms.position(i);
+                visit(BrickAtom {r.x, r.y, r.z, uint32_t(atoms.element(i)), i});
+            }
+        };
+        std::filesystem::path path = randomFileName()+".bricks";
+        partitionBricks(source, path, 64);
+        BrickFile file(path);
+        const std::vector<Brick> & bricks = file.getBricks();
+        THEN("Every Atom is in one Brick, inside its bounds")
+        {
+            REQUIRE(file.atomCount() == atoms.size());
+            checkVec3(file.getCentre(), getCenter(atoms));
+            std::vector<uint64_t> seen(atoms.size(), 0);
+            std::vector<BrickAtom> read;
+            for (uint64_t b = 0; b < bricks.size(); b++)
+            {
+                file.read(b, read);
+                REQUIRE(read.size() == bricks[b].count);
+                for (const BrickAtom & a : read)
+                {
+                    REQUIRE(a.index < atoms.size());
+                    seen[a.index]++;
+                    glm::vec3 r(a.x, a.y, a.z);
+                    REQUIRE(r == atoms.position(a.index));
+                    REQUIRE(Element(a.element) == atoms.element(a.index));
+                    REQUIRE(glm::all(glm::greaterThanEqual(r, bricks[b].min)));
+                    REQUIRE(glm::all(glm::lessThanEqual(r, bricks[b].max)));
+                }
+            }
+            for (uint64_t s : seen) { REQUIRE(s == 1); }
+        }
+        WHEN("Bricks are paged within a budget of a fifth of the frame")
+        {
+            const uint64_t budget = atoms.size()*sizeof(BrickAtom)/5;
+            BrickCache cache(file, budget);
+            Camera camera(glm::vec3(60.0f, M_PI*0.5f, 0.0f), 400, 300);
+            const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-20.0f));
+            const Frustum frustum(camera.getPV()*model);
+            const glm::vec3 eye = camera.position()+glm::vec3(20.0f);
+            REQUIRE(cache.page(frustum, eye, 0.0f, bricks.size()));
+            THEN("The drawn Bricks are within budget, in view and nearest first")
+            {
+                REQUIRE(cache.bytes() <= budget);
+                REQUIRE(!cache.getDrawn().empty());
+                float last = 0.0f;
+                for (uint64_t b : cache.getDrawn())
+                {
+                    REQUIRE(cache.resident(b));
+                    REQUIRE(frustum.intersects(bricks[b].centre(), bricks[b].radius()));
+                    float distance = std::max(glm::length(bricks[b].centre()-eye)-bricks[b].radius(), 0.0f);
+                    REQUIRE(distance >= last);
+                    last = distance;
+                }
+                AND_THEN("No nearer Brick in view is left out")
+                {
+                    for (uint64_t b = 0; b < bricks.size(); b++)
+                    {
+                        float distance = std::max(glm::length(bricks[b].centre()-eye)-bricks[b].radius(), 0.0f);
+                        if (distance < last && frustum.intersects(bricks[b].centre(), bricks[b].radius()))
+                        {
+                            REQUIRE(cache.resident(b));
+                        }
+                    }
+                }
+                AND_THEN("Paging the same view changes nothing")
+                {
+                    REQUIRE(!cache.page(frustum, eye, 0.0f, bricks.size()));
+                }
+            }
+            WHEN("The camera looks from the other side")
+            {
+                std::vector<uint64_t> before = cache.getDrawn();
+                Camera opposite(glm::vec3(60.0f, M_PI*0.5f, M_PI), 400, 300);
+                const Frustum turned(opposite.getPV()*model);
+                const glm::vec3 behind = opposite.position()+glm::vec3(20.0f);
+                THEN("Loads are limited per call, and Bricks are evicted to stay in budget")
+                {
+                    REQUIRE(cache.page(turned, behind, 0.0f, 1));
+                    REQUIRE(cache.bytes() <= budget);
+                    REQUIRE(cache.page(turned, behind, 0.0f, bricks.size()));
+                    REQUIRE(cache.bytes() <= budget);
+                    uint64_t evicted = 0;
+                    for (uint64_t b : before) { if (!cache.resident(b)) { evicted++; } }
+                    REQUIRE(evicted > 0);
+                }
+            }
+        }
+        WHEN("The budget fills with Bricks out of view")
+        {
+            const uint64_t budget = atoms.size()*sizeof(BrickAtom)/5;
+            BrickCache cache(file, budget);
+            // The Atoms are behind the Camera, away from the origin it faces.
+            Camera camera(glm::vec3(60.0f, M_PI*0.5f, 0.0f), 400, 300);
+            const glm::vec3 shift = 2.0f*camera.position()-glm::vec3(20.0f);
+            const Frustum frustum(camera.getPV()*glm::translate(glm::mat4(1.0f), shift));
+            const glm::vec3 eye = camera.position()-shift;
+            cache.page(frustum, eye, 0.0f, bricks.size());
+            THEN("None are drawn and they are loaded nearest first")
+            {
+                REQUIRE(cache.getDrawn().empty());
+                REQUIRE(cache.bytes() > 0);
+                REQUIRE(cache.bytes() <= budget);
+                std::vector<std::pair<float, uint64_t>> byDistance;
+                for (uint64_t b = 0; b < bricks.size(); b++)
+                {
+                    REQUIRE(!frustum.intersects(bricks[b].centre(), bricks[b].radius()));
+                    byDistance.push_back({std::max(glm::length(bricks[b].centre()-eye)-bricks[b].radius(), 0.0f), b});
+                }
+                std::sort(byDistance.begin(), byDistance.end());
+                // A nearer Brick is only passed over if it did not fit.
+                uint64_t remaining = budget;
+                for (const auto & d : byDistance)
+                {
+                    const uint64_t bytes = bricks[d.second].bytes();
+                    if (cache.resident(d.second)) { remaining -= bytes; }
+                    else { REQUIRE(bytes > remaining); }
+                }
+            }
+        }
+        std::filesystem::remove(path);
+    }
+    GIVEN("An XYZ file of 300 Atoms")
+    {
+        AtomStore atoms = randomAtoms(300, 10.0f, rng);
+        std::filesystem::path path = randomFileName()+".xyz";
+        {
+            std::ofstream out(path);
+            out << atoms.size() << "\ncomment\n";
+            for (uint64_t i = 0; i < atoms.size(); i++)
+            {
+                out << (i % 2 == 0 ? "C" : "O") << " "
+                    << atoms.position(i).x << " "
+                    << atoms.position(i).y << " "
+                    << atoms.position(i).z << "\n";
+            }
+        }
+        std::filesystem::path bricksPath = path;
+        bricksPath += ".bricks";
+        WHEN("A BrickedStructure reads it with a budget for every Atom")
+        {
+            BrickedStructure structure(path, 300*BrickedStructure::DRAWN_ATOM_BYTES, 0.0f, 16, true);
+            structure.readFrame(0);
+            THEN("The bricks are written and every Atom is read once")
+            {
+                REQUIRE(std::filesystem::exists(bricksPath));
+                REQUIRE(structure.frameReadComplete());
+                REQUIRE(structure.frameAtomCount() == 300);
+                REQUIRE(structure.atomCount() == 300);
+                REQUIRE(structure.bytes() <= 300*BrickedStructure::DRAWN_ATOM_BYTES);
+                std::vector<uint64_t> seen(atoms.size(), 0);
+                for (uint64_t i = 0; i < structure.atomCount(); i++)
+                {
+                    const uint64_t f = structure.fileIndex(i);
+                    seen[f]++;
+                    checkVec3(structure.atoms.position(i), atoms.position(f));
+                    REQUIRE(structure.atoms.element(i) == (f % 2 == 0 ? Element::C : Element::O));
+                }
+                for (uint64_t s : seen) { REQUIRE(s == 1); }
+            }
+        }
+        WHEN("A BrickedStructure reads it with a budget for a third")
+        {
+            BrickedStructure structure(path, 100*BrickedStructure::DRAWN_ATOM_BYTES, 0.0f, 16, true);
+            structure.readFrame(0);
+            THEN("At most a third of the Atoms are read")
+            {
+                REQUIRE(structure.atomCount() > 0);
+                REQUIRE(structure.atomCount() <= 100);
+                REQUIRE(structure.capacity() == 100);
+                REQUIRE(structure.bytes() <= 100*BrickedStructure::DRAWN_ATOM_BYTES);
+            }
+        }
+        WHEN("A BrickedStructure with bonds is paged from around the Atoms")
+        {
+            const float cutOff = 1.5f;
+            BrickedStructure structure(path, 150*BrickedStructure::DRAWN_ATOM_BYTES, cutOff, 16, true);
+            structure.readFrame(0);
+            const glm::mat4 model = glm::translate(glm::mat4(1.0f), -structure.centre());
+            THEN("atoms are the shown Bricks, bonded as if found afresh, in every view")
+            {
+                uint64_t changes = 0;
+                for (float phi : {0.0f, float(M_PI*0.5), float(M_PI), float(M_PI*1.5), 0.0f})
+                {
+                    Camera camera(glm::vec3(20.0f, M_PI*0.5f, phi), 400, 300);
+                    structure.page(Frustum(camera.getPV()*model), camera.position()+structure.centre(), 1 << 10);
+                    REQUIRE(structure.frameReadComplete());
+                    if (structure.applyPage()) { changes++; }
+                    REQUIRE(structure.bytes() <= 150*BrickedStructure::DRAWN_ATOM_BYTES);
+
+                    std::vector<uint64_t> expected;
+                    for (uint64_t b : structure.getShown())
+                    {
+                        for (const BrickAtom & a : structure.getCache().atoms(b)) { expected.push_back(a.index); }
+                    }
+                    std::vector<uint64_t> read;
+                    for (uint64_t i = 0; i < structure.atomCount(); i++)
+                    {
+                        const uint64_t f = structure.fileIndex(i);
+                        read.push_back(f);
+                        checkVec3(structure.atoms.position(i), atoms.position(f));
+                    }
+                    std::sort(expected.begin(), expected.end());
+                    std::sort(read.begin(), read.end());
+                    REQUIRE(read == expected);
+
+                    auto pairs = [&structure](const std::vector<Bond> & bonds)
+                    {
+                        std::vector<std::pair<uint64_t, uint64_t>> p;
+                        for (const Bond & bond : bonds)
+                        {
+                            const uint64_t a = structure.fileIndex(bond.atomIndexA);
+                            const uint64_t b = structure.fileIndex(bond.atomIndexB);
+                            p.push_back({std::min(a, b), std::max(a, b)});
+                        }
+                        std::sort(p.begin(), p.end());
+                        return p;
+                    };
+                    REQUIRE(!structure.getBonds().empty());
+                    REQUIRE(pairs(structure.getBonds()) == pairs(determineBonds(structure.atoms, cutOff)));
+                }
+                REQUIRE(changes > 1);
+            }
+        }
+        std::filesystem::remove(path);
+        std::filesystem::remove(bricksPath);
+    }
+    GIVEN("A file that is not [EXT]XYZ")
+    {
+        std::filesystem::path path = randomFileName()+".cif";
+        {
+            std::ofstream out(path);
+            out << "data_test\n";
+        }
+        std::filesystem::path bricksPath = path;
+        bricksPath += ".bricks";
+        THEN("A BrickedStructure is not made and no bricks are written")
+        {
+            REQUIRE_THROWS_AS(BrickedStructure(path, 1024), std::runtime_error);
+            REQUIRE(!std::filesystem::exists(bricksPath));
+        }
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,134 @@
+#include <bvh.h>
+#include <camera.h>
+
+#include <random>
+
+AtomStore randomAtoms(uint64_t n, float length, std::mt19937 & rng);
+void jiggle(AtomStore & atoms, float amount, std::mt19937 & rng);
+void checkVec3(glm::vec3 actual, glm::vec3 exected, double tol);
+
+bool bruteRaycast
+(
+    const AtomStore & atoms,
+    glm::vec3 origin,
+    glm::vec3 direction,
+    float radiusScale,
+    uint64_t & index
+)
+{
+    float best = std::numeric_limits<float>::max();
+    bool hit = false;
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        glm::vec3 oc = origin-atoms.position(i);
+        float radius = atoms.scale(i)*radiusScale;
+        float b = glm::dot(oc, direction);
+        float c = glm::dot(oc, oc)-radius*radius;
+        float discriminant = b*b-c;
+        if (discriminant < 0.0f) { continue; }
+        float s = -b-std::sqrt(discriminant);
+        if (s < 0.0f) { s = -b+std::sqrt(discriminant); }
+        if (s >= 0.0f && s < best) { best = s; index = i; hit = true; }
+    }
+    return hit;
+}
+
+uint64_t bruteNearest(const AtomStore & atoms, glm::vec3 point)
+{
+    uint64_t index = 0;
+    float best = std::numeric_limits<float>::max();
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        glm::vec3 r = atoms.position(i)-point;
+        if (glm::dot(r, r) < best) { best = glm::dot(r, r); index = i; }
+    }
+    return index;
+}
+
+void checkQueries(const BVH & bvh, const AtomStore & atoms, float radiusScale, std::mt19937 & rng)
+{
+    std::uniform_real_distribution<float> u(-5.0f, 25.0f);
+    uint64_t hits = 0;
+    for (uint64_t q = 0; q < 64; q++)
+    {
+        glm::vec3 origin(u(rng), u(rng), -10.0f);
+        glm::vec3 direction = glm::normalize(glm::vec3(u(rng), u(rng), 40.0f)-origin);
+        uint64_t expected = 0, actual = 0;
+        float t;
+        bool expectedHit = bruteRaycast(atoms, origin, direction, radiusScale, expected);
+        REQUIRE(bvh.raycast(atoms, origin, direction, actual, t) == expectedHit);
+        if (expectedHit) { REQUIRE(actual == expected); hits++; }
+
+        glm::vec3 point(u(rng), u(rng), u(rng));
+        REQUIRE(bvh.nearest(atoms, point, actual));
+        REQUIRE(actual == bruteNearest(atoms, point));
+
+        std::vector<uint64_t> found = bvh.within(atoms, point, 2.0f);
+        std::sort(found.begin(), found.end());
+        std::vector<uint64_t> expectedWithin;
+        for (uint64_t i = 0; i < atoms.size(); i++)
+        {
+            if (glm::length(atoms.position(i)-point) <= 2.0f) { expectedWithin.push_back(i); }
+        }
+        REQUIRE(found == expectedWithin);
+    }
+    REQUIRE(hits > 0);
+}
+
+SCENARIO("BVH queries")
+{
+    std::mt19937 rng(16180);
+    GIVEN("2000 random atoms in a 20 Angstrom box")
+    {
+        AtomStore atoms = randomAtoms(2000, 20.0f, rng);
+        std::uniform_real_distribution<float> scale(0.1f, 0.5f);
+        std::uniform_int_distribution<uint8_t> element(0, ELEMENT_COUNT-1);
+        Palette palette;
+        for (uint16_t e = 0; e < ELEMENT_COUNT; e++) { palette.setRadius(Element(e), scale(rng)); }
+        atoms.setPalette(palette);
+        for (uint64_t i = 0; i < atoms.size(); i++) { atoms.setElement(i, Element(element(rng))); }
+        WHEN("A BVH is built")
+        {
+            BVH bvh(atoms, 1.0f);
+            THEN("There are 2*leaves-1 nodes and queries match a linear scan")
+            {
+                REQUIRE(bvh.size() == atoms.size());
+                REQUIRE(bvh.getNodes().size() % 2 == 1);
+                checkQueries(bvh, atoms, 1.0f, rng);
+            }
+            AND_WHEN("The atoms move and the BVH is refit")
+            {
+                jiggle(atoms, 1.0f, rng);
+                bvh.refit(atoms);
+                THEN("Queries match a linear scan")
+                {
+                    checkQueries(bvh, atoms, 1.0f, rng);
+                }
+            }
+            AND_WHEN("An atom is removed and the BVH is refit")
+            {
+                atoms.resize(atoms.size()-1);
+                bvh.refit(atoms);
+                THEN("The BVH is rebuilt and queries match a linear scan")
+                {
+                    REQUIRE(bvh.size() == atoms.size());
+                    checkQueries(bvh, atoms, 1.0f, rng);
+                }
+            }
+        }
+    }
+    GIVEN("A camera looking at the origin")
+    {
+        Camera camera(glm::vec3(10.0f, M_PI*0.5f, M_PI), 800, 600);
+        WHEN("The ray through the screen centre is found")
+        {
+            glm::vec3 origin, direction;
+            camera.screenRay(400.0, 300.0, origin, direction);
+            THEN("It points from the camera to the origin")
+            {
+                checkVec3(direction, -glm::normalize(camera.position()), 1e-3);
+                checkVec3(glm::normalize(origin), glm::normalize(camera.position()), 1e-3);
+            }
+        }
+    }
+}
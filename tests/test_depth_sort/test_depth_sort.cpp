@@ -0,0 +1,110 @@
+#include <depthSort.h>
+
+#include <random>
+#include <numeric>
+
+bool sortedBy(const std::vector<uint64_t> & order, const std::vector<float> & distances, bool decreasing)
+{
+    for (uint64_t k = 1; k < order.size(); k++)
+    {
+        float a = distances[order[k-1]], b = distances[order[k]];
+        if (decreasing ? a < b : a > b) { return false; }
+    }
+    return true;
+}
+
+bool permutation(std::vector<uint64_t> order)
+{
+    std::sort(order.begin(), order.end());
+    for (uint64_t k = 0; k < order.size(); k++) { if (order[k] != k) { return false; } }
+    return true;
+}
+
+SCENARIO("Sortable float keys")
+{
+    GIVEN("Floats of both signs")
+    {
+        const std::vector<float> fs = {-1e30f, -2.5f, -1.0f, -0.0f, 0.0f, 1e-30f, 1.0f, 2.5f, 1e30f};
+        THEN("The keys order as the floats")
+        {
+            for (uint64_t i = 1; i < fs.size(); i++)
+            {
+                REQUIRE(sortableKey(fs[i-1]) <= sortableKey(fs[i]));
+                if (fs[i-1] < fs[i]) { REQUIRE(sortableKey(fs[i-1]) < sortableKey(fs[i])); }
+            }
+        }
+    }
+}
+
+SCENARIO("Parallel depth sorting")
+{
+    std::mt19937 rng(2718);
+    std::uniform_real_distribution<float> u(0.0f, 100.0f);
+    GIVEN("100000 random distances")
+    {
+        std::vector<float> distances(100000);
+        for (float & d : distances) { d = u(rng); }
+        DepthSort sort;
+        WHEN("Sorted front to back")
+        {
+            const std::vector<uint64_t> & order = sort.sort(distances, DepthOrder::FRONT_TO_BACK);
+            THEN("The distances increase")
+            {
+                REQUIRE(!sort.wasIncremental());
+                REQUIRE(permutation(order));
+                REQUIRE(sortedBy(order, distances, false));
+            }
+            AND_WHEN("The distances change a little and are sorted again")
+            {
+                std::normal_distribution<float> jiggle(0.0f, 1e-5f);
+                for (float & d : distances) { d += jiggle(rng); }
+                sort.sort(distances, DepthOrder::FRONT_TO_BACK);
+                THEN("The last order is reused and the distances increase")
+                {
+                    REQUIRE(sort.wasIncremental());
+                    REQUIRE(permutation(sort.getOrder()));
+                    REQUIRE(sortedBy(sort.getOrder(), distances, false));
+                }
+            }
+            AND_WHEN("The distances are shuffled and sorted again")
+            {
+                std::shuffle(distances.begin(), distances.end(), rng);
+                sort.sort(distances, DepthOrder::FRONT_TO_BACK);
+                THEN("The indices are radix sorted and the distances increase")
+                {
+                    REQUIRE(!sort.wasIncremental());
+                    REQUIRE(permutation(sort.getOrder()));
+                    REQUIRE(sortedBy(sort.getOrder(), distances, false));
+                }
+            }
+            AND_WHEN("Sorted back to front")
+            {
+                sort.sort(distances, DepthOrder::BACK_TO_FRONT);
+                THEN("The distances decrease")
+                {
+                    REQUIRE(!sort.wasIncremental());
+                    REQUIRE(permutation(sort.getOrder()));
+                    REQUIRE(sortedBy(sort.getOrder(), distances, true));
+                }
+            }
+        }
+    }
+    GIVEN("Distances with many ties")
+    {
+        std::vector<float> distances(50000);
+        for (uint64_t i = 0; i < distances.size(); i++) { distances[i] = float(i % 7); }
+        WHEN("Sorted back to front")
+        {
+            DepthSort sort;
+            const std::vector<uint64_t> & order = sort.sort(distances, DepthOrder::BACK_TO_FRONT);
+            THEN("Tied indices keep their order")
+            {
+                REQUIRE(sortedBy(order, distances, true));
+                for (uint64_t k = 1; k < order.size(); k++)
+                {
+                    if (distances[order[k-1]] == distances[order[k]]) { REQUIRE(order[k-1] < order[k]); }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include <dirtyRange.h>
+
+#include <random>
+
+SCENARIO("Dirty ranges")
+{
+    GIVEN("An empty DirtyRange")
+    {
+        DirtyRange range;
+        THEN("It is empty with empty bytes")
+        {
+            REQUIRE(range.empty());
+            ByteRange bytes = range.bytes(64, 12);
+            REQUIRE(bytes.first == bytes.second);
+        }
+        WHEN("Indices 7 and 3 are marked")
+        {
+            range.mark(7);
+            range.mark(3);
+            THEN("The range spans 3 to 7")
+            {
+                REQUIRE(!range.empty());
+                REQUIRE(range.begin == 3);
+                REQUIRE(range.end == 8);
+                REQUIRE(range.bytes(64, 12) == ByteRange(64+3*12, 64+8*12));
+            }
+            AND_WHEN("It is cleared")
+            {
+                range.clear();
+                THEN("It is empty") { REQUIRE(range.empty()); }
+            }
+        }
+    }
+    GIVEN("Disjoint ranges")
+    {
+        std::vector<ByteRange> ranges;
+        mergeRange(ranges, {20, 30});
+        mergeRange(ranges, {0, 10});
+        mergeRange(ranges, {50, 60});
+        mergeRange(ranges, {40, 40});
+        THEN("They are kept sorted and empty ranges ignored")
+        {
+            REQUIRE(ranges == std::vector<ByteRange>{{0, 10}, {20, 30}, {50, 60}});
+        }
+        WHEN("A range touching and overlapping others is merged")
+        {
+            mergeRange(ranges, {10, 25});
+            THEN("They are coalesced")
+            {
+                REQUIRE(ranges == std::vector<ByteRange>{{0, 30}, {50, 60}});
+            }
+        }
+        WHEN("More ranges than the limit are merged")
+        {
+            mergeRange(ranges, {100, 110}, 3);
+            THEN("The hull is kept")
+            {
+                REQUIRE(ranges == std::vector<ByteRange>{{0, 110}});
+            }
+        }
+    }
+    GIVEN("Random ranges over 512 bytes")
+    {
+        std::mt19937 rng(2718);
+        std::uniform_int_distribution<uint64_t> u(0, 512);
+        std::vector<ByteRange> ranges;
+        std::vector<bool> covered(512, false);
+        for (uint64_t i = 0; i < 64; i++)
+        {
+            uint64_t a = u(rng), b = u(rng);
+            ByteRange range = {std::min(a, b), std::min(std::min(a, b)+16, std::max(a, b))};
+            mergeRange(ranges, range, 1024);
+            for (uint64_t k = range.first; k < range.second; k++) { covered[k] = true; }
+        }
+        THEN("The merged ranges are sorted, disjoint and cover exactly the bytes added")
+        {
+            for (uint64_t r = 1; r < ranges.size(); r++)
+            {
+                REQUIRE(ranges[r-1].second < ranges[r].first);
+            }
+            std::vector<bool> merged(512, false);
+            for (const ByteRange & range : ranges)
+            {
+                for (uint64_t k = range.first; k < range.second; k++) { merged[k] = true; }
+            }
+            REQUIRE(merged == covered);
+        }
+    }
+}
@@ -9,12 +9,12 @@ SCENARIO("Colourmap reading")
     {
         WHEN("It is read by coloursFromFile")
         {
-            std::map<Element, glm::vec4> cmap = coloursFromFile("CPK");
+            ElementTable<glm::vec4> cmap = coloursFromFile("CPK");
             THEN("The colours are all equal to CPK_COLOURS")
             {
-                for (const auto & ec : cmap)
+                for (uint16_t e = 0; e < ELEMENT_COUNT; e++)
                 {
-                    checkVec4(ec.second, CPK_COLOURS.at(ec.first));
+                    checkVec4(cmap.at(Element(e)), CPK_COLOURS.at(Element(e)));
                 }
             }
         }
@@ -25,14 +25,81 @@ SCENARIO("Colourmap reading")
         std::cout << file << "\n";
         WHEN("It is read by coloursFromFile")
         {
-            std::map<Element, glm::vec4> cmap = coloursFromFile(file);
+            ElementTable<glm::vec4> cmap = coloursFromFile(file);
             THEN("The colours are all equal to CPK_COLOURS")
             {
-                for (const auto & ec : cmap)
+                for (uint16_t e = 0; e < ELEMENT_COUNT; e++)
                 {
-                    checkVec4(ec.second, CPK_COLOURS.at(ec.first));
+                    checkVec4(cmap.at(Element(e)), CPK_COLOURS.at(Element(e)));
                 }
             }
         }
     }
 }
+
+SCENARIO("Element symbol decoding")
+{
+    GIVEN("Every Element's symbol")
+    {
+        THEN("Each decodes to its Element")
+        {
+            for (uint16_t e = 1; e < ELEMENT_COUNT; e++)
+            {
+                REQUIRE(stringSymbolToElement(STRING_FROM_ELEMENT.at(Element(e))) == Element(e));
+            }
+            static_assert(stringSymbolToElement("Na") == Element::Na);
+            static_assert(ELEMENT_RADIUS.at(Element::O) == 1.5f);
+        }
+    }
+    GIVEN("Strings that are not symbols")
+    {
+        THEN("They decode to Unknown")
+        {
+            for (std::string s : {"", "NA", "na", "Xx", "Hee", "1", "Unknown", "OW"})
+            {
+                REQUIRE(stringSymbolToElement(s) == Element::Unknown);
+            }
+        }
+    }
+    GIVEN("DL_POLY style atom labels")
+    {
+        THEN("The longest symbol prefix is used")
+        {
+            REQUIRE(labelToElement("OW") == Element::O);
+            REQUIRE(labelToElement("HW1") == Element::H);
+            REQUIRE(labelToElement("Na+") == Element::Na);
+            REQUIRE(labelToElement("Cl-") == Element::Cl);
+            REQUIRE(labelToElement("C12") == Element::C);
+            REQUIRE(labelToElement("1X") == Element::Unknown);
+        }
+        WHEN("They are resolved by a LabelCache")
+        {
+            LabelCache labels;
+            std::vector<Element> elements;
+            for (std::string s : {"OW", "HW1", "HW2", "OW", "Na", "HW1"})
+            {
+                elements.push_back(labels.element(s));
+            }
+            THEN("Labels are memoised and symbols are not")
+            {
+                REQUIRE(elements == std::vector<Element>({Element::O, Element::H, Element::H, Element::O, Element::Na, Element::H}));
+                REQUIRE(labels.size() == 3);
+            }
+        }
+        WHEN("Every Atom has its own label")
+        {
+            LabelCache labels;
+            bool carbon = true;
+            for (uint64_t i = 0; i < 2*LabelCache::MAX_LABELS; i++)
+            {
+                carbon = carbon && labels.element("C"+std::to_string(i)) == Element::C;
+            }
+            THEN("They resolve and the cache stays bounded")
+            {
+                REQUIRE(carbon);
+                REQUIRE(labels.size() == LabelCache::MAX_LABELS);
+                REQUIRE(labels.element("C1") == Element::C);
+            }
+        }
+    }
+}
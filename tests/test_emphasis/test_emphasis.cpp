@@ -0,0 +1,43 @@
+#include <emphasis.h>
+
+SCENARIO("Element emphasis mask")
+{
+    GIVEN("A default Emphasis with deemphasis alpha 0.5")
+    {
+        Emphasis emphasis(0.5f);
+        THEN("Every Element is emphasised")
+        {
+            for (uint16_t e = 0; e < ELEMENT_COUNT; e++)
+            {
+                REQUIRE(emphasis.isEmphasised(Element(e)));
+                REQUIRE(emphasis.alpha(Element(e)) == 1.0f);
+            }
+            for (uint32_t word : emphasis.getMask()) { REQUIRE(word == 0); }
+        }
+        WHEN("Elements in different words are toggled")
+        {
+            emphasis.toggle(Element::H);
+            emphasis.toggle(Element::Lw);
+            THEN("Only their bits are set")
+            {
+                REQUIRE(!emphasis.isEmphasised(Element::H));
+                REQUIRE(!emphasis.isEmphasised(Element::Lw));
+                REQUIRE(emphasis.isEmphasised(Element::O));
+                REQUIRE(emphasis.alpha(Element::H) == 0.5f);
+                const uint16_t lw = uint16_t(Element::Lw);
+                REQUIRE(emphasis.getMask()[lw/32] == uint32_t(1) << (lw%32));
+            }
+            AND_WHEN("They are toggled again")
+            {
+                emphasis.toggle(Element::H);
+                emphasis.set(Element::Lw, true);
+                THEN("They are emphasised")
+                {
+                    REQUIRE(emphasis.isEmphasised(Element::H));
+                    REQUIRE(emphasis.isEmphasised(Element::Lw));
+                    for (uint32_t word : emphasis.getMask()) { REQUIRE(word == 0); }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include <frustum.h>
+#include <camera.h>
+
+#include <random>
+
+SCENARIO("Frustum culling spheres")
+{
+    GIVEN("A default Frustum")
+    {
+        Frustum frustum;
+        THEN("Everything is inside")
+        {
+            REQUIRE(frustum.intersects(glm::vec3(0.0f), 0.0f));
+            REQUIRE(frustum.intersects(glm::vec3(1e6f, -1e6f, 1e6f), 0.0f));
+        }
+    }
+    GIVEN("A Camera 10 from the origin looking at it")
+    {
+        Camera camera(glm::vec3(10.0f, M_PI*0.5f, 0.0f), 400, 300);
+        const glm::mat4 pv = camera.getPV();
+        Frustum frustum(pv);
+        const glm::vec3 eye = camera.position();
+        const glm::vec3 forward = glm::normalize(-eye);
+        THEN("The focus is inside and points behind the Camera are outside")
+        {
+            REQUIRE(frustum.intersects(glm::vec3(0.0f), 0.0f));
+            REQUIRE(!frustum.intersects(eye-forward, 0.5f));
+            REQUIRE(!frustum.intersects(eye+forward*2000.0f, 1.0f));
+        }
+        THEN("Points are inside as their clip coordinates are")
+        {
+            std::mt19937 rng(31415);
+            std::uniform_real_distribution<float> u(-30.0f, 30.0f);
+            uint64_t inside = 0;
+            for (uint64_t k = 0; k < 10000; k++)
+            {
+                glm::vec3 p(u(rng), u(rng), u(rng));
+                glm::vec4 c = pv*glm::vec4(p, 1.0f);
+                float margin = std::min({c.w-std::abs(c.x), c.w-std::abs(c.y), c.w-std::abs(c.z)});
+                // Skip points too close to a plane to call.
+                if (std::abs(margin) < 1e-3f*std::abs(c.w)) { continue; }
+                REQUIRE(frustum.intersects(p, 0.0f) == (margin > 0.0f));
+                if (margin > 0.0f) { inside++; }
+            }
+            REQUIRE(inside > 0);
+        }
+        THEN("A sphere outside a plane is kept while it overlaps")
+        {
+            // Move right along the screen until the centre leaves the view.
+            const glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+            glm::vec3 centre(0.0f);
+            while (frustum.intersects(centre, 0.0f)) { centre += right*0.01f; }
+            REQUIRE(frustum.intersects(centre+right*0.5f, 1.0f));
+            REQUIRE(!frustum.intersects(centre+right*2.0f, 1.0f));
+        }
+    }
+    GIVEN("A Frustum with a model translation")
+    {
+        Camera camera(glm::vec3(10.0f, M_PI*0.5f, 0.0f), 400, 300);
+        const glm::vec3 shift(100.0f, 0.0f, 0.0f);
+        Frustum frustum(camera.getPV()*glm::translate(glm::mat4(1.0f), shift));
+        THEN("Model positions are tested where they are drawn")
+        {
+            REQUIRE(frustum.intersects(-shift, 0.0f));
+            REQUIRE(!frustum.intersects(glm::vec3(0.0f), 0.0f));
+        }
+    }
+}
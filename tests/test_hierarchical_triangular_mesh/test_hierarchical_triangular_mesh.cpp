@@ -0,0 +1,109 @@
+#include <hierarchicalTriangularMesh.h>
+#include <sphereMesh.h>
+
+SCENARIO("Indexed sphere meshes")
+{
+    for (BASE_MESH base : {BASE_MESH::TETRAHEDRON, BASE_MESH::OCTAHEDRON, BASE_MESH::ICOSAHEDRON})
+    {
+        for (uint8_t depth : {0, 1, 4})
+        {
+            std::stringstream name;
+            name << base << " refined " << int(depth) << " times";
+            GIVEN(name.str())
+            {
+                HierarchicalTriangularMesh<float> htm(base);
+                htm.build(depth);
+                std::vector<float> soup = htm.vertices();
+                WHEN("The mesh is welded and indexed")
+                {
+                    std::vector<float> vertices, normals;
+                    std::vector<uint32_t> indices;
+                    htm.indexed(vertices, normals, indices);
+                    THEN("Indexing the vertices reproduces the triangle soup")
+                    {
+                        REQUIRE(indices.size() == 3*htm.triangles());
+                        REQUIRE(indices.size()*3 == soup.size());
+                        for (uint64_t i = 0; i < indices.size(); i++)
+                        {
+                            REQUIRE(indices[i] < vertices.size()/3);
+                            for (uint8_t k = 0; k < 3; k++)
+                            {
+                                REQUIRE(std::abs(vertices[3*indices[i]+k]-soup[3*i+k]) == 0.0f);
+                            }
+                        }
+                    }
+                    THEN("Each vertex is stored once, as for a closed surface")
+                    {
+                        // Euler's formula, V-E+F = 2 with E = 3F/2.
+                        REQUIRE(vertices.size()/3 == htm.triangles()/2+2);
+                    }
+                    THEN("Normals are the unit vertex positions")
+                    {
+                        REQUIRE(normals.size() == vertices.size());
+                        for (uint64_t v = 0; v < vertices.size()/3; v++)
+                        {
+                            glm::vec3 r(vertices[3*v], vertices[3*v+1], vertices[3*v+2]);
+                            glm::vec3 n(normals[3*v], normals[3*v+1], normals[3*v+2]);
+                            checkVec3(n, glm::normalize(r), 1e-6);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Sphere mesh levels of detail")
+{
+    GIVEN("The levels of detail of any base mesh")
+    {
+        std::vector<SphereMeshLevel> levels = sphereMeshLevels(BASE_MESH::ANY);
+        THEN("There are 23 levels by increasing triangles")
+        {
+            REQUIRE(levels.size() == 23);
+            REQUIRE(levels.front().triangles == 4);
+            REQUIRE(levels.back().triangles == 20*4096);
+            for (uint8_t l = 1; l < levels.size(); l++)
+            {
+                REQUIRE(levels[l].triangles > levels[l-1].triangles);
+            }
+        }
+        WHEN("A level is requested twice")
+        {
+            auto a = requestSphereMesh(levels[10]);
+            auto b = requestSphereMesh(levels[10]);
+            THEN("The build is shared and has the level's triangles")
+            {
+                REQUIRE(a.get() == b.get());
+                REQUIRE(a.get()->indices.size() == 3*levels[10].triangles);
+            }
+        }
+    }
+    GIVEN("Every level of detail of any base mesh")
+    {
+        std::vector<SphereMeshLevel> levels = sphereMeshLevels(BASE_MESH::ANY);
+        THEN("Each built mesh has the triangles/2+2 vertices its atlas space reserves")
+        {
+            for (const SphereMeshLevel & level : levels)
+            {
+                std::shared_ptr<const SphereMesh> mesh = requestSphereMesh(level).get();
+                REQUIRE(mesh->vertices.size()/3 == level.triangles/2+2);
+                REQUIRE(mesh->indices.size() == 3*level.triangles);
+            }
+        }
+    }
+    GIVEN("The levels of detail of an icosahedron")
+    {
+        std::vector<SphereMeshLevel> levels = sphereMeshLevels(BASE_MESH::ICOSAHEDRON);
+        THEN("There are 7 refinements")
+        {
+            REQUIRE(levels.size() == 7);
+            for (uint8_t l = 0; l < levels.size(); l++)
+            {
+                REQUIRE(levels[l].base == BASE_MESH::ICOSAHEDRON);
+                REQUIRE(levels[l].depth == l);
+                REQUIRE(levels[l].triangles == 20*std::pow(4, l));
+            }
+        }
+    }
+}
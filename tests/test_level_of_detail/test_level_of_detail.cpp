@@ -0,0 +1,90 @@
+#include <levelOfDetail.h>
+
+#include <random>
+
+SCENARIO("Level of detail by projected radius")
+{
+    GIVEN("Meshes of 8, 32, 128, 512 and 2048 triangles")
+    {
+        LevelOfDetail lod({8, 32, 128, 512, 2048}, 16.0f, 4.0f);
+        THEN("The impostor bucket follows the finest mesh")
+        {
+            REQUIRE(lod.impostor() == 5);
+        }
+        THEN("Atoms under 4 pixels in radius are impostors")
+        {
+            REQUIRE(lod.level(0.0f, 4) == lod.impostor());
+            REQUIRE(lod.level(3.9f, 4) == lod.impostor());
+            REQUIRE(lod.level(std::nanf(""), 4) == lod.impostor());
+        }
+        THEN("Larger atoms use finer meshes, up to the maximum level")
+        {
+            REQUIRE(lod.level(4.0f, 4) == 0);
+            REQUIRE(lod.level(8.0f, 4) == 1);
+            REQUIRE(lod.level(16.0f, 4) == 2);
+            REQUIRE(lod.level(64.0f, 4) == 4);
+            REQUIRE(lod.level(64.0f, 2) == 2);
+            REQUIRE(lod.level(std::numeric_limits<float>::infinity(), 4) == 4);
+            uint8_t previous = 0;
+            for (float pixels = 4.0f; pixels < 100.0f; pixels += 0.5f)
+            {
+                uint8_t level = lod.level(pixels, 4);
+                REQUIRE(level >= previous);
+                previous = level;
+            }
+        }
+    }
+}
+
+SCENARIO("Parallel bucket sort")
+{
+    std::mt19937 rng(4242);
+    GIVEN("100000 random buckets")
+    {
+        LevelOfDetail lod({8, 32, 128});
+        std::uniform_int_distribution<int> u(0, lod.impostor());
+        std::vector<uint8_t> buckets(100000);
+        std::vector<uint64_t> counts(lod.impostor()+1, 0);
+        for (uint8_t & b : buckets) { b = u(rng); counts[b]++; }
+        WHEN("The indices are sorted by bucket")
+        {
+            std::vector<uint64_t> order, offsets;
+            lod.sort(buckets, order, offsets);
+            THEN("The offsets delimit each bucket")
+            {
+                REQUIRE(offsets.size() == counts.size()+1);
+                REQUIRE(offsets.front() == 0);
+                REQUIRE(offsets.back() == buckets.size());
+                for (uint8_t b = 0; b < counts.size(); b++)
+                {
+                    REQUIRE(offsets[b+1]-offsets[b] == counts[b]);
+                }
+            }
+            THEN("The order is a stable grouping of every index")
+            {
+                REQUIRE(order.size() == buckets.size());
+                std::vector<bool> seen(buckets.size(), false);
+                for (uint8_t b = 0; b < counts.size(); b++)
+                {
+                    for (uint64_t k = offsets[b]; k < offsets[b+1]; k++)
+                    {
+                        REQUIRE(buckets[order[k]] == b);
+                        if (k > offsets[b]) { REQUIRE(order[k] > order[k-1]); }
+                        seen[order[k]] = true;
+                    }
+                }
+                REQUIRE(std::all_of(seen.begin(), seen.end(), [](bool s) { return s; }));
+            }
+        }
+        WHEN("There are no indices")
+        {
+            std::vector<uint64_t> order, offsets;
+            lod.sort({}, order, offsets);
+            THEN("Every bucket is empty")
+            {
+                REQUIRE(order.empty());
+                REQUIRE(offsets == std::vector<uint64_t>(lod.impostor()+2, 0));
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include <morton.h>
+
+#include <random>
+
+uint64_t naiveMortonCode(uint64_t x, uint64_t y, uint64_t z)
+{
+    uint64_t code = 0;
+    for (uint64_t b = 0; b < 21; b++)
+    {
+        code |= ((x >> b) & 1) << (3*b);
+        code |= ((y >> b) & 1) << (3*b+1);
+        code |= ((z >> b) & 1) << (3*b+2);
+    }
+    return code;
+}
+
+SCENARIO("Morton ordering")
+{
+    GIVEN("Random 21 bit integers")
+    {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<uint64_t> u(0, (1 << 21)-1);
+        THEN("spreadBits interleaves as the naive bitwise code")
+        {
+            for (uint64_t i = 0; i < 1000; i++)
+            {
+                uint64_t x = u(rng), y = u(rng), z = u(rng);
+                REQUIRE((spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2) == naiveMortonCode(x, y, z));
+            }
+        }
+    }
+    GIVEN("The 8 corners of a cube, in reverse Morton order, and a duplicate")
+    {
+        AtomStore atoms;
+        for (int c = 7; c >= 0; c--)
+        {
+            atoms.push_back(Atom(glm::vec3(c & 1, (c >> 1) & 1, (c >> 2) & 1)));
+        }
+        atoms.push_back(Atom(glm::vec3(1.0f)));
+        WHEN("The atoms are Morton ordered")
+        {
+            std::vector<uint64_t> order = mortonOrder(atoms);
+            THEN("The order is the reverse, with the duplicate after its twin")
+            {
+                std::vector<uint64_t> expected = {7, 6, 5, 4, 3, 2, 1, 0, 8};
+                REQUIRE(order == expected);
+            }
+            AND_WHEN("The atoms are permuted")
+            {
+                AtomStore original = atoms;
+                atoms.permute(order);
+                THEN("atoms[i] is original[order[i]]")
+                {
+                    for (uint64_t i = 0; i < atoms.size(); i++)
+                    {
+                        REQUIRE(atoms.position(i) == original.position(order[i]));
+                    }
+                }
+            }
+        }
+    }
+}
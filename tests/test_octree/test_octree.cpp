@@ -0,0 +1,123 @@
+#include <octree.h>
+#include <camera.h>
+
+#include <random>
+
+AtomStore randomAtoms(uint64_t n, float length, std::mt19937 & rng);
+
+SCENARIO("Octree aggregates of Atoms")
+{
+    std::mt19937 rng(2718);
+    GIVEN("An Octree over 20000 random Atoms of H, O and C")
+    {
+        AtomStore atoms = randomAtoms(20000, 50.0f, rng);
+        const Element es[3] = {Element::H, Element::O, Element::O};
+        for (uint64_t i = 0; i < atoms.size(); i++) { atoms.setElement(i, es[i % 3]); }
+        Octree octree(atoms, 8);
+        const std::vector<OctreeNode> & nodes = octree.getNodes();
+        const OctreeNode & root = nodes[0];
+        THEN("Every Atom is in one leaf and nodes aggregate their Atoms")
+        {
+            std::vector<uint64_t> leaves(atoms.size(), 0);
+            for (const OctreeNode & node : nodes)
+            {
+                glm::vec3 mean(0.0f);
+                float spread = 0.0f;
+                for (uint64_t k = node.start; k < node.start+node.count; k++)
+                {
+                    const uint64_t i = octree.getOrder()[k];
+                    if (node.leaf()) { leaves[i]++; }
+                    mean += atoms.position(i)/float(node.count);
+                }
+                checkVec3(node.centre, mean, 1e-2);
+                for (uint64_t k = node.start; k < node.start+node.count; k++)
+                {
+                    spread = std::max(spread, glm::length(atoms.position(octree.getOrder()[k])-node.centre));
+                }
+                REQUIRE(node.spread >= spread-1e-3f);
+                if (!node.leaf())
+                {
+                    uint64_t count = 0;
+                    for (uint8_t c = 0; c < node.children; c++) { count += nodes[node.firstChild+c].count; }
+                    REQUIRE(count == node.count);
+                    REQUIRE(node.children > 1);
+                }
+            }
+            REQUIRE(std::all_of(leaves.begin(), leaves.end(), [](uint64_t l) { return l == 1; }));
+            REQUIRE(root.count == atoms.size());
+            REQUIRE(root.element == uint8_t(Element::O));
+            REQUIRE(root.alpha == 255);
+            REQUIRE(root.fusedRadius() <= root.bound());
+            REQUIRE(root.fusedRadius(2.0f) == 2.0f*root.fusedRadius());
+        }
+        WHEN("The Octree is cut with no Frustum")
+        {
+            std::vector<uint64_t> drawn, aggregates;
+            THEN("A cut at 0 pixels draws every Atom")
+            {
+                octree.select(Frustum(), glm::vec3(0.0f, 0.0f, 1000.0f), 500.0f, 0.0f, 1.0f, drawn, aggregates);
+                REQUIRE(aggregates.empty());
+                std::sort(drawn.begin(), drawn.end());
+                for (uint64_t i = 0; i < atoms.size(); i++) { REQUIRE(drawn[i] == i); }
+            }
+            THEN("A far cut draws only the root")
+            {
+                octree.select(Frustum(), glm::vec3(0.0f, 0.0f, 1e6f), 500.0f, 4.0f, 1.0f, drawn, aggregates);
+                REQUIRE(drawn.empty());
+                REQUIRE(aggregates == std::vector<uint64_t>{0});
+            }
+        }
+        WHEN("The Octree is cut from a Camera")
+        {
+            Camera camera(glm::vec3(300.0f, M_PI*0.4f, M_PI*0.3f), 512, 512);
+            Frustum frustum(camera.getPV());
+            const float pixelScale = camera.getProjection()[1][1]*256.0f;
+            std::vector<uint64_t> drawn, aggregates;
+            octree.select(frustum, camera.position(), pixelScale, 4.0f, 1.0f, drawn, aggregates);
+            THEN("Atoms in view are covered once, far regions by aggregates")
+            {
+                std::vector<uint64_t> covered(atoms.size(), 0);
+                for (uint64_t i : drawn) { covered[i]++; }
+                for (uint64_t n : aggregates)
+                {
+                    const OctreeNode & node = nodes[n];
+                    REQUIRE(node.count > 1);
+                    float distance = glm::length(node.centre-camera.position())-node.bound();
+                    REQUIRE(node.bound()*pixelScale <= 4.0f*distance);
+                    for (uint64_t k = node.start; k < node.start+node.count; k++) { covered[octree.getOrder()[k]]++; }
+                }
+                REQUIRE(!aggregates.empty());
+                REQUIRE(drawn.size()+aggregates.size() < atoms.size());
+                for (uint64_t i = 0; i < atoms.size(); i++)
+                {
+                    REQUIRE(covered[i] <= 1);
+                    if (frustum.intersects(atoms.position(i), atoms.scale(i))) { REQUIRE(covered[i] == 1); }
+                }
+            }
+        }
+    }
+    GIVEN("Atoms at one position")
+    {
+        AtomStore atoms = randomAtoms(100, 1.0f, rng);
+        for (uint64_t i = 0; i < atoms.size(); i++) { atoms.setPosition(i, glm::vec3(1.0f)); }
+        Octree octree(atoms, 4);
+        THEN("They are one leaf")
+        {
+            REQUIRE(octree.getNodes().size() == 1);
+            REQUIRE(octree.getNodes()[0].count == 100);
+            REQUIRE(octree.getNodes()[0].spread < 1e-5f);
+        }
+    }
+    GIVEN("No Atoms")
+    {
+        Octree octree(AtomStore(), 4);
+        std::vector<uint64_t> drawn = {1}, aggregates = {1};
+        octree.select(Frustum(), glm::vec3(0.0f), 1.0f, 1.0f, 1.0f, drawn, aggregates);
+        THEN("Nothing is drawn")
+        {
+            REQUIRE(octree.getNodes().empty());
+            REQUIRE(drawn.empty());
+            REQUIRE(aggregates.empty());
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#include <quantise.h>
+#include <camera.h>
+
+#include <random>
+
+/**
+ * @brief The largest screen space shift, in pixels, of quantised Atoms in view.
+ *
+ */
+double maxPixelError(const AtomStore & atoms, const Quantisation & q, const Camera & camera)
+{
+    double error = 0.0;
+    glm::mat4 pv = camera.getPV();
+    glm::vec2 res(camera.getResX(), camera.getResY());
+    for (uint64_t i = 0; i < atoms.size(); i++)
+    {
+        glm::vec4 exact = pv*glm::vec4(atoms.position(i), 1.0f);
+        glm::vec4 approx = pv*glm::vec4(q.dequantise(q.quantise(atoms.position(i))), 1.0f);
+        if (exact.w <= 0.0f) { continue; }
+        glm::vec2 ndc = glm::vec2(exact)/exact.w;
+        if (std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f) { continue; }
+        glm::vec2 shift = 0.5f*(ndc-glm::vec2(approx)/approx.w)*res;
+        error = std::max(error, double(glm::length(shift)));
+    }
+    return error;
+}
+
+SCENARIO("Compact position and colour quantisation")
+{
+    std::mt19937 rng(1618);
+    GIVEN("4096 random atoms in a centred 100 Angstrom box")
+    {
+        AtomStore atoms = randomAtoms(4096, 100.0f, rng);
+        center(atoms);
+        Quantisation q(atoms);
+        WHEN("Positions are quantised and dequantised")
+        {
+            THEN("Every position is within the maximum error")
+            {
+                REQUIRE(q.maxError() < 2e-3f);
+                for (uint64_t i = 0; i < atoms.size(); i++)
+                {
+                    glm::vec3 r = atoms.position(i);
+                    REQUIRE(glm::length(q.dequantise(q.quantise(r))-r) <= q.maxError()*1.001f);
+                }
+            }
+        }
+        WHEN("The atoms are viewed at 1920x1080 fitting the box to the screen")
+        {
+            Camera camera(atoms, 1920, 1080);
+            THEN("Quantised atoms move less than a pixel")
+            {
+                REQUIRE(maxPixelError(atoms, q, camera) < 0.5);
+            }
+            AND_WHEN("The camera zooms in to a quarter of the distance")
+            {
+                camera.zoom(-0.75f*camera.position(true).x);
+                THEN("Quantised atoms in view move less than a pixel")
+                {
+                    REQUIRE(maxPixelError(atoms, q, camera) < 0.5);
+                }
+            }
+        }
+        WHEN("The identity Quantisation is used")
+        {
+            Quantisation identity;
+            THEN("Positions in the unit box are recovered")
+            {
+                glm::vec3 r(0.25f, 0.5f, 0.75f);
+                checkVec3(identity.dequantise(identity.quantise(r)), r, 1e-4f);
+            }
+        }
+    }
+    GIVEN("A single atom")
+    {
+        AtomStore atoms;
+        atoms.push_back(Atom(Element::C, {1.0f, 2.0f, 3.0f}));
+        Quantisation q(atoms);
+        THEN("The degenerate box recovers its position")
+        {
+            checkVec3(q.dequantise(q.quantise(atoms.position(0))), atoms.position(0), 1e-6f);
+        }
+    }
+    GIVEN("Colours")
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        THEN("RGBA8 colours are within half a step")
+        {
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                glm::vec4 c(u(rng), u(rng), u(rng), u(rng));
+                checkVec4(glm::vec4(quantiseColour(c))/255.0f, c, 0.5f/255.0f+1e-6f);
+            }
+            REQUIRE(quantiseColour(glm::vec4(-1.0f, 2.0f, 0.0f, 1.0f)) == glm::u8vec4(0, 255, 0, 255));
+        }
+    }
+}
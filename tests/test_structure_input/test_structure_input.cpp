@@ -295,6 +295,28 @@ SCENARIO("HISTORY reading")
                     REQUIRE(history.framePosition() == 1);
                 }
             }
+            WHEN("The first frame is reordered and the second frame is read")
+            {
+                history.readFrame(0);
+                auto original = history.atoms;
+                history.reorder();
+                auto reordered = history.atoms;
+                history.readFrame(1);
+                auto second = history.atoms;
+                CONFIG unordered("HISTORY", true);
+                unordered.readFrame(1);
+                THEN("Each Atom is the same file atom in both frames")
+                {
+                    for (uint64_t i = 0; i < reordered.size(); i++)
+                    {
+                        uint64_t f = history.fileIndex(i);
+                        REQUIRE(reordered[i].symbol == original[f].symbol);
+                        checkVec3(reordered[i].position, original[f].position, 1e-6);
+                        REQUIRE(second[i].symbol == unordered.atoms[f].symbol);
+                        checkVec3(second[i].position, unordered.atoms[f].position, 1e-6);
+                    }
+                }
+            }
         }
     }
 }
\ No newline at end of file
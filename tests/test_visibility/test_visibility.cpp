@@ -0,0 +1,105 @@
+#include <visibility.h>
+#include <bvh.h>
+
+#include <random>
+
+AtomStore randomAtoms(uint64_t n, float length, std::mt19937 & rng);
+
+SCENARIO("Parallel stream compaction")
+{
+    GIVEN("100003 items kept if not a multiple of 3 or 7")
+    {
+        const uint64_t n = 100003;
+        auto keep = [](uint64_t i) { return i % 3 != 0 && i % 7 != 0; };
+        std::vector<uint64_t> expected;
+        for (uint64_t i = 0; i < n; i++) { if (keep(i)) { expected.push_back(i); } }
+        WHEN("The items are compacted")
+        {
+            std::vector<uint64_t> indices = {42};
+            parallelCompact(n, keep, indices);
+            THEN("The kept indices are found in order")
+            {
+                REQUIRE(indices == expected);
+            }
+        }
+        WHEN("No items are kept")
+        {
+            std::vector<uint64_t> indices = {42};
+            parallelCompact(n, [](uint64_t) { return false; }, indices);
+            THEN("There are no indices")
+            {
+                REQUIRE(indices.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Hiding Atoms by Element and selection")
+{
+    std::mt19937 rng(1618);
+    GIVEN("10000 random Atoms of H, O and C")
+    {
+        AtomStore atoms = randomAtoms(10000, 20.0f, rng);
+        const Element es[3] = {Element::H, Element::O, Element::C};
+        for (uint64_t i = 0; i < atoms.size(); i++) { atoms.setElement(i, es[i % 3]); }
+        Visibility visibility;
+        THEN("Every Atom is visible")
+        {
+            std::vector<uint64_t> indices;
+            visibility.visibleAtoms(atoms, indices);
+            REQUIRE(!visibility.hidesAny());
+            REQUIRE(indices.size() == atoms.size());
+        }
+        WHEN("H is hidden and Atoms 1 and 9999 are hidden")
+        {
+            visibility.hide(Element::H);
+            visibility.hideAtom(1);
+            visibility.hideAtom(9999);
+            std::vector<uint64_t> indices;
+            visibility.visibleAtoms(atoms, indices);
+            THEN("Only the other Atoms are visible")
+            {
+                REQUIRE(visibility.hidesAny());
+                REQUIRE(visibility.isHidden(Element::H));
+                REQUIRE(!visibility.isHidden(Element::O));
+                uint64_t expected = 0;
+                for (uint64_t i = 0; i < atoms.size(); i++)
+                {
+                    if (i % 3 != 0 && i != 1 && i != 9999) { expected++; }
+                }
+                REQUIRE(indices.size() == expected);
+                for (uint64_t i : indices)
+                {
+                    REQUIRE(atoms.element(i) != Element::H);
+                    REQUIRE(i != 1);
+                    REQUIRE(i != 9999);
+                }
+            }
+            AND_WHEN("Hidden Atoms are shown and H is shown")
+            {
+                visibility.showAtoms();
+                visibility.hide(Element::H, false);
+                THEN("Every Atom is visible")
+                {
+                    REQUIRE(!visibility.hidesAny());
+                }
+            }
+        }
+        WHEN("A ray is cast through a hidden Atom")
+        {
+            BVH bvh(atoms, 1.0f);
+            glm::vec3 origin = atoms.position(5)-glm::vec3(0.0f, 0.0f, 30.0f);
+            glm::vec3 direction(0.0f, 0.0f, 1.0f);
+            uint64_t index;
+            float t;
+            REQUIRE(bvh.raycast(atoms, origin, direction, index, t));
+            visibility.hideAtom(index);
+            uint64_t next;
+            bool hit = bvh.raycast(atoms, origin, direction, next, t, &visibility);
+            THEN("The hidden Atom is not hit")
+            {
+                REQUIRE((!hit || next != index));
+            }
+        }
+    }
+}
@@ -37,4 +37,18 @@ std::string randomFileName()
 }
 
 #include <test_structure_input/test_structure_input.cpp>
-#include <test_elements/test_elements.cpp>
\ No newline at end of file
+#include <test_elements/test_elements.cpp>
+#include <test_bonds/test_bonds.cpp>
+#include <test_bvh/test_bvh.cpp>
+#include <test_morton/test_morton.cpp>
+#include <test_atom_store/test_atom_store.cpp>
+#include <test_quantise/test_quantise.cpp>
+#include <test_level_of_detail/test_level_of_detail.cpp>
+#include <test_hierarchical_triangular_mesh/test_hierarchical_triangular_mesh.cpp>
+#include <test_dirty_range/test_dirty_range.cpp>
+#include <test_emphasis/test_emphasis.cpp>
+#include <test_visibility/test_visibility.cpp>
+#include <test_depth_sort/test_depth_sort.cpp>
+#include <test_frustum/test_frustum.cpp>
+#include <test_octree/test_octree.cpp>
+#include <test_bricks/test_bricks.cpp>
\ No newline at end of file